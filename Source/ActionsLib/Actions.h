@@ -51,6 +51,8 @@ void DoEval(const ConfigParameters& config);
 template <typename ElemType>
 void DoCrossValidate(const ConfigParameters& config);
 template <typename ElemType>
+void DoCompressModel(const ConfigParameters& config);
+template <typename ElemType>
 void DoWriteOutput(const ConfigParameters& config);
 
 // misc (OtherActions.cpp)
@@ -62,6 +64,8 @@ template <typename ElemType>
 void DoWriteWordAndClassInfo(const ConfigParameters& config);
 template <typename ElemType>
 void DoTopologyPlot(const ConfigParameters& config);
+template <typename ElemType>
+void DoExportMappableModel(const ConfigParameters& config);
 
 // special purpose (SpecialPurposeActions.cpp)
 template <typename ElemType>
@@ -17,6 +17,7 @@
 #include "Config.h"
 #include "SimpleEvaluator.h"
 #include "SimpleOutputWriter.h"
+#include "ParameterCompression.h"
 #include "Criterion.h"
 #include "BestGpu.h"
 #include "ScriptableObjects.h"
@@ -45,21 +46,28 @@ bool GetDistributedMBReadingDefaultValue(const ConfigParameters& config, const I
     return (MPIWrapper::GetInstance() != nullptr && !reader.IsLegacyReader());
 }
 
-// ===========================================================================
-// DoEvalBase() - implements CNTK "eval" command
-// ===========================================================================
+// reader configuration for evaluation: no randomization unless asked for
+static ConfigParameters GetEvalReaderConfig(const ConfigParameters& config)
+{
+    ConfigParameters readerConfig(config(L"reader"));
+    readerConfig.Insert("traceLevel", config(L"traceLevel", "0"));
+    if (!readerConfig.ExistsCurrent(L"randomize"))
+    {
+        readerConfig.Insert("randomize", "None");
+    }
+    return readerConfig;
+}
 
+// evaluate a network on the data of a reader, with the minibatch and tracing options of the "eval" command
 template <typename ElemType>
-static void DoEvalBase(const ConfigParameters& config, IDataReader& reader)
+static vector<EpochCriterion> EvaluateWithConfig(const ConfigParameters& config, IDataReader& reader, const ComputationNetworkPtr& net, const vector<wstring>& evalNodeNamesVector)
 {
-    //DEVICEID_TYPE deviceId = DeviceFromConfig(config);
     ConfigArray minibatchSize = config(L"minibatchSize", "40960");
     size_t epochSize = config(L"epochSize", "0");
     if (epochSize == 0)
     {
         epochSize = requestDataSize;
     }
-    wstring modelPath = config(L"modelPath");
     intargvector mbSize = minibatchSize;
 
     int traceLevel = config(L"traceLevel", 0);
@@ -70,10 +78,6 @@ static void DoEvalBase(const ConfigParameters& config, IDataReader& reader)
 
     bool enableDistributedMBReading = config(L"distributedMBReading", GetDistributedMBReadingDefaultValue(config, reader));
 
-    vector<wstring> evalNodeNamesVector;
-
-    let net = GetModelFromConfig<ConfigParameters, ElemType>(config, L"evalNodeNames", evalNodeNamesVector);
-
     // set tracing flags
     net->EnableNodeTracing(config(L"traceNodeNamesReal",     ConfigParameters::Array(stringargvector())),
                            config(L"traceNodeNamesCategory", ConfigParameters::Array(stringargvector())),
@@ -81,7 +85,21 @@ static void DoEvalBase(const ConfigParameters& config, IDataReader& reader)
 
     SimpleEvaluator<ElemType> eval(net, MPIWrapper::GetInstance(), enableDistributedMBReading, numMBsToShowResult, 
                                    firstMBsToShowResult, traceLevel, maxSamplesInRAM, numSubminiBatches);
-    eval.Evaluate(&reader, evalNodeNamesVector, mbSize[0], epochSize);
+    return eval.Evaluate(&reader, evalNodeNamesVector, mbSize[0], epochSize);
+}
+
+// ===========================================================================
+// DoEvalBase() - implements CNTK "eval" command
+// ===========================================================================
+
+template <typename ElemType>
+static void DoEvalBase(const ConfigParameters& config, IDataReader& reader)
+{
+    vector<wstring> evalNodeNamesVector;
+
+    let net = GetModelFromConfig<ConfigParameters, ElemType>(config, L"evalNodeNames", evalNodeNamesVector);
+
+    EvaluateWithConfig<ElemType>(config, reader, net, evalNodeNamesVector);
 }
 
 // ===========================================================================
@@ -147,14 +165,7 @@ template <typename ElemType>
 void DoEval(const ConfigParameters& config)
 {
     // test
-    ConfigParameters readerConfig(config(L"reader"));
-    readerConfig.Insert("traceLevel", config(L"traceLevel", "0"));
-    if (!readerConfig.ExistsCurrent(L"randomize"))
-    {
-        readerConfig.Insert("randomize", "None");
-    }
-
-    DataReader testDataReader(readerConfig);
+    DataReader testDataReader(GetEvalReaderConfig(config));
     DoEvalBase<ElemType>(config, testDataReader);
 }
 
@@ -275,6 +286,66 @@ void DoCrossValidate(const ConfigParameters& config)
 template void DoCrossValidate<float>(const ConfigParameters& config);
 template void DoCrossValidate<double>(const ConfigParameters& config);
 
+// ===========================================================================
+// DoCompressModel() - implements CNTK "compressModel" command
+// ===========================================================================
+
+// rewrite a model with lossy parameter compression (see ComputationNetwork::SaveCompressed())
+// If a reader is given, both the original and the compressed model are evaluated on its data, and the differences are reported.
+template <typename ElemType>
+void DoCompressModel(const ConfigParameters& config)
+{
+    wstring modelPath = config(L"modelPath");
+    wstring outputModelPath = config(L"outputModelPath");
+    wstring compressionName = config(L"parameterCompression", L"int8");
+    ParameterCompression compression = ParseParameterCompression(compressionName);
+
+    {
+        ComputationNetwork net(CPUDEVICE);
+        net.Load<ElemType>(modelPath);
+        net.SaveCompressed(outputModelPath, compression);
+    }
+    fprintf(stderr, "Compressed model %ls (%ls) written to %ls: %.1f%% of the original size.\n",
+            modelPath.c_str(), compressionName.c_str(), outputModelPath.c_str(),
+            100.0 * filesize64(outputModelPath.c_str()) / max(filesize64(modelPath.c_str()), (int64_t)1));
+
+    if (!config.Exists(L"reader"))
+        return;
+
+    // determine the accuracy delta on a validation set
+    DEVICEID_TYPE deviceId = DeviceFromConfig(config);
+    ConfigArray evalNodeNames = config(L"evalNodeNames", "");
+    vector<wstring> evalNodeNamesVector;
+    for (int i = 0; i < evalNodeNames.size(); ++i)
+    {
+        evalNodeNamesVector.push_back(evalNodeNames[i]);
+    }
+
+    DataReader validationDataReader(GetEvalReaderConfig(config));
+
+    const wstring modelPaths[2] = { modelPath, outputModelPath };
+    vector<EpochCriterion> evalErrors[2];
+    for (size_t k = 0; k < 2; k++)
+    {
+        auto net = ComputationNetwork::CreateFromFile<ElemType>(deviceId, modelPaths[k]);
+        fprintf(stderr, "Model %ls --> \n", modelPaths[k].c_str());
+        evalErrors[k] = EvaluateWithConfig<ElemType>(config, validationDataReader, net, evalNodeNamesVector);
+    }
+
+    fprintf(stderr, "Accuracy delta of compressed model:\n");
+    fprintf(stderr, "-----------------------------------\n");
+    for (size_t i = 0; i < evalErrors[0].size() && i < evalErrors[1].size(); i++)
+    {
+        double original = evalErrors[0][i].Average();
+        double compressed = evalErrors[1][i].Average();
+        fprintf(stderr, "Err[%d]: original = %.8g, compressed = %.8g, delta = %+.8g (%+.3f%% relative)\n",
+                (int)i, original, compressed, compressed - original, original != 0 ? 100.0 * (compressed - original) / fabs(original) : 0.0);
+    }
+}
+
+template void DoCompressModel<float>(const ConfigParameters& config);
+template void DoCompressModel<double>(const ConfigParameters& config);
+
 // ===========================================================================
 // DoWriteOutput() - implements CNTK "write" command
 // ===========================================================================
@@ -232,6 +232,25 @@ void NDLNodeEvaluatorImpl<ElemType>::Evaluate(NDLNode<ElemType>* node, const wst
             nodePtr = builder.RowRepeat(NULL, num_repeat, name);
         }
     }
+    else if (cnNodeType == OperationNameOf(ContextWindowNode))
+    {
+        if (parameter.size() != 3)
+            RuntimeError("ContextWindow should have three fixed parameters and one optional parameter. Usage: ContextWindow(origNodeName, leftContext, rightContext, [frameDim=0]).");
+
+        nodeParamCount = 1;
+        nodeParamStart = 0;
+
+        if (pass == ndlPassInitial)
+        {
+            // evaluate only scalar parameters
+            vector<void*> params = EvaluateParameters(node, baseName, 0, parameter.size(), pass);
+            size_t leftContext = ((NDLNode<ElemType>*) params[1])->GetScalar();
+            size_t rightContext = ((NDLNode<ElemType>*) params[2])->GetScalar();
+            size_t frameDim = node->GetOptionalParameter("frameDim", "0");
+
+            nodePtr = builder.ContextWindow(NULL, leftContext, rightContext, frameDim, name);
+        }
+    }
     else if (cnNodeType == OperationNameOf(DiagonalNode))
     {
         if (parameter.size() != 1)
@@ -203,6 +203,25 @@ void DoParameterSVD(const ConfigParameters& config)
 template void DoParameterSVD<float>(const ConfigParameters& config);
 template void DoParameterSVD<double>(const ConfigParameters& config);
 
+// ===========================================================================
+// DoExportMappableModel() - implements CNTK "exportMappable" command
+// ===========================================================================
+
+// rewrite a model in the memory-mappable format (see ComputationNetwork::SaveMappable())
+template <typename ElemType>
+void DoExportMappableModel(const ConfigParameters& config)
+{
+    wstring modelPath = config(L"modelPath");
+    wstring outputModelPath = config(L"outputModelPath");
+
+    ComputationNetwork net(CPUDEVICE);
+    net.Load<ElemType>(modelPath);
+    net.SaveMappable(outputModelPath);
+}
+
+template void DoExportMappableModel<float>(const ConfigParameters& config);
+template void DoExportMappableModel<double>(const ConfigParameters& config);
+
 // ===========================================================================
 // DoWriteWordAndClassInfo() - implements CNTK "writeWordAndClass" command
 // ===========================================================================
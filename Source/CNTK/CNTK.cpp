@@ -186,6 +186,18 @@ void DoCommands(const ConfigParameters& config, const shared_ptr<MPIWrapper>& mp
         }
     }
 
+    // number of threads that run independent nodes concurrently (CPU only)
+    ComputationNetwork::SetNumInterOpThreads(config(L"interOpThreads", (size_t)1));
+    if (ComputationNetwork::GetNumInterOpThreads() > 1)
+        LOGPRINTF(stderr, "Running independent nodes on %d inter-op threads.\n", (int)ComputationNetwork::GetNumInterOpThreads());
+    ComputationNetwork::SetShrinkRecurrentLoops(config(L"shrinkRecurrentLoops", false));
+    ComputationNetwork::SetCaptureRecurrentSteps(config(L"captureRecurrentSteps", false), config(L"maxCapturedGeometries", (size_t)64));
+    ComputationNetwork::SetRecomputeValues(config(L"recomputeValues", false), config(L"recomputeSegmentLength", (size_t)0));
+    ComputationNodeBase::SetCompressActivationStash(config(L"compressActivationStash", false));
+    ComputationNetwork::SetFuseElementwiseOps(config(L"fuseElementwiseOps", false));
+    ComputationNetwork::SetCacheStaticSubgraphs(config(L"cacheStaticSubgraphs", false));
+    ComputationNetwork::SetParallelParameterLoading(config(L"parallelModelLoading", true));
+
     bool progressTracing = config(L"progressTracing", false);
 
     // temporary hack to prevent users from failing due to a small breaking change related to the "truncated" flag (will be redone bigger and better some day)
@@ -330,6 +342,14 @@ void DoCommands(const ConfigParameters& config, const shared_ptr<MPIWrapper>& mp
                 {
                     DoParameterSVD<ElemType>(commandParams);
                 }
+                else if (thisAction == "exportMappable")
+                {
+                    DoExportMappableModel<ElemType>(commandParams);
+                }
+                else if (thisAction == "compressModel")
+                {
+                    DoCompressModel<ElemType>(commandParams);
+                }
                 else
                 {
                     RuntimeError("unknown action: %s  in command set: %s", thisAction.c_str(), command[i].c_str());
@@ -594,6 +614,17 @@ int wmainWithBS(int argc, wchar_t* argv[]) // called from wmain which is a wrapp
             LOGPRINTF(stderr, "Using %d CPU threads.\n", numCPUThreads);
     }
 
+    ComputationNetwork::SetNumInterOpThreads(config(L"interOpThreads", (size_t)1));
+    if (ComputationNetwork::GetNumInterOpThreads() > 1)
+        LOGPRINTF(stderr, "Running independent nodes on %d inter-op threads.\n", (int)ComputationNetwork::GetNumInterOpThreads());
+    ComputationNetwork::SetShrinkRecurrentLoops(config(L"shrinkRecurrentLoops", false));
+    ComputationNetwork::SetCaptureRecurrentSteps(config(L"captureRecurrentSteps", false), config(L"maxCapturedGeometries", (size_t)64));
+    ComputationNetwork::SetRecomputeValues(config(L"recomputeValues", false), config(L"recomputeSegmentLength", (size_t)0));
+    ComputationNodeBase::SetCompressActivationStash(config(L"compressActivationStash", false));
+    ComputationNetwork::SetFuseElementwiseOps(config(L"fuseElementwiseOps", false));
+    ComputationNetwork::SetCacheStaticSubgraphs(config(L"cacheStaticSubgraphs", false));
+    ComputationNetwork::SetParallelParameterLoading(config(L"parallelModelLoading", true));
+
     bool progressTracing = config(L"progressTracing", false);
     size_t fullTotalMaxEpochs = 1; // BUGBUG: BS does not allow me to read out the max epochs parameters, as that would instantiate and thus execute the objects
 
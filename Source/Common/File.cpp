@@ -24,6 +24,7 @@
 #ifdef __unix__
 #include <unistd.h>
 #include <linux/limits.h> // for PATH_MAX
+#include <fcntl.h>          // for posix_fadvise()
 #endif
 
 #define PCLOSE_ERROR -1
@@ -144,6 +145,19 @@ void File::Init(const wchar_t* filename, int fileOptions)
                     m_file = fopenOrDie(filename, options.c_str());
                     m_seekable = true;
                 });
+
+    // sequential access to a regular file: use a large stdio buffer, so that the many small reads and writes of
+    // serialization reach the OS as few large blocks, which matters on high-latency (e.g. network) file systems
+    if ((fileOptions & fileOptionsSequential) && m_seekable)
+    {
+        const size_t bufferSize = 4 * 1024 * 1024;
+        m_buffer.reset(new char[bufferSize]);
+        if (setvbuf(m_file, m_buffer.get(), _IOFBF, bufferSize) != 0)
+            RuntimeError("File: failed to set buffer for file %S", m_filename.c_str());
+#ifdef __unix__
+        posix_fadvise(fileno(m_file), 0, 0, POSIX_FADV_SEQUENTIAL); // (only a hint to read ahead more; failure is harmless)
+#endif
+    }
 }
 
 // determine the directory for a given pathname
@@ -281,6 +295,12 @@ void File::Flush()
     fflushOrDie(m_file);
 }
 
+void File::FlushToDisk()
+{
+    fflushOrDie(m_file);
+    fsyncOrDie(m_file);
+}
+
 // read a line
 // End of line is denoted by one of these, i.e. we don't support the old Mac OS convention of CR
 //  - LF
@@ -355,6 +355,31 @@ public:
     // resetRNN - flags whether to reset memory cells of RNN. 
     //
     virtual void ForwardPass(const ValueRefs<ElemType>& inputs, ValueRefs<ElemType>& output, bool resetRNN) = 0;
+
+    //
+    // ForwardPass - Evaluate a batch of independent sequences in a single forward pass. The sequences are packed
+    // side by side into one minibatch, so that the network runs on all of them at once.
+    // inputs - one entry per sequence, each holding a buffer for every input as given by GetInputSchema().
+    //          Sequences may differ in length.
+    // outputs - one entry per sequence, each holding a buffer for every output. Must be sized to fit output schema.
+    // resetRNN - one flag per sequence. If not set, sequence i continues the RNN state of sequence i of the
+    //            previous call.
+    //
+    virtual void ForwardPass(const std::vector<Values<ElemType>>& inputs, std::vector<Values<ElemType>>& outputs, const std::vector<bool>& resetRNN) = 0;
+
+    //
+    // Same as above, but takes references to static arrays instead of std::vector.
+    //
+    virtual void ForwardPass(const std::vector<ValueRefs<ElemType>>& inputs, std::vector<ValueRefs<ElemType>>& outputs, const std::vector<bool>& resetRNN) = 0;
+
+    //
+    // CloneSharingParameters - create another evaluator for the loaded model. The new instance shares the
+    // read-only parameter matrices with this one, but has its own activations and matrix pool, so that different
+    // instances can call ForwardPass() concurrently from different threads.
+    // StartForwardEvaluation() has to be called on the new instance, and it has to be freed with Destroy().
+    // The clone stays valid when this instance is destroyed.
+    //
+    virtual IEvaluateModelExtended<ElemType>* CloneSharingParameters() = 0;
 };
 
 template <typename ElemType>
@@ -362,4 +387,18 @@ void EVAL_API GetEvalExtended(IEvaluateModelExtended<ElemType>** peval);
 extern "C" EVAL_API void GetEvalExtendedF(IEvaluateModelExtended<float>** peval);
 extern "C" EVAL_API void GetEvalExtendedD(IEvaluateModelExtended<double>** peval);
 
+//
+// Batching evaluator: an IEvaluateModelExtended that can be called concurrently from many threads.
+// Single-sequence ForwardPass() calls are queued and coalesced into one batched forward pass, limited by
+// the following options of the Init() config:
+// maxBatchSize=32 (maximum number of requests evaluated together)
+// maxBatchDelay=1 (maximum time in milliseconds a request waits for other requests to join its batch)
+// Single-sequence requests must reset the RNN state, because a request does not own a parallel sequence
+// across calls. Queue latency and batch size histograms are printed to stderr by Destroy().
+//
+template <typename ElemType>
+void EVAL_API GetEvalExtendedBatching(IEvaluateModelExtended<ElemType>** peval);
+extern "C" EVAL_API void GetEvalExtendedBatchingF(IEvaluateModelExtended<float>** peval);
+extern "C" EVAL_API void GetEvalExtendedBatchingD(IEvaluateModelExtended<double>** peval);
+
 } } }
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <string>
 #include <vector>
+#include <memory>
 #include <stdint.h>
 #ifdef _WIN32
 #define NOMINMAX
@@ -33,7 +34,7 @@ enum FileOptions
     fileOptionsType = fileOptionsBinary | fileOptionsText,      // file types
     fileOptionsRead = 8,                                        // open in read mode
     fileOptionsWrite = 16,                                      // open in write mode
-    fileOptionsSequential = 32,                                 // optimize for sequential reads (allocates big buffer)
+    fileOptionsSequential = 32,                                 // optimize for sequential access (allocates big buffer, read-ahead hint)
     fileOptionsReadWrite = fileOptionsRead | fileOptionsWrite,  // read/write mode
 };
 
@@ -99,6 +100,7 @@ private:
     bool m_pcloseNeeded; // was opened with popen(), use pclose() when destructing
     bool m_seekable;     // this stream is seekable
     int m_options;       // FileOptions ored togther
+    std::unique_ptr<char[]> m_buffer; // large stdio buffer for fileOptionsSequential
     void Init(const wchar_t* filename, int fileOptions);
 
 public:
@@ -108,8 +110,10 @@ public:
     ~File();
 
     void Flush();
+    void FlushToDisk(); // Flush(), and wait until the data has reached the storage device
 
     bool CanSeek() const { return m_seekable; }
+    const std::wstring& GetFileName() const { return m_filename; }
     size_t Size();
     uint64_t GetPosition();
     void SetPosition(uint64_t pos);
@@ -171,6 +175,34 @@ public:
     File& PutMarker(FileMarker marker, const std::string& section);
     File& PutMarker(FileMarker marker, const std::wstring& section);
 
+    // bulk write of an array of basic types
+    // In binary mode, this is a single fwrite() without any per-element overhead. In text mode, it is the same as
+    // writing the elements one by one.
+    template <typename T>
+    void WriteArray(const T* data, size_t count)
+    {
+        if (IsTextBased())
+        {
+            for (size_t i = 0; i < count; i++)
+                *this << data[i];
+        }
+        else if (count > 0)
+            fwriteOrDie(data, sizeof(T), count, m_file);
+    }
+
+    // counterpart of WriteArray()
+    template <typename T>
+    void ReadArray(T* data, size_t count)
+    {
+        if (IsTextBased())
+        {
+            for (size_t i = 0; i < count; i++)
+                *this >> data[i];
+        }
+        else if (count > 0)
+            freadOrDie(data, sizeof(T), count, m_file);
+    }
+
     // put operator for vectors of types
     template <typename T>
     File& operator<<(const std::vector<T>& val)
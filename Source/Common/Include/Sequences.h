@@ -198,10 +198,12 @@ public:
     //  - width: maximum width of structure; set to maximum over sequence lengths
     //  - inputSequences: vector of input SequenceInfo records (only seqId and GetNumTimeSteps() are used)
     //  - placement, rowAllocations: temp buffers (passed in to be able to optimize memory allocations)
+    //  - sortRowsByLength: order the parallel sequences by decreasing length (see below)
     template<typename SequenceInfoVector>
     void InitAsPackedSequences(const SequenceInfoVector& inputSequences,
         /*temp buffer*/std::vector<std::pair<size_t, size_t>>& placement,
-        /*temp buffer*/std::vector<size_t> rowAllocations)
+        /*temp buffer*/std::vector<size_t> rowAllocations,
+        bool sortRowsByLength = false)
     {
         placement.resize(inputSequences.size()); // [sequence index] result goes here (entries are invalid for gaps)
         // determine width of MBLayout
@@ -234,6 +236,28 @@ public:
             // and allocate it
             rowAllocations[s] += len;
         }
+        // if requested, order the rows by decreasing length
+        // Gaps are only at the ends of the rows, so the rows that are still active at any time step are a prefix of all rows.
+        // This allows recurrent loops to compute over fewer parallel sequences as sequences end (see GetNumActiveParallelSequences()).
+        if (sortRowsByLength)
+        {
+            std::vector<size_t> rowOrder(rowAllocations.size()); // [new row] -> old row
+            for (size_t s = 0; s < rowOrder.size(); s++)
+                rowOrder[s] = s;
+            std::stable_sort(rowOrder.begin(), rowOrder.end(), [&](size_t a, size_t b) { return rowAllocations[a] > rowAllocations[b]; });
+            std::vector<size_t> newRow(rowOrder.size()); // [old row] -> new row
+            for (size_t s = 0; s < rowOrder.size(); s++)
+                newRow[rowOrder[s]] = s;
+            for (size_t i = 0; i < inputSequences.size(); i++)
+            {
+                if (inputSequences[i].seqId != GAP_SEQUENCE_ID)
+                    placement[i].first = newRow[placement[i].first];
+            }
+            std::vector<size_t> sortedRowAllocations(rowOrder.size());
+            for (size_t s = 0; s < rowOrder.size(); s++)
+                sortedRowAllocations[s] = rowAllocations[rowOrder[s]];
+            rowAllocations.swap(sortedRowAllocations);
+        }
         // create MBLayout
         Init(rowAllocations.size(), width);
         for (size_t i = 0; i < inputSequences.size(); i++)
@@ -300,6 +324,24 @@ public:
         return m_sequences;
     }
 
+    // for each time step, the number of parallel sequences up to and including the last one that is not a gap
+    // Computing a time step over only these sequences gives the same result for all non-gap frames.
+    // For layouts created by InitAsPackedSequences(), this is the number of sequences that are still active.
+    void GetNumActiveParallelSequences(std::vector<size_t>& numActive) const
+    {
+        CheckIsValid();
+        numActive.assign(m_numTimeSteps, 0);
+        for (const auto& seq : m_sequences)
+        {
+            if (seq.seqId == GAP_SEQUENCE_ID)
+                continue;
+            size_t tBegin = seq.tBegin < 0 ? 0 : (size_t)seq.tBegin;
+            size_t tEnd = std::min(seq.tEnd, m_numTimeSteps);
+            for (size_t t = tBegin; t < tEnd; t++)
+                numActive[t] = std::max(numActive[t], seq.s + 1);
+        }
+    }
+
     // compute the number of actual samples in this layout (not counting gaps)
     // This is used by MeanNode and InvStdDevNode, and by statistics reporting.
     size_t GetActualNumSamples() const;
@@ -630,6 +672,7 @@ public:                       // TODO: make private (currently used from masking
     ptrdiff_t m_timeOffset;   // this is added to timeIdxInSeq wherever it is used
     size_t m_timeRange;       // use this to describe a custom range > 1 frame
     size_t seqIndex;          // parallel-sequence index; SIZE_MAX = all sequences in MB (most common case)  --TODO: Bad name, 'sequence' and 'parallel sequence' are two different things
+    size_t m_seqPrefix;       // if seqIndex == SIZE_MAX: only the first this many parallel sequences; SIZE_MAX = all
     MBLayoutPtr m_pMBLayout;  // layout associated with this
     bool m_broadcastAllowed;  // frame range may be broadcast from outer layout (e.g. a matrix with NULL layout and 1 column is acceptable to this frame range). Only applies when iterating over time; otherwise broadcasting is always OK.
     const FrameRange *parent; // or NULL: parent range, relative to which this FrameRange is interpreted  --TODO: not used yet
@@ -637,7 +680,7 @@ public:                       // TODO: make private (currently used from masking
 public:
     // can construct from a single size_t -> a single-frame range
     FrameRange(MBLayoutPtr pMBLayout, size_t timeIdxInSeq)
-        : timeIdxInSeq(timeIdxInSeq), m_timeOffset(0), m_timeRange(1), seqIndex(SIZE_MAX), m_pMBLayout(pMBLayout), m_broadcastAllowed(false), parent(nullptr)
+        : timeIdxInSeq(timeIdxInSeq), m_timeOffset(0), m_timeRange(1), seqIndex(SIZE_MAX), m_seqPrefix(SIZE_MAX), m_pMBLayout(pMBLayout), m_broadcastAllowed(false), parent(nullptr)
     {
     }
 
@@ -671,6 +714,21 @@ public:
         return ret;
     }
 
+    // create a FrameRange that accesses only the first 'numSequences' parallel sequences
+    // FrameRange(t).WithSequencePrefix(n)
+    // For a single time step, these are consecutive columns. This is used to skip sequences that have ended (see MBLayout::GetNumActiveParallelSequences()).
+    FrameRange WithSequencePrefix(size_t numSequences) const
+    {
+        FrameRange ret = *this;
+        ret.m_seqPrefix = numSequences;
+        return ret;
+    }
+
+    bool HasSequencePrefix() const
+    {
+        return seqIndex == SIZE_MAX && m_seqPrefix != SIZE_MAX;
+    }
+
     // create a FrameRange with its MBLayout replaced by another
     // You must check yourself whether this is correct.
     FrameRange WithLayout(MBLayoutPtr pMBLayout) const
@@ -727,6 +785,8 @@ public:
     {
         if (!m_pMBLayout) return
             make_pair(0, 1);
+        else if (HasSequencePrefix()) return
+            make_pair(0, std::min(m_seqPrefix, m_pMBLayout->GetNumParallelSequences()));
         else if (seqIndex == SIZE_MAX) return
             make_pair(0, m_pMBLayout->GetNumParallelSequences());
         else return
@@ -749,7 +809,7 @@ public:
             true; // target has no layout: This would broadcast.
         else return
             (pMBLayout->GetNumTimeSteps()         == 1 || (!IsAllFrames() && m_timeRange == 1)) &&
-            (pMBLayout->GetNumParallelSequences() == 1 || seqIndex != SIZE_MAX);
+            (pMBLayout->GetNumParallelSequences() == 1 || seqIndex != SIZE_MAX || (HasSequencePrefix() && m_seqPrefix == 1));
     }
 
     // code that can only handle single-frame ranges will call t() to get the time index, which will throw if numFrames != 1
@@ -791,6 +851,15 @@ inline bool MBLayout::HasGaps(const FrameRange &fr) const
     CheckIsValid();
     if (fr.IsAllFrames())
         return m_numGapFrames > 0; // test entire minibatch
+    if (fr.HasSequencePrefix() && m_timeStepHasGap[fr.timeIdxInSeq]) // test the first sequences for one time step
+    {
+        for (size_t s = 0; s < fr.m_seqPrefix && s < m_numParallelSequences; s++)
+        {
+            if (IsGap(fr.Sequence(s)))
+                return true;
+        }
+        return false;
+    }
     if (fr.seqIndex == SIZE_MAX)
         return m_timeStepHasGap[fr.timeIdxInSeq]; // test all seq for one time step
     else
@@ -1034,7 +1103,13 @@ static inline std::pair<size_t, size_t> ColumnRangeWithMBLayoutFor(size_t numCol
         size_t startColumn = (fr.timeIdxInSeq + fr.m_timeOffset) * numParallelSequences;
         if (startColumn >= numCols)
             LogicError("DataFor: FrameRange specifies a time index that is out of range.");
-        if (fr.seqIndex == SIZE_MAX)
+        if (fr.HasSequencePrefix())
+        {
+            if (fr.m_timeRange != 1)
+                LogicError("DataFor: FrameRange only supports sequence prefixes for a single time step.");
+            return std::pair<size_t, size_t>(startColumn, std::min(fr.m_seqPrefix, numParallelSequences));
+        }
+        else if (fr.seqIndex == SIZE_MAX)
             return std::pair<size_t, size_t>(startColumn, numParallelSequences * fr.m_timeRange);
         else if (fr.m_timeRange != 1)
             LogicError("DataFor: FrameRange only support per-sequence time ranges with tensor slices, not matrix slices.");
@@ -1145,6 +1220,12 @@ static inline std::pair<DimensionVector, DimensionVector> TensorSliceWithMBLayou
             }
         }
     }
+    else if (fr.HasSequencePrefix() && pMBLayout) // first sequences requested?
+    {
+        size_t sequenceDim = shape.size() - 2;
+        if (result.second[sequenceDim] > 1 && fr.m_seqPrefix < result.second[sequenceDim])
+            result.second[sequenceDim] = (ElemType)fr.m_seqPrefix;
+    }
 
     return result;
 }
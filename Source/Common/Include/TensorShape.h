@@ -645,6 +645,16 @@ public:
         m_dims[k] = end - begin;
         return *this;
     }
+    // move the tensor by a number of elements within its storage object, done in-place
+    // E.g. a time-step slice of a minibatch tensor moves to the next time step by the stride of the time dimension.
+    TensorShape& MoveInPlace(ptrdiff_t numElements)
+    {
+        ptrdiff_t offset = (ptrdiff_t)m_offset + numElements;
+        if (offset < 0)
+            LogicError("MoveInPlace: Offset out of bounds.");
+        m_offset = (size_t)offset;
+        return *this;
+    }
     // narrow all dimensions to two given bounds vectors, done in-place
     template <class DimensionVector>
     TensorShape& NarrowTo(const std::pair<DimensionVector, DimensionVector>& bounds /*begin[], end[]*/)
@@ -136,6 +136,12 @@ void fprintfOrDie(FILE* f, const char* format, ...);
 
 void fflushOrDie(FILE* f);
 
+// ----------------------------------------------------------------------------
+// fsyncOrDie(): like fsync() but terminate with err msg in case of error
+// ----------------------------------------------------------------------------
+
+void fsyncOrDie(FILE* f);
+
 // ----------------------------------------------------------------------------
 // filesize(): determine size of the file in bytes
 // ----------------------------------------------------------------------------
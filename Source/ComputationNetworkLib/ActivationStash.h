@@ -0,0 +1,77 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// ActivationStash.h -- compact copies of what backprop needs from forward prop
+//
+// With ComputationNodeBase::SetCompressActivationStash(true), nodes whose gradient needs only part of the information
+// of a full-precision matrix keep that part in compact form from forward prop to backprop:
+//  - RectifiedLinear: 1 bit per element, whether the output is positive
+//  - Dropout: 1 bit per element, whether the element is kept
+//  - max Pooling: 1 byte per output element, the position of the maximum within the pooling window
+// The full-precision matrices are then not needed during backprop, and the MatrixPool reuses them after forward prop.
+// The gradients are the same as without the stash, bit for bit.
+//
+// The stash is computed on the CPU, so this applies to nodes on the CPU only.
+//
+#pragma once
+
+#include "Basics.h"
+#include <vector>
+#include <stdint.h>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// one bit per element of a matrix
+// Frames of a recurrent loop are stored at their element offset into the full matrix.
+class ActivationBitmask
+{
+public:
+    void Resize(size_t numElements)
+    {
+        m_words.resize((numElements + 63) / 64);
+    }
+
+    size_t SizeInBytes() const { return m_words.size() * sizeof(uint64_t); }
+
+    // bit [offset + i] := (values[i] != 0) or (values[i] > 0)
+    template <class ElemType>
+    void Set(size_t offset, const ElemType* values, size_t n, bool positiveOnly)
+    {
+        assert((offset + n + 63) / 64 <= m_words.size());
+        for (size_t i = 0; i < n; i++)
+        {
+            uint64_t bit = 1ull << ((offset + i) % 64);
+            uint64_t& word = m_words[(offset + i) / 64];
+            if (positiveOnly ? values[i] > 0 : values[i] != 0)
+                word |= bit;
+            else
+                word &= ~bit;
+        }
+    }
+
+    bool operator[](size_t i) const { return (m_words[i / 64] >> (i % 64)) & 1; }
+
+    // inputGradient[i] += (bit [offset + i] ? outputGradient[i] : 0)
+    template <class ElemType>
+    void AddMasked(size_t offset, const ElemType* outputGradient, ElemType* inputGradient, size_t n) const
+    {
+        assert((offset + n + 63) / 64 <= m_words.size());
+        for (size_t i = 0; i < n; i++)
+            inputGradient[i] += (*this)[offset + i] ? outputGradient[i] : 0;
+    }
+
+    // inputGradient[i] += outputGradient[i] * (bit [offset + i] ? scale : 0)
+    template <class ElemType>
+    void AddMaskedProduct(size_t offset, const ElemType* outputGradient, ElemType* inputGradient, size_t n, ElemType scale) const
+    {
+        assert((offset + n + 63) / 64 <= m_words.size());
+        for (size_t i = 0; i < n; i++)
+            inputGradient[i] += outputGradient[i] * ((*this)[offset + i] ? scale : 0);
+    }
+
+private:
+    std::vector<uint64_t> m_words;
+};
+
+}}}
@@ -0,0 +1,135 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// ColumnDelta.h -- serialization of only those matrix columns that changed since the matrix was last written
+//
+// This is used for delta checkpoints: e.g. for an embedding, a minibatch only updates the columns of the words it contains.
+//
+#pragma once
+
+#include "Basics.h"
+#include "File.h"
+#include "fileutil.h"
+#include "Matrix.h"
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdint.h>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// number of elements that are copied into CPU memory at a time while looking for changed columns
+static const size_t s_columnDeltaBlockSize = 1 << 20;
+
+// call f(j, column) for every column j of 'value', with the column copied into CPU memory
+// The matrix is copied a block of columns at a time, so that no full CPU copy of a large parameter is needed.
+template <class ElemType, class F>
+void ForEachColumnOnCPU(const Matrix<ElemType>& value, const F& f)
+{
+    const size_t numRows = value.GetNumRows();
+    const size_t numCols = value.GetNumCols();
+    if (numRows == 0)
+        return;
+    const size_t colsPerBlock = std::max(s_columnDeltaBlockSize / numRows, (size_t)1);
+    std::vector<ElemType> block;
+    for (size_t j0 = 0; j0 < numCols; j0 += colsPerBlock)
+    {
+        const size_t n = std::min(colsPerBlock, numCols - j0);
+        block.resize(n * numRows);
+        value.ColumnSlice(j0, n).CopySection(numRows, n, block.data(), numRows);
+        for (size_t j = 0; j < n; j++)
+            f(j0 + j, block.data() + j * numRows);
+    }
+}
+
+// 64-bit FNV-1a hash of the bytes of a column
+// A changed column is only missed if its hash collides with the old one, which has a probability of about 2^-64.
+template <class ElemType>
+uint64_t ColumnHash(const ElemType* column, size_t numRows)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(column);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < numRows * sizeof(ElemType); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+// record the current value as the reference for the next delta
+// Only a hash per column is kept, not a copy of the values.
+template <class ElemType>
+void SetColumnDeltaReference(const Matrix<ElemType>& value, std::vector<uint64_t>& columnHashes)
+{
+    const size_t numRows = value.GetNumRows();
+    columnHashes.assign(value.GetNumCols(), 0);
+    ForEachColumnOnCPU(value, [&](size_t j, const ElemType* column)
+    {
+        columnHashes[j] = ColumnHash(column, numRows);
+    });
+}
+
+// write the columns of 'value' that differ from the reference, and update the reference to the current value
+// 'columnHashes' holds the column hashes of the value as it was last written. If it is empty or of a different size, all columns are written.
+// Format: <element size> <rows> <cols> <number of changed columns> <column indices> <column values>
+template <class ElemType>
+void SaveColumnDelta(File& fstream, const Matrix<ElemType>& value, std::vector<uint64_t>& columnHashes)
+{
+    const size_t numRows = value.GetNumRows();
+    const size_t numCols = value.GetNumCols();
+    std::vector<uint64_t> current;
+    SetColumnDeltaReference(value, current);
+
+    std::vector<size_t> changedCols;
+    std::vector<bool> isChanged(numCols);
+    const bool haveReference = columnHashes.size() == current.size();
+    for (size_t j = 0; j < numCols; j++)
+    {
+        if (!haveReference || current[j] != columnHashes[j])
+        {
+            changedCols.push_back(j);
+            isChanged[j] = true;
+        }
+    }
+
+    fstream << sizeof(ElemType) << numRows << numCols << changedCols.size();
+    fstream.WriteArray(changedCols.data(), changedCols.size());
+    if (!changedCols.empty())
+    {
+        ForEachColumnOnCPU(value, [&](size_t j, const ElemType* column)
+        {
+            if (isChanged[j])
+                fstream.WriteArray(column, numRows);
+        });
+    }
+
+    columnHashes.swap(current);
+}
+
+// apply a delta written by SaveColumnDelta() to the value it was computed against
+template <class ElemType>
+void LoadColumnDelta(File& fstream, Matrix<ElemType>& value)
+{
+    size_t elemSize, numRows, numCols, numChangedCols;
+    fstream >> elemSize >> numRows >> numCols >> numChangedCols;
+    if (elemSize != sizeof(ElemType))
+        RuntimeError("LoadColumnDelta: Element size %d in file does not match the expected %d.", (int)elemSize, (int)sizeof(ElemType));
+    if (numRows != value.GetNumRows() || numCols != value.GetNumCols())
+        RuntimeError("LoadColumnDelta: Delta of dimensions [%d x %d] does not apply to a matrix of [%d x %d].",
+                     (int)numRows, (int)numCols, (int)value.GetNumRows(), (int)value.GetNumCols());
+    if (numChangedCols == 0)
+        return;
+
+    std::vector<size_t> changedCols(numChangedCols);
+    fstream.ReadArray(changedCols.data(), numChangedCols);
+    std::vector<ElemType> current(value.GetNumElements());
+    value.CopySection(numRows, numCols, current.data(), numRows);
+    for (auto j : changedCols)
+    {
+        if (j >= numCols)
+            RuntimeError("LoadColumnDelta: Column index %d out of range.", (int)j);
+        fstream.ReadArray(current.data() + j * numRows, numRows);
+    }
+    value.SetValue(numRows, numCols, value.GetDeviceId(), current.data());
+}
+
+}}}
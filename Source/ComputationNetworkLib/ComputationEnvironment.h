@@ -10,6 +10,8 @@
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
+class NodeProfiler;
+
 // ===========================================================================
 // ComputationEnvironment -- global network properties of interest to nodes
 // ===========================================================================
@@ -44,6 +46,9 @@ struct ComputationEnvironment
 
     // traceLevel
     int traceLevel = 0;
+
+    // if set, ForwardProp() and Backprop() time every node (see NodeProfiler.h)
+    std::shared_ptr<NodeProfiler> nodeProfiler;
     // more properties should be added here as needed
 };
 typedef std::shared_ptr<ComputationEnvironment> ComputationEnvironmentPtr;
@@ -21,11 +21,22 @@
 #include "SpecialPurposeNodes.h"
 #include "DeprecatedNodes.h" // (for SaveToDbnFile(), which is also deprecated)
 #include "MPIWrapper.h" // TODO: does not belong here
+#include "ColumnDelta.h"
+#include "ParameterCompression.h"
 #include <string>
 #include <vector>
 #include <stack>
 #include <list>
 #include <set>
+#include <atomic>
+#include <future>
+#include <thread>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -92,20 +103,41 @@ void ComputationNetwork::SaveEdited(const wstring& fileName, const FileOptions f
     Save(fileName, fileFormat);
 }
 
-void ComputationNetwork::Save(const wstring& fileName, const FileOptions fileFormat) const
+// 'flushToDisk' makes sure that the data has reached the disk before the file gets its final name.
+void ComputationNetwork::Save(const wstring& fileName, const FileOptions fileFormat, bool flushToDisk) const
 {
     VerifyIsCompiled("Save");
     // Saving into temporary file and then renaming it to the requested fileName
     // This is a standard trick to avoid havign corrupted model files if process dies during writing
     wstring tmpFileName = fileName + L".tmp";
-    SaveToFileImpl(tmpFileName, fileFormat);
+    SaveToFileImpl(tmpFileName, fileFormat, flushToDisk);
     renameOrDie(tmpFileName, fileName);
 }
 
+void ComputationNetwork::SaveToFileImpl(const wstring& fileName, const FileOptions fileFormat, bool flushToDisk) const
+{
+    File fstream(fileName, fileFormat | FileOptions::fileOptionsWrite | FileOptions::fileOptionsSequential);
+    SaveNetworkToStream(fstream, /*parameterValuesInline=*/true);
+    if (flushToDisk)
+        fstream.FlushToDisk();
+    else
+        fstream.Flush();
+}
+
+// helper of SaveNetworkToStream() for the mappable format, which writes parameter values separately
+template <class ElemType>
+static bool TrySaveParameterDescriptor(const ComputationNodeBasePtr& node, File& fstream)
+{
+    auto parameter = dynamic_pointer_cast<LearnableParameter<ElemType>>(node);
+    if (!parameter)
+        return false;
+    parameter->SaveDescriptor(fstream);
+    return true;
+}
+
 // TODO: how does the file distinguish float vs double nodes?
-void ComputationNetwork::SaveToFileImpl(const wstring& fileName, const FileOptions fileFormat) const
+void ComputationNetwork::SaveNetworkToStream(File& fstream, bool parameterValuesInline) const
 {
-    File fstream(fileName, fileFormat | FileOptions::fileOptionsWrite);
     fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BCN");
 
     // model version
@@ -134,7 +166,8 @@ void ComputationNetwork::SaveToFileImpl(const wstring& fileName, const FileOptio
         // name
         fstream << nodePtr->NodeName();
         // content
-        nodePtr->Save(fstream);
+        if (parameterValuesInline || !(TrySaveParameterDescriptor<float>(nodePtr, fstream) || TrySaveParameterDescriptor<double>(nodePtr, fstream)))
+            nodePtr->Save(fstream);
     }
 
     fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ENodeList");
@@ -190,15 +223,77 @@ void ComputationNetwork::SaveToFileImpl(const wstring& fileName, const FileOptio
     fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ERootNodes");
 
     fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ECN");
+}
 
-    fstream.Flush();
+// counterpart of TrySaveParameterDescriptor()
+template <class ElemType>
+static bool TryLoadParameterDescriptor(const ComputationNodeBasePtr& node, File& fstream, size_t modelVersion)
+{
+    auto parameter = dynamic_pointer_cast<LearnableParameter<ElemType>>(node);
+    if (!parameter)
+        return false;
+    parameter->LoadDescriptor(fstream, modelVersion);
+    return true;
+}
+
+// parallel model loading
+// ReadPersistableParameters() first reads all nodes but skips over the values of LearnableParameters.
+// These are then read by a few workers, each through its own file handle, and with a single read per value.
+// This way, reading from disk, and the copy to the target device, overlap across parameters.
+template <class ElemType>
+static bool TryLoadParameterSkippingValue(const ComputationNodeBasePtr& node, File& fstream, size_t modelVersion, vector<pair<ComputationNodeBasePtr, uint64_t>>& skippedValues)
+{
+    auto parameter = dynamic_pointer_cast<LearnableParameter<ElemType>>(node);
+    if (!parameter)
+        return false;
+    uint64_t valueOffset;
+    if (parameter->LoadSkippingValue(fstream, modelVersion, valueOffset))
+        skippedValues.push_back(make_pair(node, valueOffset));
+    return true;
+}
+
+template <class ElemType>
+static bool TryLoadParameterValueAt(const ComputationNodeBasePtr& node, File& fstream, uint64_t valueOffset)
+{
+    auto parameter = dynamic_pointer_cast<LearnableParameter<ElemType>>(node);
+    if (!parameter)
+        return false;
+    parameter->LoadValueAt(fstream, valueOffset);
+    return true;
+}
+
+bool ComputationNetwork::s_parallelParameterLoading = true;
+
+static void LoadSkippedParameterValues(const wstring& fileName, const vector<pair<ComputationNodeBasePtr, uint64_t>>& skippedValues)
+{
+    const size_t maxWorkers = 8; // beyond this, we are limited by the disk
+    size_t numWorkers = min(min((size_t)max(thread::hardware_concurrency(), 1u), maxWorkers), skippedValues.size());
+    atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        File fstream(fileName, FileOptions::fileOptionsBinary | FileOptions::fileOptionsRead);
+        for (size_t i = next++; i < skippedValues.size(); i = next++)
+        {
+            const auto& node = skippedValues[i].first;
+            if (!(TryLoadParameterValueAt<float>(node, fstream, skippedValues[i].second) || TryLoadParameterValueAt<double>(node, fstream, skippedValues[i].second)))
+                LogicError("LoadSkippedParameterValues: Unexpected node type.");
+        }
+    };
+    vector<future<void>> workers;
+    for (size_t k = 1; k < numWorkers; k++)
+        workers.push_back(async(launch::async, worker));
+    if (numWorkers > 0)
+        worker(); // this thread is one of the workers
+    for (auto& w : workers)
+        w.get(); // (rethrows if a worker failed)
 }
 
 // load the section of nodes that contain persistable parameters
 // This is also used for reloading a model without recreating it, e.g. during training.
+// If 'parameterValuesInline' is false, LearnableParameters are read without values, which the caller must attach (mappable format).
 // TODO: Why not just reload it? Because SGD::Train() holds pointers to the parameters directly? That should be fixed.
 template <class ElemType> // ElemType is the default for models prior to CNTK_MODEL_VERSION_7; after that, it is serialized, and ElemType is ignored
-void ComputationNetwork::ReadPersistableParameters(File& fstream, bool create)
+void ComputationNetwork::ReadPersistableParameters(File& fstream, bool create, bool parameterValuesInline)
 {
     fstream.GetMarker(FileMarker::fileMarkerBeginSection, L"BCN");
 
@@ -216,6 +311,7 @@ void ComputationNetwork::ReadPersistableParameters(File& fstream, bool create)
     fstream >> numNodes;
 
     // get all node info first
+    vector<pair<ComputationNodeBasePtr, uint64_t>> skippedValues; // parameter values to be read in the parallel pass below
     fstream.GetMarker(FileMarker::fileMarkerBeginSection, L"BNodeList");
     for (size_t i = 0; i < numNodes; i++)
     {
@@ -238,7 +334,14 @@ void ComputationNetwork::ReadPersistableParameters(File& fstream, bool create)
         else
             RuntimeError("Read: Unexpected precision tag '%ls'", precision.c_str());
 
-        node->Load(fstream, modelVersion);
+        if (!parameterValuesInline)
+        {
+            if (!(TryLoadParameterDescriptor<float>(node, fstream, modelVersion) || TryLoadParameterDescriptor<double>(node, fstream, modelVersion)))
+                node->Load(fstream, modelVersion);
+        }
+        else if (!s_parallelParameterLoading ||
+                 !(TryLoadParameterSkippingValue<float>(node, fstream, modelVersion, skippedValues) || TryLoadParameterSkippingValue<double>(node, fstream, modelVersion, skippedValues)))
+            node->Load(fstream, modelVersion);
 
         if (create) // loaded from scratch
             AddNodeToNet(node);
@@ -257,6 +360,9 @@ void ComputationNetwork::ReadPersistableParameters(File& fstream, bool create)
     }
 
     fstream.GetMarker(FileMarker::fileMarkerEndSection, L"ENodeList");
+
+    // now read the parameter values
+    LoadSkippedParameterValues(fstream.GetFileName(), skippedValues);
 }
 
 // deserialize the model
@@ -268,8 +374,21 @@ void ComputationNetwork::Read(const wstring& fileName)
 
     File fstream(fileName, FileOptions::fileOptionsBinary | FileOptions::fileOptionsRead);
 
+    if (fstream.TryGetMarker(FileMarker::fileMarkerBeginSection, L"BMappableCN"))
+        return ReadMappable<ElemType>(fstream, fileName, /*create=*/true);
+    if (fstream.TryGetMarker(FileMarker::fileMarkerBeginSection, L"BDeltaCN"))
+        return ReadDelta<ElemType>(fstream, fileName, /*create=*/true);
+    if (fstream.TryGetMarker(FileMarker::fileMarkerBeginSection, L"BCompressedCN"))
+        return ReadCompressed<ElemType>(fstream, /*create=*/true);
+
     ReadPersistableParameters<ElemType>(fstream, true);
+    ReadRelationsAndRootNodes(fstream);
+}
 
+// read the part of the model that follows the node list
+// If 'create' is false, the network already has its structure (reloading parameters), and this section is only skipped over.
+void ComputationNetwork::ReadRelationsAndRootNodes(File& fstream, bool create)
+{
     size_t numNodes = m_nameToNodeMap.size();
 
     // get relationship
@@ -286,6 +405,9 @@ void ComputationNetwork::Read(const wstring& fileName)
             for (size_t j = 0; j < numChildren; j++)
                 fstream >> childrenNames[j];
 
+            if (!create)
+                continue;
+
             // TODO: how does the file distinguish float from double?
             ComputationNodeBasePtr nodePtr = GetNodeFromName(nodeName);
             vector<ComputationNodeBasePtr> childrenNodes;
@@ -310,7 +432,8 @@ void ComputationNetwork::Read(const wstring& fileName)
             for (size_t i = 0; i < num; i++)
             {
                 fstream >> nodeName;
-                AddToNodeGroup(L"feature", GetNodeFromName(nodeName));
+                if (create)
+                    AddToNodeGroup(L"feature", GetNodeFromName(nodeName));
             }
             fstream.GetMarker(FileMarker::fileMarkerEndSection, L"EFeatureNodes");
         }
@@ -321,7 +444,8 @@ void ComputationNetwork::Read(const wstring& fileName)
             for (size_t i = 0; i < num; i++)
             {
                 fstream >> nodeName;
-                AddToNodeGroup(L"label", GetNodeFromName(nodeName));
+                if (create)
+                    AddToNodeGroup(L"label", GetNodeFromName(nodeName));
             }
         }
         // BUGBUG: Should this be inside the block?
@@ -334,7 +458,8 @@ void ComputationNetwork::Read(const wstring& fileName)
             for (size_t i = 0; i < num; i++)
             {
                 fstream >> nodeName;
-                AddToNodeGroup(L"criterion", GetNodeFromName(nodeName));
+                if (create)
+                    AddToNodeGroup(L"criterion", GetNodeFromName(nodeName));
             }
 
             if (!fstream.TryGetMarker(FileMarker::fileMarkerEndSection, L"ECriteriaNodes" /*legacy*/))
@@ -359,7 +484,8 @@ void ComputationNetwork::Read(const wstring& fileName)
             for (size_t i = 0; i < num; i++)
             {
                 fstream >> nodeName;
-                AddToNodeGroup(L"evaluation", GetNodeFromName(nodeName));
+                if (create)
+                    AddToNodeGroup(L"evaluation", GetNodeFromName(nodeName));
             }
             fstream.GetMarker(FileMarker::fileMarkerEndSection, L"EEvalNodes");
         }
@@ -370,7 +496,8 @@ void ComputationNetwork::Read(const wstring& fileName)
             for (size_t i = 0; i < num; i++)
             {
                 fstream >> nodeName;
-                AddToNodeGroup(L"output", GetNodeFromName(nodeName));
+                if (create)
+                    AddToNodeGroup(L"output", GetNodeFromName(nodeName));
             }
             fstream.GetMarker(FileMarker::fileMarkerEndSection, L"EOutputNodes");
         }
@@ -389,6 +516,399 @@ void ComputationNetwork::Read(const wstring& fileName)
     fstream.GetMarker(FileMarker::fileMarkerEndSection, L"ECN");
 }
 
+// -----------------------------------------------------------------------
+// memory-mappable model format
+// -----------------------------------------------------------------------
+
+// The mappable format keeps the regular serialization, minus the LearnableParameter values, as a compact
+// graph header, and stores the parameter values behind it as contiguous, page-aligned blobs:
+//   BMappableCN <format version> <blob alignment> <offset of blob table>
+//   BCN ... ECN                         regular model; LearnableParameters without their values
+//   [padding] blob [padding] blob ...   column-major parameter values, each starting at a multiple of the blob alignment
+//   BParameterBlobs <count> { <node name> <element size> <rows> <cols> <file offset> } EParameterBlobs
+//   EMappableCN
+// Values of other nodes (e.g. precomputed statistics) remain in the graph header; they are small.
+// Loading parses the header and maps the file. On the CPU, parameters then point into the mapping directly.
+
+#define CURRENT_MAPPABLE_MODEL_FORMAT_VERSION 1
+static const size_t mappableModelBlobAlignment = 4096;
+
+struct MappableParameterBlob
+{
+    wstring nodeName;
+    size_t elemSize;
+    size_t numRows;
+    size_t numCols;
+    size_t offset;
+};
+
+// read-only memory mapping of an entire model file
+// The mapping is copy-on-write: all processes mapping the same file share its physical pages, and in-place updates
+// (e.g. training continued from a mapped model) turn into private copies of the affected pages rather than file writes.
+class MappedModelFile
+{
+public:
+    MappedModelFile(const wstring& fileName)
+    {
+#ifdef _WIN32
+        m_file = CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+            RuntimeError("MappedModelFile: Failed to open '%ls' (error %d).", fileName.c_str(), (int)GetLastError());
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size))
+            RuntimeError("MappedModelFile: Failed to determine the size of '%ls' (error %d).", fileName.c_str(), (int)GetLastError());
+        m_size = (size_t)size.QuadPart;
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (m_mapping == nullptr)
+            RuntimeError("MappedModelFile: Failed to map '%ls' (error %d).", fileName.c_str(), (int)GetLastError());
+        m_data = (char*)MapViewOfFile(m_mapping, FILE_MAP_COPY, 0, 0, 0);
+        if (m_data == nullptr)
+            RuntimeError("MappedModelFile: Failed to map '%ls' (error %d).", fileName.c_str(), (int)GetLastError());
+#else
+        int fd = open(wtocharpath(fileName).c_str(), O_RDONLY);
+        if (fd < 0)
+            RuntimeError("MappedModelFile: Failed to open '%ls' (errno %d).", fileName.c_str(), errno);
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            RuntimeError("MappedModelFile: Failed to determine the size of '%ls' (errno %d).", fileName.c_str(), errno);
+        }
+        m_size = (size_t)st.st_size;
+        void* data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping keeps its own reference to the file
+        if (data == MAP_FAILED)
+            RuntimeError("MappedModelFile: Failed to map '%ls' (errno %d).", fileName.c_str(), errno);
+        m_data = (char*)data;
+#endif
+    }
+
+    ~MappedModelFile()
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping);
+        CloseHandle(m_file);
+#else
+        munmap(m_data, m_size);
+#endif
+    }
+
+    char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    MappedModelFile(const MappedModelFile&) = delete;
+    MappedModelFile& operator=(const MappedModelFile&) = delete;
+
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#endif
+    char* m_data;
+    size_t m_size;
+};
+
+void ComputationNetwork::SaveMappable(const wstring& fileName) const
+{
+    VerifyIsCompiled("SaveMappable");
+    // same temp-file trick as Save()
+    wstring tmpFileName = fileName + L".tmp";
+    SaveToMappableFileImpl(tmpFileName);
+    renameOrDie(tmpFileName, fileName);
+}
+
+// write the value of a LearnableParameter as an aligned blob at the end of the file
+template <class ElemType>
+static bool TrySaveParameterBlob(const ComputationNodeBasePtr& node, File& fstream, vector<MappableParameterBlob>& blobs)
+{
+    auto parameter = dynamic_pointer_cast<LearnableParameter<ElemType>>(node);
+    if (!parameter)
+        return false;
+    const auto& value = parameter->Value();
+
+    size_t position = fstream.GetPosition();
+    size_t offset = (position + mappableModelBlobAlignment - 1) / mappableModelBlobAlignment * mappableModelBlobAlignment;
+    if (offset > position)
+    {
+        vector<char> padding(offset - position, 0);
+        fwriteOrDie(padding.data(), 1, padding.size(), fstream);
+    }
+    if (value.GetNumElements() > 0)
+    {
+        unique_ptr<ElemType[]> data(value.CopyToArray()); // (brings GPU values to the CPU)
+        fwriteOrDie(data.get(), sizeof(ElemType), value.GetNumElements(), fstream);
+    }
+    blobs.push_back(MappableParameterBlob{ node->NodeName(), sizeof(ElemType), value.GetNumRows(), value.GetNumCols(), offset });
+    return true;
+}
+
+void ComputationNetwork::SaveToMappableFileImpl(const wstring& fileName) const
+{
+    File fstream(fileName, FileOptions::fileOptionsBinary | FileOptions::fileOptionsWrite | FileOptions::fileOptionsSequential);
+    fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BMappableCN");
+    fstream << (size_t) CURRENT_MAPPABLE_MODEL_FORMAT_VERSION << mappableModelBlobAlignment;
+    let blobTableOffsetPosition = fstream.GetPosition();
+    fstream << (size_t) 0; // blob-table offset, patched below
+
+    SaveNetworkToStream(fstream, /*parameterValuesInline=*/false);
+
+    vector<MappableParameterBlob> blobs;
+    for (const auto& iter : m_nameToNodeMap)
+        TrySaveParameterBlob<float>(iter.second, fstream, blobs) || TrySaveParameterBlob<double>(iter.second, fstream, blobs);
+
+    size_t blobTableOffset = fstream.GetPosition();
+    fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BParameterBlobs");
+    fstream << blobs.size();
+    for (const auto& blob : blobs)
+        fstream << blob.nodeName << blob.elemSize << blob.numRows << blob.numCols << blob.offset;
+    fstream.PutMarker(FileMarker::fileMarkerEndSection, L"EParameterBlobs");
+    fstream.PutMarker(FileMarker::fileMarkerEndSection, L"EMappableCN");
+
+    fstream.SetPosition(blobTableOffsetPosition);
+    fstream << blobTableOffset;
+
+    fstream.Flush();
+}
+
+// counterpart of TrySaveParameterBlob()
+template <class ElemType>
+static bool TryAttachParameterBlob(const ComputationNodeBasePtr& node, const MappableParameterBlob& blob, const shared_ptr<MappedModelFile>& file)
+{
+    auto parameter = dynamic_pointer_cast<LearnableParameter<ElemType>>(node);
+    if (!parameter)
+        return false;
+    if (blob.elemSize != sizeof(ElemType))
+        RuntimeError("Read: Parameter blob of '%ls' has element size %d, but the node expects %d.", blob.nodeName.c_str(), (int)blob.elemSize, (int)sizeof(ElemType));
+    parameter->AttachValueBuffer(reinterpret_cast<ElemType*>(file->Data() + blob.offset), blob.numRows, blob.numCols, file);
+    return true;
+}
+
+// counterpart of SaveToMappableFileImpl(), called by Read() and RereadPersistableParameters() after they found the 'BMappableCN' marker
+template <class ElemType>
+void ComputationNetwork::ReadMappable(File& fstream, const wstring& fileName, bool create)
+{
+    size_t formatVersion, alignment, blobTableOffset;
+    fstream >> formatVersion >> alignment >> blobTableOffset;
+    if (formatVersion > CURRENT_MAPPABLE_MODEL_FORMAT_VERSION)
+        InvalidArgument("Read: The mappable model file has a newer format version (%d) than this CNTK version can handle (%d).", (int)formatVersion, (int)CURRENT_MAPPABLE_MODEL_FORMAT_VERSION);
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+        RuntimeError("Read: The mappable model file has an invalid blob alignment (%d); it must be a power of two.", (int)alignment);
+
+    ReadPersistableParameters<ElemType>(fstream, create, /*parameterValuesInline=*/false);
+    if (create)
+        ReadRelationsAndRootNodes(fstream);
+
+    fstream.SetPosition(blobTableOffset);
+    fstream.GetMarker(FileMarker::fileMarkerBeginSection, L"BParameterBlobs");
+    size_t numBlobs;
+    fstream >> numBlobs;
+    vector<MappableParameterBlob> blobs(numBlobs);
+    for (auto& blob : blobs)
+        fstream >> blob.nodeName >> blob.elemSize >> blob.numRows >> blob.numCols >> blob.offset;
+    fstream.GetMarker(FileMarker::fileMarkerEndSection, L"EParameterBlobs");
+    fstream.GetMarker(FileMarker::fileMarkerEndSection, L"EMappableCN");
+
+    size_t numParameters = 0;
+    for (const auto& iter : m_nameToNodeMap)
+        if (iter.second->OperationName() == OperationNameOf(LearnableParameter))
+            numParameters++;
+    if (numBlobs != numParameters)
+        RuntimeError("Read: Mappable model file has %d parameter blobs for %d parameters.", (int)numBlobs, (int)numParameters);
+
+    // map the file and let the parameters use their blobs
+    // Each parameter that uses its blob in place holds on to the mapping, so it lives as long as any matrix that points into it,
+    // including those shared with clones (CloneSharingParameters()).
+    auto file = make_shared<MappedModelFile>(fileName);
+    for (const auto& blob : blobs)
+    {
+        if (blob.offset % alignment != 0 || blob.offset + blob.elemSize * blob.numRows * blob.numCols > file->Size())
+            RuntimeError("Read: Parameter blob of '%ls' lies outside of the mappable model file; the file may be truncated.", blob.nodeName.c_str());
+        let node = GetNodeFromName(blob.nodeName);
+        if (!TryAttachParameterBlob<float>(node, blob, file) && !TryAttachParameterBlob<double>(node, blob, file))
+            RuntimeError("Read: Parameter blob of '%ls' does not belong to a LearnableParameter.", blob.nodeName.c_str());
+    }
+}
+
+// -----------------------------------------------------------------------
+// delta model files
+// -----------------------------------------------------------------------
+
+// A delta model file only stores the LearnableParameter columns that changed relative to a base model file,
+// which may itself be a delta file:
+//   BDeltaCN <format version> <base file name> <number of parameters> { <node name> <column delta> } EDeltaCN
+// The base is referred to by its file name, and must be in the same directory.
+
+#define CURRENT_DELTA_MODEL_FORMAT_VERSION 1
+
+template <class ElemType>
+static ComputationNode<ElemType>* AsDeltaParameter(const ComputationNodeBasePtr& node, const char* where)
+{
+    auto parameter = dynamic_cast<ComputationNode<ElemType>*>(node.get());
+    if (!parameter)
+        LogicError("%s: Parameter '%ls' is not of type %ls.", where, node->NodeName().c_str(), ElemTypeName<ElemType>());
+    return parameter;
+}
+
+template <class ElemType>
+void ComputationNetwork::SaveDelta(const wstring& fileName, const wstring& baseFileName, map<wstring, vector<uint64_t>>& columnHashes) const
+{
+    VerifyIsCompiled("SaveDelta");
+    // same temp-file trick as Save()
+    wstring tmpFileName = fileName + L".tmp";
+    {
+        File fstream(tmpFileName, FileOptions::fileOptionsBinary | FileOptions::fileOptionsWrite | FileOptions::fileOptionsSequential);
+        fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BDeltaCN");
+        fstream << (size_t) CURRENT_DELTA_MODEL_FORMAT_VERSION;
+        fstream << File::FileNameOf(baseFileName);
+
+        vector<ComputationNodeBasePtr> parameters;
+        for (const auto& iter : m_nameToNodeMap)
+            if (iter.second->OperationName() == OperationNameOf(LearnableParameter))
+                parameters.push_back(iter.second);
+        fstream << parameters.size();
+        for (const auto& node : parameters)
+        {
+            fstream << node->NodeName();
+            SaveColumnDelta(fstream, AsDeltaParameter<ElemType>(node, "SaveDelta")->Value(), columnHashes[node->NodeName()]);
+        }
+
+        fstream.PutMarker(FileMarker::fileMarkerEndSection, L"EDeltaCN");
+        fstream.Flush();
+    }
+    renameOrDie(tmpFileName, fileName);
+}
+
+template <class ElemType>
+void ComputationNetwork::SetDeltaReference(map<wstring, vector<uint64_t>>& columnHashes) const
+{
+    columnHashes.clear();
+    for (const auto& iter : m_nameToNodeMap)
+        if (iter.second->OperationName() == OperationNameOf(LearnableParameter))
+            SetColumnDeltaReference(AsDeltaParameter<ElemType>(iter.second, "SetDeltaReference")->Value(), columnHashes[iter.first]);
+}
+
+// counterpart of SaveDelta(), called by Read() or RereadPersistableParameters() after they found the 'BDeltaCN' marker
+template <class ElemType>
+void ComputationNetwork::ReadDelta(File& fstream, const wstring& fileName, bool create)
+{
+    size_t formatVersion;
+    fstream >> formatVersion;
+    if (formatVersion > CURRENT_DELTA_MODEL_FORMAT_VERSION)
+        InvalidArgument("Read: The delta model file has a newer format version (%d) than this CNTK version can handle (%d).", (int)formatVersion, (int)CURRENT_DELTA_MODEL_FORMAT_VERSION);
+    wstring baseFileName;
+    fstream >> baseFileName;
+
+    // replay the chain: first the base, then our changes
+    let basePath = File::DirectoryPathOf(fileName) + L"/" + baseFileName;
+    if (create)
+        Read<ElemType>(basePath);
+    else
+        RereadPersistableParameters<ElemType>(basePath);
+
+    size_t numParameters;
+    fstream >> numParameters;
+    for (size_t i = 0; i < numParameters; i++)
+    {
+        wstring nodeName;
+        fstream >> nodeName;
+        LoadColumnDelta(fstream, AsDeltaParameter<ElemType>(GetNodeFromName(nodeName), "Read")->Value());
+    }
+    fstream.GetMarker(FileMarker::fileMarkerEndSection, L"EDeltaCN");
+}
+
+// -----------------------------------------------------------------------
+// compressed model files
+// -----------------------------------------------------------------------
+
+// A compressed model file is meant for distributing a trained model. It stores the LearnableParameter values
+// with lossy compression (see ParameterCompression.h), behind the regular graph without values:
+//   BCompressedCN <format version> <compression> BCN...ECN <number of parameters> { <node name> <compressed matrix> } ECompressedCN
+// Read() expands the values back to full precision.
+
+#define CURRENT_COMPRESSED_MODEL_FORMAT_VERSION 1
+
+void ComputationNetwork::SaveCompressed(const wstring& fileName, ParameterCompression compression) const
+{
+    VerifyIsCompiled("SaveCompressed");
+    // same temp-file trick as Save()
+    wstring tmpFileName = fileName + L".tmp";
+    SaveToCompressedFileImpl(tmpFileName, compression);
+    renameOrDie(tmpFileName, fileName);
+}
+
+template <class ElemType>
+static bool TrySaveCompressedParameter(const ComputationNodeBasePtr& node, File& fstream, ParameterCompression compression)
+{
+    auto parameter = dynamic_pointer_cast<LearnableParameter<ElemType>>(node);
+    if (!parameter)
+        return false;
+    SaveCompressedMatrix(fstream, parameter->Value(), compression);
+    return true;
+}
+
+void ComputationNetwork::SaveToCompressedFileImpl(const wstring& fileName, ParameterCompression compression) const
+{
+    File fstream(fileName, FileOptions::fileOptionsBinary | FileOptions::fileOptionsWrite | FileOptions::fileOptionsSequential);
+    fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BCompressedCN");
+    fstream << (size_t) CURRENT_COMPRESSED_MODEL_FORMAT_VERSION << (int) compression;
+
+    SaveNetworkToStream(fstream, /*parameterValuesInline=*/false);
+
+    vector<ComputationNodeBasePtr> parameters;
+    for (const auto& iter : m_nameToNodeMap)
+        if (iter.second->OperationName() == OperationNameOf(LearnableParameter))
+            parameters.push_back(iter.second);
+    fstream << parameters.size();
+    for (const auto& node : parameters)
+    {
+        fstream << node->NodeName();
+        if (!TrySaveCompressedParameter<float>(node, fstream, compression) && !TrySaveCompressedParameter<double>(node, fstream, compression))
+            LogicError("SaveCompressed: Parameter '%ls' has an unexpected element type.", node->NodeName().c_str());
+    }
+
+    fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ECompressedCN");
+    fstream.Flush();
+}
+
+// counterpart of TrySaveCompressedParameter()
+template <class ElemType>
+static bool TryLoadCompressedParameter(const ComputationNodeBasePtr& node, File& fstream)
+{
+    auto parameter = dynamic_pointer_cast<LearnableParameter<ElemType>>(node);
+    if (!parameter)
+        return false;
+    parameter->CreateValueMatrixIfNull();
+    LoadCompressedMatrix(fstream, parameter->Value());
+    return true;
+}
+
+// counterpart of SaveToCompressedFileImpl(), called by Read() or RereadPersistableParameters() after they found the 'BCompressedCN' marker
+template <class ElemType>
+void ComputationNetwork::ReadCompressed(File& fstream, bool create)
+{
+    size_t formatVersion;
+    int compression;
+    fstream >> formatVersion >> compression;
+    if (formatVersion > CURRENT_COMPRESSED_MODEL_FORMAT_VERSION)
+        InvalidArgument("Read: The compressed model file has a newer format version (%d) than this CNTK version can handle (%d).", (int)formatVersion, (int)CURRENT_COMPRESSED_MODEL_FORMAT_VERSION);
+
+    ReadPersistableParameters<ElemType>(fstream, create, /*parameterValuesInline=*/false);
+    ReadRelationsAndRootNodes(fstream, create);
+
+    size_t numParameters;
+    fstream >> numParameters;
+    for (size_t i = 0; i < numParameters; i++)
+    {
+        wstring nodeName;
+        fstream >> nodeName;
+        let node = GetNodeFromName(nodeName);
+        if (!TryLoadCompressedParameter<float>(node, fstream) && !TryLoadCompressedParameter<double>(node, fstream))
+            RuntimeError("Read: Compressed value of '%ls' does not belong to a LearnableParameter.", nodeName.c_str());
+    }
+    fstream.GetMarker(FileMarker::fileMarkerEndSection, L"ECompressedCN");
+}
+
 // -----------------------------------------------------------------------
 // node construction
 // -----------------------------------------------------------------------
@@ -1514,7 +2034,12 @@ void ComputationNetwork::SaveToDbnFile(ComputationNetworkPtr net, const std::wst
 
 template void ComputationNetwork::InitLearnableParametersWithBilinearFill<float>(const ComputationNodeBasePtr& node, size_t kernelWidth, size_t kernelHeight);
 template void ComputationNetwork::Read<float>(const wstring& fileName);
-template void ComputationNetwork::ReadPersistableParameters<float>(File& fstream, bool create);
+template void ComputationNetwork::ReadPersistableParameters<float>(File& fstream, bool create, bool parameterValuesInline);
+template void ComputationNetwork::ReadDelta<float>(File& fstream, const wstring& fileName, bool create);
+template void ComputationNetwork::ReadMappable<float>(File& fstream, const wstring& fileName, bool create);
+template void ComputationNetwork::ReadCompressed<float>(File& fstream, bool create);
+template void ComputationNetwork::SaveDelta<float>(const wstring& fileName, const wstring& baseFileName, map<wstring, vector<uint64_t>>& columnHashes) const;
+template void ComputationNetwork::SetDeltaReference<float>(map<wstring, vector<uint64_t>>& columnHashes) const;
 template void ComputationNetwork::PerformSVDecomposition<float>(const map<wstring, float>& SVDConfig, size_t alignedsize);
 template /*static*/ void ComputationNetwork::SetDropoutRate<float>(ComputationNetworkPtr net, const ComputationNodeBasePtr& criterionNode, const double dropoutRate, double& prevDropoutRate);
 template /*static*/ void ComputationNetwork::SetIRngUserSeed<float>(ComputationNetworkPtr net, const ComputationNodeBasePtr& criterionNode, size_t randSeedBase);
@@ -1525,7 +2050,12 @@ template void ComputationNetwork::SaveToDbnFile<float>(ComputationNetworkPtr net
 
 template void ComputationNetwork::InitLearnableParametersWithBilinearFill<double>(const ComputationNodeBasePtr& node, size_t kernelWidth, size_t kernelHeight);
 template void ComputationNetwork::Read<double>(const wstring& fileName);
-template void ComputationNetwork::ReadPersistableParameters<double>(File& fstream, bool create);
+template void ComputationNetwork::ReadPersistableParameters<double>(File& fstream, bool create, bool parameterValuesInline);
+template void ComputationNetwork::ReadDelta<double>(File& fstream, const wstring& fileName, bool create);
+template void ComputationNetwork::ReadMappable<double>(File& fstream, const wstring& fileName, bool create);
+template void ComputationNetwork::ReadCompressed<double>(File& fstream, bool create);
+template void ComputationNetwork::SaveDelta<double>(const wstring& fileName, const wstring& baseFileName, map<wstring, vector<uint64_t>>& columnHashes) const;
+template void ComputationNetwork::SetDeltaReference<double>(map<wstring, vector<uint64_t>>& columnHashes) const;
 template void ComputationNetwork::PerformSVDecomposition<double>(const map<wstring, float>& SVDConfig, size_t alignedsize);
 template /*static*/ void ComputationNetwork::SetDropoutRate<double>(ComputationNetworkPtr net, const ComputationNodeBasePtr& criterionNode, const double dropoutRate, double& prevDropoutRate);
 template /*static*/ void ComputationNetwork::SetIRngUserSeed<double>(ComputationNetworkPtr net, const ComputationNodeBasePtr& criterionNode, size_t randSeedBase);
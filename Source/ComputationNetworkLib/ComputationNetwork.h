@@ -13,6 +13,7 @@
 #include "ComputationNode.h"
 #include "ScriptableObjects.h"
 #include "ComputationEnvironment.h"
+#include "InterOpScheduler.h"
 
 #include <map>
 #include <string>
@@ -32,6 +33,8 @@
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
+enum class ParameterCompression : int; // see ParameterCompression.h
+
 // ===========================================================================
 // ComputationNetwork -- computation graph and operations
 // ===========================================================================
@@ -90,16 +93,30 @@ public:
     // -----------------------------------------------------------------------
 
     template <class ElemType>
-    void ReadPersistableParameters(File& fstream, bool create);
+    void ReadPersistableParameters(File& fstream, bool create, bool parameterValuesInline = true);
     // reload node content only, e.g. used by SGD::Train() when going back to an older model that had better training objective
     template <class ElemType>
     void RereadPersistableParameters(const std::wstring& fileName)
     {
         File fstream(fileName, FileOptions::fileOptionsBinary | FileOptions::fileOptionsRead);
-        ReadPersistableParameters<ElemType>(fstream, false);
+        if (fstream.TryGetMarker(FileMarker::fileMarkerBeginSection, L"BDeltaCN"))
+            ReadDelta<ElemType>(fstream, fileName, /*create=*/false);
+        else if (fstream.TryGetMarker(FileMarker::fileMarkerBeginSection, L"BMappableCN"))
+            ReadMappable<ElemType>(fstream, fileName, /*create=*/false);
+        else if (fstream.TryGetMarker(FileMarker::fileMarkerBeginSection, L"BCompressedCN"))
+            ReadCompressed<ElemType>(fstream, /*create=*/false);
+        else
+            ReadPersistableParameters<ElemType>(fstream, false);
+        // the parameters have changed, so values computed from them are out of date (see SetCacheStaticSubgraphs())
+        for (auto& nodeIter : m_nameToNodeMap)
+        {
+            if (nodeIter.second->IsLeaf())
+                nodeIter.second->BumpEvalTimeStamp();
+        }
     }
     // design BUGBUG: binary files do not know whether they are float or double.
     // TODO: modify file format to know this; then eliminate the <ElemType> dependency (and in some future, allow nodes to be different)
+    // Read() accepts the regular, the mappable, the delta, and the compressed model format (see SaveMappable() etc.).
     template <class ElemType> void Read(const std::wstring& fileName);
     template <class ElemType> void Load(const std::wstring& fileName)
     {
@@ -117,12 +134,37 @@ public:
         return net;
     }
 
-    void Save(const std::wstring& fileName, const FileOptions fileFormat = FileOptions::fileOptionsBinary) const;
+    void Save(const std::wstring& fileName, const FileOptions fileFormat = FileOptions::fileOptionsBinary, bool flushToDisk = false) const;
     void SaveEdited(const std::wstring& fileName, const FileOptions fileFormat = FileOptions::fileOptionsBinary);
+    // save in the memory-mappable format: graph header followed by page-aligned parameter blobs
+    // When loaded on the CPU, parameters use the mapped file in place, so load time does not depend on the model size,
+    // and processes that load the same file share the physical pages of the weights.
+    void SaveMappable(const std::wstring& fileName) const;
+    // save a delta model file (delta checkpointing in SGD) with only the LearnableParameter columns that changed since
+    // the model file 'baseFileName' was written. 'columnHashes' holds the column hashes of the parameter values as
+    // written there (see ColumnDelta.h), and is updated to the current values. Read() and RereadPersistableParameters() replay the chain of base files.
+    template <class ElemType>
+    void SaveDelta(const std::wstring& fileName, const std::wstring& baseFileName, std::map<std::wstring, std::vector<uint64_t>>& columnHashes) const;
+    // record the current parameter values as the reference for the next SaveDelta(), after saving a full model
+    template <class ElemType>
+    void SetDeltaReference(std::map<std::wstring, std::vector<uint64_t>>& columnHashes) const;
+    // save with lossy compression (fp16 or per-column int8) of the LearnableParameter values, for model distribution
+    // Read() expands the values to full precision again.
+    void SaveCompressed(const std::wstring& fileName, ParameterCompression compression) const;
 
 private:
 
-    void SaveToFileImpl(const std::wstring& fileName, const FileOptions fileFormat) const;
+    void SaveToFileImpl(const std::wstring& fileName, const FileOptions fileFormat, bool flushToDisk) const;
+    void SaveToMappableFileImpl(const std::wstring& fileName) const;
+    void SaveToCompressedFileImpl(const std::wstring& fileName, ParameterCompression compression) const;
+    void SaveNetworkToStream(File& fstream, bool parameterValuesInline) const;
+    void ReadRelationsAndRootNodes(File& fstream, bool create = true);
+    template <class ElemType>
+    void ReadMappable(File& fstream, const std::wstring& fileName, bool create);
+    template <class ElemType>
+    void ReadDelta(File& fstream, const std::wstring& fileName, bool create);
+    template <class ElemType>
+    void ReadCompressed(File& fstream, bool create);
 
 public:
 
@@ -150,6 +192,57 @@ public:
     static void BumpEvalTimeStamp(const std::vector<ComputationNodeBasePtr>& nodes);
     void ResetEvalTimeStamps();
 
+    // number of threads on which ForwardProp() and Backprop() run independent nodes concurrently (1 = in sequence)
+    // This applies to networks on the CPU only, and must be set before the matrices are allocated, since nodes then do not share matrices
+    // through the MatrixPool. See InterOpScheduler.h. Independent recurrent loops, such as the two directions of a bidirectional LSTM,
+    // are such nodes as well. For training, this cannot be combined with SetRecomputeValues() or the compact activation stash.
+    static void SetNumInterOpThreads(size_t numThreads) { s_numInterOpThreads = numThreads; }
+    static size_t GetNumInterOpThreads() { return s_numInterOpThreads; }
+    size_t GetNumInterOpThreadsUsed() const; // by the last ForwardProp() or Backprop(), most over all root nodes
+
+    // if true, recurrent loops compute each time step only over the parallel sequences that have not ended yet
+    // Gap frames of ended sequences are set to 0 instead of being computed. See MBLayout::GetNumActiveParallelSequences().
+    // This works best with readers that order the parallel sequences by length (reader option sortParallelSequencesByLength).
+    static void SetShrinkRecurrentLoops(bool shrink) { s_shrinkRecurrentLoops = shrink; }
+    static bool GetShrinkRecurrentLoops() { return s_shrinkRecurrentLoops; }
+    size_t GetNumSkippedSequenceSteps() const; // in the last minibatch, summed over all loops
+
+    // if true, recurrent loops capture their nodes' ForwardProp() once and replay it for all time steps
+    // This avoids the per-step overhead of slicing, which matters for small hidden dimensions. See ComputationNodeBase::CaptureForwardStep().
+    // The captured loop body is kept for each minibatch geometry (parallel sequences x time steps), so a geometry that repeats is not captured again.
+    // Each loop keeps at most 'maxNumGeometries' of them; the one used least recently is dropped first.
+    static void SetCaptureRecurrentSteps(bool capture, size_t maxNumGeometries = 64) { s_captureRecurrentSteps = capture; s_maxCapturedGeometries = maxNumGeometries; }
+    static bool GetCaptureRecurrentSteps() { return s_captureRecurrentSteps; }
+    static size_t GetMaxCapturedGeometries() { return s_maxCapturedGeometries; }
+    size_t GetNumCapturedGeometries() const; // summed over all loops
+    size_t GetNumCapturedNodes() const;      // that the last ForwardProp() ran from captured steps, summed over all loops
+
+    // gradient checkpointing: if 'recompute', node values that backprop needs are released after forward prop, and recomputed
+    // segment by segment just before the segment's Backprop(). This trades extra forward computation for memory.
+    // 'segmentLength' is the number of top-level nodes per segment; 0 picks the square root of the number of nodes.
+    // This must be set before the matrices are allocated. See ComputationNetwork::PlanRecomputeSegments().
+    static void SetRecomputeValues(bool recompute, size_t segmentLength = 0) { s_recomputeValues = recompute; s_recomputeSegmentLength = segmentLength; }
+    static bool GetRecomputeValues() { return s_recomputeValues; }
+    static size_t GetRecomputeSegmentLength() { return s_recomputeSegmentLength; }
+    size_t GetNumRecomputeSegments() const; // as planned by AllocateAllMatrices(), summed over all root nodes
+
+    // if true, expressions of elementwise nodes whose intermediate values are used nowhere else are computed in a single pass
+    // by their last node, without matrices for the intermediate values. See ElementwiseFusion.h and PlanElementwiseFusion().
+    // This must be set before the matrices are allocated. It is not combined with gradient checkpointing.
+    static void SetFuseElementwiseOps(bool fuse) { s_fuseElementwiseOps = fuse; }
+    static bool GetFuseElementwiseOps() { return s_fuseElementwiseOps; }
+
+    // if true, ResetEvalTimeStamps() keeps the values of nodes that depend only on LearnableParameters (see DetermineStaticNodes()),
+    // such as W * W' or normalized weights; they are recomputed only when one of the parameters' time stamps changes, e.g. after an
+    // update. Code that modifies parameter values must call BumpEvalTimeStamp() on them, as SGD's update and RereadPersistableParameters() do.
+    static void SetCacheStaticSubgraphs(bool cache) { s_cacheStaticSubgraphs = cache; }
+    static bool GetCacheStaticSubgraphs() { return s_cacheStaticSubgraphs; }
+
+    // if true (default), model loading reads the LearnableParameter values on several threads, after the rest of the nodes
+    // If false, each node is read in sequence with its values. See ReadPersistableParameters().
+    static void SetParallelParameterLoading(bool parallel) { s_parallelParameterLoading = parallel; }
+    static bool GetParallelParameterLoading() { return s_parallelParameterLoading; }
+
     // and for a set of nodes
     void StartEvaluateMinibatchLoop(const ComputationNodeBasePtr& rootNode) // (ugly name; meant to be unique so we can rename if needed)
     {
@@ -180,6 +273,7 @@ private:
     size_t ValidateNodes(list<ComputationNodeBasePtr> nodes, bool isFirstPass, bool isFinalValidationPass);
     bool ValidateNode(ComputationNodeBasePtr node, bool isFinalValidationPass) const;
     void MarkValueNonSharableNodes();
+    void DetermineStaticNodes();
     void ChangeNodeInputs(ComputationNodeBasePtr fromNode, ComputationNodeBasePtr toNode);
 
 private:
@@ -196,6 +290,12 @@ public:
 private:
     void PrintMemorySharingStructure(const std::vector<ComputationNodeBasePtr>& nodes);
     void ReleaseMatricesAfterEvalForChildren(ComputationNodeBasePtr n, std::unordered_map<ComputationNodeBasePtr, int>& parentCount);
+    void PlanRecomputeSegments(const ComputationNodeBasePtr& trainRootNode,
+                               const std::unordered_map<ComputationNodeBasePtr, std::unordered_set<ComputationNodeBasePtr>>& parentsMap,
+                               std::unordered_map<ComputationNodeBasePtr, bool>& outputValueNeededDuringBackProp);
+    void PlanElementwiseFusion(const std::vector<ComputationNodeBasePtr>& nodes,
+                               const std::vector<ComputationNodeBasePtr>& forwardPropRoots,
+                               const std::unordered_map<ComputationNodeBasePtr, std::unordered_set<ComputationNodeBasePtr>>& parentsMap);
     void AllocateGradientMatricesForInputs(ComputationNodeBasePtr parentNode);
 
 public:
@@ -373,6 +473,11 @@ public:
 
     ComputationNodeBasePtr CopyNode(const ComputationNetwork& fromNet, const std::wstring fromName, std::wstring toName, const CopyNodeFlags flags);
     void CopySubTree(const ComputationNetwork& fromNet, const std::wstring fromName, std::wstring toNamePrefix, const CopyNodeFlags flags);
+    ComputationNetworkPtr CloneSharingParameters() const;
+    ComputationNetworkPtr CloneToHost() const;
+private:
+    ComputationNetworkPtr CloneNodes(const std::function<CopyNodeFlags(const ComputationNodeBasePtr&)>& getFlags, int traceLevel) const;
+public:
     void CopyInputs(const std::wstring fromName, std::wstring toName);
     void RenameNode(const std::wstring& nodeNameOrig, const std::wstring& nodeNameNew);
     void RenameNode(ComputationNodeBasePtr node, const std::wstring& newNodeName);
@@ -1009,6 +1114,29 @@ protected:
         {
             SetNodeName(L"Loop_" + m_sourceNode->NodeName());
         }
+
+    private:
+        bool NarrowToActiveSequences(FrameRange& fr) const;
+        const std::vector<std::function<void(size_t)>>& GetCapturedSteps();
+    public:
+        size_t GetNumCapturedGeometries() const { return m_capturedSteps.size(); }
+        size_t GetNumCapturedNodes() const { return m_numCapturedNodes; }
+        size_t GetNumSkippedSequenceSteps() const;
+
+    private:
+
+        std::vector<size_t> m_numActiveSequences; // [t] number of parallel sequences to compute; empty if all (see SetShrinkRecurrentLoops())
+
+        // the captured loop body for a minibatch geometry (see SetCaptureRecurrentSteps())
+        struct CapturedSteps
+        {
+            std::vector<const MatrixBase*> matrices;          // the value matrices of the nested nodes and their inputs, when captured
+            std::vector<std::function<void(size_t)>> steps; // [i] for m_nestedNodes[i]; empty if not captured
+            size_t lastUse;                                  // value of m_numCapturedStepsUses when last used, for dropping the least recently used
+        };
+        std::map<std::pair<size_t, size_t>, CapturedSteps> m_capturedSteps; // [(numParallelSequences, numTimeSteps)]
+        size_t m_numCapturedStepsUses = 0;
+        size_t m_numCapturedNodes = 0; // nested nodes that the last ForwardProp() ran from captured steps
     };
 
     // -----------------------------------------------------------------------
@@ -1064,6 +1192,30 @@ protected:
         // There is currently no other constructor for inner nested PAR-traversed sub-networks, but there will be.
         PARTraversalFlowControlNode(const std::vector<shared_ptr<SEQTraversalFlowControlNode>>& recurrentInfo, const std::list<ComputationNodeBasePtr>& allNodes);
         // Base::m_nestedNodes contains all top-level nodes, in evaluation order
+
+        // gradient checkpointing (see SetRecomputeValues()): nodes whose values are recomputed before Backprop()
+        struct RecomputeSegment
+        {
+            std::vector<ComputationNodeBasePtr> nodes; // in evaluation order
+            ComputationNodeBasePtr recomputeBefore;    // nested node before whose Backprop() the values are recomputed
+            ComputationNodeBasePtr restoreAfter;       // nested node after whose Backprop() the recomputed values are no longer needed
+        };
+        std::vector<RecomputeSegment> m_recomputeSegments;
+
+        size_t GetNumInterOpThreadsUsed() const { return m_numInterOpThreadsUsed; }
+
+    private:
+        bool RunConcurrently(bool forward, const std::function<void(const ComputationNodeBasePtr&)>& runNode);
+        void RecomputeValues(const RecomputeSegment& segment, const FrameRange& fr, NodeProfiler* profiler);
+
+        // for the report of the memory saved against the extra computation, once per allocation
+        bool m_recomputeReported = false;
+        size_t m_recomputedBytes = 0;
+        double m_recomputedFlops = 0;
+
+        // dependency graphs for running the nested nodes concurrently
+        InterOpTaskGraph m_forwardGraph, m_backwardGraph;
+        size_t m_numInterOpThreadsUsed = 1; // by the last RunConcurrently(); 1 if the nodes ran in sequence
     };
 
 public:
@@ -1081,6 +1233,16 @@ public:
     }
 
 private:
+    static size_t s_numInterOpThreads;
+    static bool s_shrinkRecurrentLoops;
+    static bool s_captureRecurrentSteps;
+    static size_t s_maxCapturedGeometries;
+    static bool s_recomputeValues;
+    static size_t s_recomputeSegmentLength;
+    static bool s_fuseElementwiseOps;
+    static bool s_cacheStaticSubgraphs;
+    static bool s_parallelParameterLoading;
+
     DEVICEID_TYPE m_deviceId; // TODO: is this shared by all nodes?
     unsigned long m_randomSeedOffset;
 
@@ -1121,6 +1283,9 @@ private:
 
     std::vector<std::shared_ptr<SEQTraversalFlowControlNode>> m_allSEQNodes; // [loopId] cached set of SEQTraversalFlowControlNodes to allow sharing and idempotence of FormRecurrentLoops()
 
+    // LearnableParameters and the nodes that depend only on them. See DetermineStaticNodes().
+    std::unordered_set<ComputationNodeBasePtr> m_staticNodes;
+
     // cache for evaluation ordering:
     bool m_isCompiled; // CompileNetwork has been called
     bool m_areMatricesAllocated; // AllocateAllMatrices has been called
@@ -97,6 +97,65 @@ void ComputationNetwork::CopySubTree(const ComputationNetwork& fromNet,
     }
 }
 
+// Create a copy of the whole network that shares the value matrices of all LearnableParameters with this one.
+// All other node state, including the matrix pool, is private to the copy, so that copies can be evaluated
+// concurrently. The parameters must not be modified while copies are in use.
+ComputationNetworkPtr ComputationNetwork::CloneSharingParameters() const
+{
+    auto net = CloneNodes([](const ComputationNodeBasePtr& node)
+    {
+        int flags = CopyNodeFlags::copyNodeValue;
+        if (node->OperationName() == OperationNameOf(LearnableParameter))
+            flags |= CopyNodeFlags::copyNodeShareValue;
+        return (CopyNodeFlags)flags;
+    }, TraceLevel());
+    return net;
+}
+
+// Create a copy of the whole network whose persistent values (parameters, precomputed statistics) live in CPU memory,
+// without gradients and minibatch data. This is a consistent snapshot that can be saved while the original keeps
+// training, e.g. for asynchronous checkpointing in SGD.
+ComputationNetworkPtr ComputationNetwork::CloneToHost() const
+{
+    return CloneNodes([](const ComputationNodeBasePtr&)
+    {
+        return (CopyNodeFlags)(CopyNodeFlags::copyNodeValue | CopyNodeFlags::copyNodeValueToHost);
+    }, /*traceLevel=*/0); // the copy gets validated again; no need to log that
+}
+
+// helper of the above: duplicate all nodes with the given flags, link them like the originals, and compile the copy
+ComputationNetworkPtr ComputationNetwork::CloneNodes(const function<CopyNodeFlags(const ComputationNodeBasePtr&)>& getFlags, int traceLevel) const
+{
+    auto net = make_shared<ComputationNetwork>(m_deviceId);
+    net->SetTraceLevel(traceLevel);
+    net->SetRandomSeedOffset(GetRandomSeedOffset());
+
+    for (const auto& iter : m_nameToNodeMap)
+    {
+        const auto& fromNode = iter.second;
+        net->AddNodeToNet(fromNode->Duplicate(fromNode->NodeName(), getFlags(fromNode)));
+    }
+
+    // link the copies the same way as the originals
+    for (const auto& iter : m_nameToNodeMap)
+    {
+        const auto& fromNode = iter.second;
+        vector<ComputationNodeBasePtr> inputs;
+        for (const auto& input : fromNode->GetInputs())
+            inputs.push_back(net->GetNodeFromName(input->NodeName()));
+        net->GetNodeFromName(fromNode->NodeName())->AttachInputs(inputs);
+    }
+
+    auto fromGroups = const_cast<ComputationNetwork*>(this)->GetAllNodeGroups();
+    auto toGroups = net->GetAllNodeGroups();
+    for (size_t i = 0; i < fromGroups.size(); i++)
+        for (const auto& node : *fromGroups[i])
+            toGroups[i]->push_back(net->GetNodeFromName(node->NodeName()));
+
+    net->CompileNetwork();
+    return net;
+}
+
 // you can only copy inputs from nodes in the same network
 void ComputationNetwork::CopyInputs(const std::wstring fromName, std::wstring toName)
 {
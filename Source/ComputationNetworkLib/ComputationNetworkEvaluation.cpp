@@ -10,12 +10,17 @@
 #include "ComputationNetwork.h"
 #include "RecurrentNodes.h"
 #include "InputAndParamNodes.h"
+#include "TrainingNodes.h"
+#include "NodeProfiler.h"
+#include "InterOpScheduler.h"
+#include "ElementwiseFusion.h"
 #include <string>
 #include <vector>
 #include <list>
 #include <set>
 #include <algorithm>
 #include <map>
+#include <math.h>
 
 using namespace std;
 
@@ -115,6 +120,60 @@ ComputationNodeBasePtr ComputationNetwork::GetNestedNetwork(const ComputationNod
 
 template<class ElemType> static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient);
 
+// the node profiler if profiling is enabled (see ComputationEnvironment::nodeProfiler), else nullptr
+// (SEQ sentinel nodes have no environment, so we look for the first node that has one)
+static NodeProfiler* GetNodeProfiler(const std::vector<ComputationNodeBasePtr>& nodes)
+{
+    for (auto& node : nodes)
+    {
+        if (node->GetEnvironmentPtr())
+            return node->Environment().nodeProfiler.get();
+    }
+    return nullptr;
+}
+
+// profile a call of a node in PAR mode
+// A recurrent loop is traced as a whole; its nodes are recorded individually by the SEQTraversalFlowControlNode.
+static void ProfilePARNode(NodeProfiler& profiler, const ComputationNodeBasePtr& node, NodeProfiler::Pass pass, NodeProfiler::Clock::time_point begin)
+{
+    auto end = NodeProfiler::Clock::now();
+    profiler.Trace(node, pass, begin, end);
+    if (!dynamic_pointer_cast<FlowControlNode>(node))
+        profiler.Record(node, pass, end - begin);
+}
+
+// elementwise fusion (see ElementwiseFusion.h): the head of a fused expression computes all of it, and the nodes fused into it do nothing
+static void ForwardPropNodeOrFusion(const ComputationNodeBasePtr& node, const FrameRange& fr)
+{
+    if (node->GetElementwiseFusion())
+        node->GetElementwiseFusion()->ForwardProp(fr);
+    else if (!node->IsFusedIntoConsumer())
+        node->ForwardProp(fr);
+}
+
+static void BackpropNodeOrFusion(const ComputationNodeBasePtr& node, const FrameRange& fr, bool childrenInThisLoop, bool childrenInOuterLoop)
+{
+    if (node->GetElementwiseFusion())
+        node->GetElementwiseFusion()->Backprop(fr, childrenInThisLoop, childrenInOuterLoop);
+    else if (!node->IsFusedIntoConsumer())
+        node->Backprop(fr, childrenInThisLoop, childrenInOuterLoop);
+}
+
+// the head of a fused expression writes the gradients of the expression's inputs
+static void AllocateGradientMatricesForInputsOfNodeOrFusion(const ComputationNodeBasePtr& node, MatrixPool& matrixPool)
+{
+    if (node->GetElementwiseFusion())
+    {
+        for (const auto& input : node->GetElementwiseFusion()->GetInputs())
+        {
+            if (input->NeedsGradient())
+                input->RequestMatricesBeforeBackprop(matrixPool);
+        }
+    }
+    else if (!node->IsFusedIntoConsumer())
+        node->AllocateGradientMatricesForInputs(matrixPool);
+}
+
 ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(const std::vector<shared_ptr<SEQTraversalFlowControlNode>>& recurrentInfo, const std::list<ComputationNodeBasePtr>& allNodes /*must be in eval order*/)
 {
     // traverse the network in evaluation order and create a new list that replaces all recurrence by a SEQTraversalFlowControlNode
@@ -144,7 +203,8 @@ ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(con
 }
 /*virtual*/ void ComputationNetwork::PARTraversalFlowControlNode::ForwardProp(const FrameRange& fr) /*override*/
 {
-    for (auto& node : m_nestedNodes)
+    auto profiler = GetNodeProfiler(m_nestedNodes);
+    auto forwardProp = [&](const ComputationNodeBasePtr& node)
     {
 #if 0
         if (dynamic_pointer_cast<LearnableParameter<float>>(node))
@@ -152,36 +212,271 @@ ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(con
 #endif
         if (node->IsOutOfDateWrtInputs())
         {
+            auto begin = profiler ? NodeProfiler::Clock::now() : NodeProfiler::Clock::time_point();
+
             node->BeginForwardProp();
-            node->ForwardProp(fr.WithLayout(node->GetMBLayout()));
+            ForwardPropNodeOrFusion(node, fr.WithLayout(node->GetMBLayout()));
             node->EndForwardProp();
 
             node->BumpEvalTimeStamp();
+
+            if (profiler)
+                ProfilePARNode(*profiler, node, NodeProfiler::Pass::forward, begin);
         }
 
         // more extreme tracing for the ultimate debugging experience. Make space on your disk.
         if (node->GetEnvironmentPtr() && node->Environment().traceLevel >= 1000000) // very high number, since this spews like hell
             DumpNode<float>(node, /*dumpGradient=*/false) || DumpNode<double>(node, false);
+    };
+
+    if (!RunConcurrently(/*forward=*/true, forwardProp))
+    {
+        for (auto& node : m_nestedNodes)
+            forwardProp(node);
     }
 }
 
 /*virtual*/ void ComputationNetwork::PARTraversalFlowControlNode::Backprop(const FrameRange& fr, bool childrenInThisLoop, bool childrenInOuterLoop) /*override*/
 {
     childrenInThisLoop, childrenInOuterLoop; // TODO: think through what these mean when coming from PAR mode
-    // process nodes in pre-determined order
-    for (auto pnode = m_nestedNodes.rbegin(); pnode != m_nestedNodes.rend(); pnode++) // iterate backwards over evaluation order
+    auto profiler = GetNodeProfiler(m_nestedNodes);
+    auto backprop = [&](const ComputationNodeBasePtr& node)
     {
-        auto& node = *pnode;
+        auto begin = profiler ? NodeProfiler::Clock::now() : NodeProfiler::Clock::time_point();
 
         node->BeginBackprop();
-        node->Backprop(fr.WithLayout(node->GetMBLayout()), true /*childrenInThisLoop*/, true /*childrenInOuterLoop*/);
+        BackpropNodeOrFusion(node, fr.WithLayout(node->GetMBLayout()), true /*childrenInThisLoop*/, true /*childrenInOuterLoop*/);
         node->EndBackprop();
 
+        if (profiler)
+            ProfilePARNode(*profiler, node, NodeProfiler::Pass::backward, begin);
+
         // more extreme tracing for the ultimate debugging experience. Make space on your disk.
         if (node->GetEnvironmentPtr() && node->Environment().traceLevel >= 1000000 && node->NeedsGradient()) // very high number, since this spews like hell
             DumpNode<float>(node, /*dumpGradient=*/true) || DumpNode<double>(node, true);
+    };
+
+    // process nodes in pre-determined order
+    // Values are recomputed at specific points of that order, so with gradient checkpointing, nodes are not run concurrently.
+    if (!m_recomputeSegments.empty() || !RunConcurrently(/*forward=*/false, backprop))
+    {
+        for (auto pnode = m_nestedNodes.rbegin(); pnode != m_nestedNodes.rend(); pnode++) // iterate backwards over evaluation order
+        {
+            for (const auto& segment : m_recomputeSegments)
+            {
+                if (segment.recomputeBefore == *pnode)
+                    RecomputeValues(segment, fr, profiler);
+            }
+
+            backprop(*pnode);
+
+            for (const auto& segment : m_recomputeSegments) // swap back the original value matrices for the next forward prop
+            {
+                if (segment.restoreAfter == *pnode)
+                {
+                    for (const auto& node : segment.nodes)
+                        node->SwapRecomputedValue();
+                }
+            }
+        }
+    }
+
+    if (!m_recomputeSegments.empty() && !m_recomputeReported)
+    {
+        size_t numRecomputed = 0;
+        for (const auto& segment : m_recomputeSegments)
+            numRecomputed += segment.nodes.size();
+        double forwardFlops = 0;
+        for (const auto& node : m_nestedNodes)
+        {
+            auto loop = dynamic_pointer_cast<SEQTraversalFlowControlNode>(node);
+            for (const auto& member : loop ? loop->m_nestedNodes : vector<ComputationNodeBasePtr>{ node })
+            {
+                if (!member->IsLeaf())
+                    forwardFlops += NodeProfiler::EstimateFlops(member, NodeProfiler::Pass::forward);
+            }
+        }
+        fprintf(stderr, "Gradient checkpointing: %d node values in %d segments are recomputed for backprop. In the first minibatch, this avoided keeping %.2f MB from forward prop to backprop, at the cost of %.3f GFLOP (%.1f%% of forward prop).\n",
+                (int)numRecomputed, (int)m_recomputeSegments.size(), m_recomputedBytes / (1024.0 * 1024.0),
+                m_recomputedFlops * 1e-9, forwardFlops > 0 ? 100 * m_recomputedFlops / forwardFlops : 0.0);
+        m_recomputeReported = true;
+    }
+}
+
+size_t ComputationNetwork::GetNumRecomputeSegments() const
+{
+    size_t numSegments = 0;
+    for (const auto& nestedNetwork : m_nestedNetworks)
+        numSegments += dynamic_pointer_cast<PARTraversalFlowControlNode>(nestedNetwork.second)->m_recomputeSegments.size();
+    return numSegments;
+}
+
+template <class ElemType>
+static bool TryGetValueBytes(const ComputationNodeBasePtr& nodep, size_t& bytes)
+{
+    auto node = dynamic_pointer_cast<ComputationNode<ElemType>>(nodep);
+    if (!node)
+        return false;
+    bytes = node->Value().BufferSize();
+    return true;
+}
+
+// gradient checkpointing: compute the values of a segment's nodes again, into the matrices set aside for that (see PlanRecomputeSegments())
+// The inputs from outside the segment have been kept since forward prop, or are recomputed in the segment before.
+void ComputationNetwork::PARTraversalFlowControlNode::RecomputeValues(const RecomputeSegment& segment, const FrameRange& fr, NodeProfiler* profiler)
+{
+    for (const auto& node : segment.nodes)
+    {
+        auto begin = profiler ? NodeProfiler::Clock::now() : NodeProfiler::Clock::time_point();
+
+        node->SwapRecomputedValue();
+        node->BeginForwardProp();
+        node->ForwardProp(fr.WithLayout(node->GetMBLayout()));
+        node->EndForwardProp();
+
+        if (profiler) // (this counts as another forward call of the node)
+            ProfilePARNode(*profiler, node, NodeProfiler::Pass::forward, begin);
+
+        if (!m_recomputeReported)
+        {
+            size_t bytes = 0;
+            TryGetValueBytes<float>(node, bytes) || TryGetValueBytes<double>(node, bytes);
+            m_recomputedBytes += bytes;
+            m_recomputedFlops += NodeProfiler::EstimateFlops(node, NodeProfiler::Pass::forward);
+        }
     }
 }
+
+// the nodes whose values a node reads in ForwardProp(), and whose gradients it writes in Backprop(), for building an InterOpTaskGraph
+// The head of a fused expression reads the inputs of the expression instead (see ElementwiseFusion.h).
+static vector<ComputationNodeBasePtr> GetInputsOfNodeOrFusion(const ComputationNodeBasePtr& node)
+{
+    vector<ComputationNodeBasePtr> inputs = node->GetInputs();
+    if (node->GetElementwiseFusion())
+        inputs.insert(inputs.end(), node->GetElementwiseFusion()->GetInputs().begin(), node->GetElementwiseFusion()->GetInputs().end());
+    return inputs;
+}
+
+size_t ComputationNetwork::s_numInterOpThreads = 1;
+bool ComputationNetwork::s_shrinkRecurrentLoops = false;
+bool ComputationNetwork::s_captureRecurrentSteps = false;
+size_t ComputationNetwork::s_maxCapturedGeometries = 64;
+bool ComputationNetwork::s_recomputeValues = false;
+size_t ComputationNetwork::s_recomputeSegmentLength = 0;
+bool ComputationNetwork::s_fuseElementwiseOps = false;
+bool ComputationNetwork::s_cacheStaticSubgraphs = false;
+
+// run the nested nodes on the inter-op threads in an order that respects their dependencies (see InterOpScheduler.h)
+// Returns false if they should be run in sequence instead, i.e. if inter-op parallelism is disabled, a node is not
+// on the CPU, or there is nothing that could run concurrently.
+bool ComputationNetwork::PARTraversalFlowControlNode::RunConcurrently(bool forward, const std::function<void(const ComputationNodeBasePtr&)>& runNode)
+{
+    m_numInterOpThreadsUsed = 1;
+    size_t numThreads = GetNumInterOpThreads();
+    size_t numTasks = m_nestedNodes.size();
+    if (numThreads <= 1 || numTasks < 2)
+        return false;
+
+    // one task per nested node (a recurrent loop is one task); in sequential order, which is reverse for backprop
+    auto taskNode = [&](size_t task) -> const ComputationNodeBasePtr& { return m_nestedNodes[forward ? task : numTasks - 1 - task]; };
+    for (size_t task = 0; task < numTasks; task++)
+    {
+        const auto& node = taskNode(task);
+        auto loop = dynamic_pointer_cast<SEQTraversalFlowControlNode>(node);
+        for (const auto& member : loop ? loop->m_nestedNodes : vector<ComputationNodeBasePtr>{ node })
+        {
+            if (member->GetDeviceId() != CPUDEVICE)
+                return false;
+        }
+    }
+
+    // The graph depends on the network structure only, so it is built once. Matrices cannot alias between nodes
+    // other than through their inputs, since the matrix pool does not share matrices with inter-op threads (see AllocateAllMatrices()).
+    auto& graph = forward ? m_forwardGraph : m_backwardGraph;
+    if (graph.GetNumTasks() != numTasks)
+    {
+        unordered_map<const ComputationNodeBase*, size_t> nodeTasks;
+        for (size_t task = 0; task < numTasks; task++)
+        {
+            const auto& node = taskNode(task);
+            auto loop = dynamic_pointer_cast<SEQTraversalFlowControlNode>(node);
+            for (const auto& member : loop ? loop->m_nestedNodes : vector<ComputationNodeBasePtr>{ node })
+                nodeTasks[member.get()] = task;
+        }
+
+        // ForwardProp() reads the values of the inputs, hence runs after them. Backprop() reads the gradient, which the
+        // consumers of the node write, and accumulates into the gradients of the inputs, so all tasks that write the same
+        // gradient run in their sequential order.
+        // Reading an input with an MBLayout may also write it: nodes that reduce over frames, such as SumElements, Times or
+        // a fused expression, set the gaps of the input's value to zero first (MaskMissingValueColumnsToZero()). Hence all
+        // tasks that read the same such input run in their sequential order as well.
+        graph.Init(numTasks);
+        unordered_map<const ComputationNodeBase*, size_t> lastGradientWriter;
+        unordered_map<const ComputationNodeBase*, size_t> lastSequenceReader;
+        for (size_t task = 0; task < numTasks; task++)
+        {
+            const auto& node = taskNode(task);
+            auto loop = dynamic_pointer_cast<SEQTraversalFlowControlNode>(node);
+            for (const auto& member : loop ? loop->m_nestedNodes : vector<ComputationNodeBasePtr>{ node })
+            {
+                for (const auto& input : GetInputsOfNodeOrFusion(member))
+                {
+                    auto inputTask = nodeTasks.find(input.get());
+                    if (inputTask == nodeTasks.end() || inputTask->second == task)
+                        continue;
+                    graph.AddDependency(min(inputTask->second, task), max(inputTask->second, task));
+                    if (!forward)
+                    {
+                        auto writer = lastGradientWriter.find(input.get());
+                        if (writer != lastGradientWriter.end() && writer->second != task)
+                            graph.AddDependency(writer->second, task);
+                        lastGradientWriter[input.get()] = task;
+                    }
+                    else if (input->HasMBLayout())
+                    {
+                        auto reader = lastSequenceReader.find(input.get());
+                        if (reader != lastSequenceReader.end() && reader->second != task)
+                            graph.AddDependency(reader->second, task);
+                        lastSequenceReader[input.get()] = task;
+                    }
+                }
+            }
+        }
+    }
+    if (graph.IsSequential())
+        return false;
+
+    // Masking gaps uses the validity mask of the layout, which MBLayout creates on first use. Nodes that share the layout
+    // but not an input may run concurrently, so it is created here.
+    std::set<MBLayoutPtr> layouts;
+    for (size_t task = 0; task < numTasks; task++)
+    {
+        const auto& node = taskNode(task);
+        auto loop = dynamic_pointer_cast<SEQTraversalFlowControlNode>(node);
+        for (const auto& member : loop ? loop->m_nestedNodes : vector<ComputationNodeBasePtr>{ node })
+        {
+            layouts.insert(member->GetMBLayout());
+            for (const auto& input : GetInputsOfNodeOrFusion(member))
+                layouts.insert(input->GetMBLayout());
+        }
+    }
+    for (const auto& layout : layouts)
+    {
+        if (layout && layout->HasGaps())
+            layout->GetColumnsValidityMask(CPUDEVICE);
+    }
+
+    m_numInterOpThreadsUsed = InterOpScheduler::Run(graph, numThreads, [&](size_t task) { runNode(taskNode(task)); });
+    return true;
+}
+
+size_t ComputationNetwork::GetNumInterOpThreadsUsed() const
+{
+    size_t numThreads = 1;
+    for (const auto& nestedNetwork : m_nestedNetworks)
+        numThreads = max(numThreads, dynamic_pointer_cast<PARTraversalFlowControlNode>(nestedNetwork.second)->GetNumInterOpThreadsUsed());
+    return numThreads;
+}
 /*virtual*/ void ComputationNetwork::PARTraversalFlowControlNode::RequestMatricesBeforeForwardProp(MatrixPool& matrixPool) /*override*/
 {
 }
@@ -212,7 +507,7 @@ ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(con
         if (node->IsOutOfDateWrtInputs() && enableForward)
         {
             node->BeginForwardProp();
-            node->ForwardProp(fr.WithLayout(node->GetMBLayout()));
+            ForwardPropNodeOrFusion(node, fr.WithLayout(node->GetMBLayout()));
             node->EndForwardProp();
 
             node->BumpEvalTimeStamp();
@@ -265,11 +560,123 @@ static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient)
                        m_nestedNodes[0]->NodeName().c_str(), m_nestedNodes[0]->GetMBLayoutAxisString().c_str());
     }
 
+    // determine how many parallel sequences each time step must be computed for
+    // If the reader sorted the parallel sequences by length (see MBLayout::InitAsPackedSequences()), this skips all gaps after sequences have ended.
+    m_numActiveSequences.clear();
+    if (GetShrinkRecurrentLoops())
+    {
+        GetMBLayout()->GetNumActiveParallelSequences(m_numActiveSequences);
+        size_t numParallelSequences = GetMBLayout()->GetNumParallelSequences();
+        if (all_of(m_numActiveSequences.begin(), m_numActiveSequences.end(), [numParallelSequences](size_t n) { return n == numParallelSequences; }))
+            m_numActiveSequences.clear(); // nothing to skip
+    }
+
     // tell all that loop is about to commence
     for (auto& node : m_nestedNodes)
         node->BeginForwardProp();
 }
 
+// narrow the frame range of a time step to the parallel sequences that are active (see SetShrinkRecurrentLoops())
+// Returns false if no sequence is active, in which case the time step can be skipped altogether.
+bool ComputationNetwork::SEQTraversalFlowControlNode::NarrowToActiveSequences(FrameRange& fr) const
+{
+    if (m_numActiveSequences.empty())
+        return true;
+    size_t numActive = m_numActiveSequences[fr.t()];
+    if (numActive < GetMBLayout()->GetNumParallelSequences())
+        fr = fr.WithSequencePrefix(numActive);
+    return numActive > 0;
+}
+
+// the number of (sequence, time step) pairs that the last minibatch did not compute (see SetShrinkRecurrentLoops())
+size_t ComputationNetwork::SEQTraversalFlowControlNode::GetNumSkippedSequenceSteps() const
+{
+    size_t numSkipped = 0;
+    for (size_t numActive : m_numActiveSequences)
+        numSkipped += GetMBLayout()->GetNumParallelSequences() - numActive;
+    return numSkipped;
+}
+
+// the loop body captured for the current minibatch geometry (see SetCaptureRecurrentSteps()); empty if steps are not captured
+// A captured step only depends on the number of parallel sequences and time steps, and on the value matrices that it slices (see
+// CaptureForwardStep()). Hence the loop body is kept for each geometry, and only captured again if one of these matrices has been
+// replaced since. Only recurrent loops have such per-minibatch setup: the inter-op task graphs of PAR nodes depend on the network
+// structure alone and are built once (see RunConcurrently()). Nodes of a fused expression are not captured; the head runs the
+// expression (see ElementwiseFusion.h).
+const vector<function<void(size_t)>>& ComputationNetwork::SEQTraversalFlowControlNode::GetCapturedSteps()
+{
+    static const vector<function<void(size_t)>> noCapturedSteps;
+    if (!GetCaptureRecurrentSteps() || !m_numActiveSequences.empty())
+        return noCapturedSteps;
+
+    vector<const MatrixBase*> matrices;
+    for (const auto& node : m_nestedNodes)
+    {
+        matrices.push_back(node->ValuePtr().get());
+        for (const auto& input : node->GetInputs())
+            matrices.push_back(input->ValuePtr().get());
+    }
+
+    auto geometry = make_pair(GetMBLayout()->GetNumParallelSequences(), GetMBLayout()->GetNumTimeSteps());
+    auto iter = m_capturedSteps.find(geometry);
+    if (iter != m_capturedSteps.end() && iter->second.matrices == matrices)
+    {
+        iter->second.lastUse = ++m_numCapturedStepsUses;
+        return iter->second.steps;
+    }
+
+    // the number of geometries is bounded, in case every minibatch has a different one; the least recently used is dropped
+    if (iter == m_capturedSteps.end())
+    {
+        while (m_capturedSteps.size() >= max(GetMaxCapturedGeometries(), (size_t)1))
+        {
+            auto leastRecentlyUsed = m_capturedSteps.begin();
+            for (auto other = m_capturedSteps.begin(); other != m_capturedSteps.end(); other++)
+            {
+                if (other->second.lastUse < leastRecentlyUsed->second.lastUse)
+                    leastRecentlyUsed = other;
+            }
+            m_capturedSteps.erase(leastRecentlyUsed);
+        }
+    }
+
+    auto& captured = m_capturedSteps[geometry];
+    captured.lastUse = ++m_numCapturedStepsUses;
+    captured.matrices.swap(matrices);
+    captured.steps.assign(m_nestedNodes.size(), nullptr);
+    for (size_t i = 0; i < m_nestedNodes.size(); i++)
+    {
+        if (!m_nestedNodes[i]->GetElementwiseFusion() && !m_nestedNodes[i]->IsFusedIntoConsumer())
+            captured.steps[i] = m_nestedNodes[i]->CaptureForwardStep();
+    }
+    return captured.steps;
+}
+
+// the number of minibatch geometries for which loop bodies are captured, summed over all loops (see SetCaptureRecurrentSteps())
+size_t ComputationNetwork::GetNumCapturedGeometries() const
+{
+    size_t numGeometries = 0;
+    for (const auto& loop : m_allSEQNodes)
+        numGeometries += loop->GetNumCapturedGeometries();
+    return numGeometries;
+}
+
+size_t ComputationNetwork::GetNumSkippedSequenceSteps() const
+{
+    size_t numSkipped = 0;
+    for (const auto& loop : m_allSEQNodes)
+        numSkipped += loop->GetNumSkippedSequenceSteps();
+    return numSkipped;
+}
+
+size_t ComputationNetwork::GetNumCapturedNodes() const
+{
+    size_t numNodes = 0;
+    for (const auto& loop : m_allSEQNodes)
+        numNodes += loop->GetNumCapturedNodes();
+    return numNodes;
+}
+
 // evaluation of a SEQTraversalFlowControlNode FlowControlNode
 // This evaluates all nodes in this FlowControlNode in SEQ mode: process the loop frame by frame in a nested loop.
 // This is where the time axis changes.
@@ -283,13 +690,50 @@ static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient)
     // for every time step run through all nodes in this particular loop (treat the loop like a little ComputationNetwork)
     // Note: Currently, this is limited to linear-time loops. But nothing stops the iteration below to, e.g., be a 2D iteration over an image
     // if we implement an according FrameRangeIteration.
+    // When profiling, the time of each node is summed up over all time steps.
+    auto profiler = GetNodeProfiler(m_nestedNodes);
+    vector<NodeProfiler::Clock::duration> durations(profiler ? m_nestedNodes.size() : 0, NodeProfiler::Clock::duration::zero());
+
+    // the captured loop body for this minibatch's geometry (see SetCaptureRecurrentSteps())
+    // Nodes that cannot be captured are run through ForwardProp(). Time steps narrowed to the active sequences are not captured.
+    const auto& capturedSteps = GetCapturedSteps();
+    m_numCapturedNodes = count_if(capturedSteps.begin(), capturedSteps.end(), [](const function<void(size_t)>& step) { return (bool)step; });
+
     FrameRangeIteration range(GetMBLayout(), m_steppingDirection);
     for (auto t = range.begin(); t != range.end(); t++)
+    {
+        FrameRange fr = t;
+        if (!NarrowToActiveSequences(fr))
+            continue;
+        for (size_t i = 0; i < m_nestedNodes.size(); i++)
+        {
+            auto& node = m_nestedNodes[i];
+            auto begin = profiler ? NodeProfiler::Clock::now() : NodeProfiler::Clock::time_point();
+
+            if (!capturedSteps.empty() && capturedSteps[i])
+                capturedSteps[i](fr.t());
+            else
+                ForwardPropNodeOrFusion(node, fr);
+
+            if (profiler)
+                durations[i] += NodeProfiler::Clock::now() - begin;
+        }
+    }
+
+    // (once rather than in every step; this yields the same order)
+    for (auto& node : m_nestedNodes)
+        node->BumpEvalTimeStamp();
+
+    for (size_t i = 0; i < durations.size(); i++)
+        profiler->Record(m_nestedNodes[i], NodeProfiler::Pass::forward, durations[i]);
+
+    // the frames that were skipped are gaps; zero them, since they may hold anything (e.g. stale values from a previous minibatch)
+    if (!m_numActiveSequences.empty())
     {
         for (auto& node : m_nestedNodes)
         {
-            node->ForwardProp(t);
-            node->BumpEvalTimeStamp();
+            if (!node->IsFusedIntoConsumer())
+                node->MaskMissingValueColumnsToZero(FrameRange(GetMBLayout()));
         }
     }
 }
@@ -313,17 +757,28 @@ static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient)
     childrenInThisLoop, childrenInOuterLoop;    // TODO: think through what these mean when coming from PAR mode
     const auto& recurrentNodes = m_nestedNodes; // BUGBUG: -ForForward?? Does this mean we can remove non-ForForward?
     auto pMBLayout = recurrentNodes[0]->GetMBLayout();
+    auto profiler = GetNodeProfiler(recurrentNodes);
+    vector<NodeProfiler::Clock::duration> durations(profiler ? recurrentNodes.size() : 0, NodeProfiler::Clock::duration::zero());
     FrameRangeIteration range(pMBLayout, m_steppingDirection);
     for (auto t = range.rbegin(); t != range.rend(); t++) // note: reverse iteration
     {
-        for (auto nodeIter2 = recurrentNodes.rbegin(); nodeIter2 != recurrentNodes.rend(); ++nodeIter2)
+        FrameRange fr = t;
+        if (!NarrowToActiveSequences(fr))
+            continue;
+        for (size_t i = recurrentNodes.size(); i-- > 0;)
         {
-            auto& node2 = *nodeIter2;
-            node2->Backprop(t, true /*childrenInThisLoop*/, false /*childrenInOuterLoop*/);
+            auto& node2 = recurrentNodes[i];
+            auto begin = profiler ? NodeProfiler::Clock::now() : NodeProfiler::Clock::time_point();
+            BackpropNodeOrFusion(node2, fr, true /*childrenInThisLoop*/, false /*childrenInOuterLoop*/);
             // The above flags tell Backprop() to skip back-propagation from inside a node into
             // a node that is outside the loop, which is done later in EndBackprop() in PAR mode.
+            if (profiler)
+                durations[i] += NodeProfiler::Clock::now() - begin;
         }
     }
+
+    for (size_t i = 0; i < durations.size(); i++)
+        profiler->Record(recurrentNodes[i], NodeProfiler::Pass::backward, durations[i]);
 }
 
 // called after last iteration step of ComputeGradient()
@@ -331,10 +786,14 @@ static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient)
 {
     // The following loop handles the case that a node inside the loop back-propagates a gradient into a node outside of the loop.
     // For efficiency, we perform this outside the loop in PAR mode. E.g., in one LSTM speech setup, we measured 12..14% overall speed-up.
+    auto profiler = GetNodeProfiler(m_nestedNodes);
     for (auto nodeIter2 = m_nestedNodes.rbegin(); nodeIter2 != m_nestedNodes.rend(); ++nodeIter2)
     {
         auto& node2 = *nodeIter2;
-        node2->Backprop(FrameRange(m_nestedNodes[0]->GetMBLayout()), false /*childrenInThisLoop*/, true /*childrenInOuterLoop*/);
+        auto begin = profiler ? NodeProfiler::Clock::now() : NodeProfiler::Clock::time_point();
+        BackpropNodeOrFusion(node2, FrameRange(m_nestedNodes[0]->GetMBLayout()), false /*childrenInThisLoop*/, true /*childrenInOuterLoop*/);
+        if (profiler) // (part of the call that Backprop() above has recorded)
+            profiler->Record(node2, NodeProfiler::Pass::backward, NodeProfiler::Clock::now() - begin, /*countCall=*/false);
     }
 
     // tell all nodes we are done for this iteraTion
@@ -355,7 +814,7 @@ static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient)
     // TODO: should we deallocate in opposite order?
     for (auto nodeIter = m_nestedNodes.rbegin(); nodeIter != m_nestedNodes.rend(); ++nodeIter)
     {
-        (*nodeIter)->AllocateGradientMatricesForInputs(matrixPool);
+        AllocateGradientMatricesForInputsOfNodeOrFusion(*nodeIter, matrixPool);
     }
 }
 /*virtual*/ void ComputationNetwork::SEQTraversalFlowControlNode::RequestMatricesBeforeBackprop(MatrixPool& matrixPool) /*override*/
@@ -403,10 +862,17 @@ bool ComputationNetwork::SEQTraversalFlowControlNode::IsOutOfDateWrtInputs() con
 }
 
 // TODO: do this on PARTraversalFlowControlNode
+// With SetCacheStaticSubgraphs(), the static nodes keep their time stamps, so their values are only recomputed when a parameter
+// has changed since. All other nodes are marked outdated w.r.t. all time stamps, so they are recomputed even if their inputs are static.
 void ComputationNetwork::ResetEvalTimeStamps()
 {
     for (auto nodeIter = m_nameToNodeMap.begin(); nodeIter != m_nameToNodeMap.end(); nodeIter++)
-        nodeIter->second->ResetEvalTimeStamp();
+    {
+        if (!GetCacheStaticSubgraphs())
+            nodeIter->second->ResetEvalTimeStamp();
+        else if (m_staticNodes.find(nodeIter->second) == m_staticNodes.end())
+            nodeIter->second->SetEvalTimeStampOutdatedWrtAll();
+    }
 }
 
 /*static*/ void ComputationNetwork::BumpEvalTimeStamp(const vector<ComputationNodeBasePtr>& nodes)
@@ -454,6 +920,7 @@ void ComputationNetwork::InvalidateCompiledNetwork()
     m_nestedNetworks.clear();
     m_inputValues.clear();
     m_learnableParameters.clear();
+    m_staticNodes.clear();
 }
 
 // verify that network has undergone CompileNetwork()
@@ -523,7 +990,7 @@ void ComputationNetwork::CompileNetwork()
     ValidateNetwork();
 
     // STEP: Optimize the network.
-    // :)
+    DetermineStaticNodes();
 
     // STEP: Some final details.
     ResetEvalTimeStamps(); // invalidate all m_value fields. Really belongs into StartEvaluateMinibatchLoop()
@@ -883,6 +1350,31 @@ void ComputationNetwork::MarkValueNonSharableNodes()
     }
 }
 
+// static subgraphs (see SetCacheStaticSubgraphs()): determine the LearnableParameters and the nodes that depend only on them
+// This includes constants, which are LearnableParameters that are not updated. Nodes that draw random numbers or that are part of
+// a recurrent loop are not static, nor are PreComputeNodes, whose values change while they accumulate. The static nodes that are
+// computed are marked outdated, so that they are computed at least once after this.
+void ComputationNetwork::DetermineStaticNodes()
+{
+    m_staticNodes.clear();
+    for (const auto& node : GetEvalOrder(nullptr))
+    {
+        bool isStatic;
+        if (node->IsLeaf())
+            isStatic = node->OperationName() == OperationNameOf(LearnableParameter);
+        else
+        {
+            const auto& inputs = node->GetInputs();
+            isStatic = !node->Is<IRngUser>() && !node->Is<IPreComputeNode>() && !node->IsPartOfLoop() && !node->HasMBLayout() &&
+                       all_of(inputs.begin(), inputs.end(), [this](const ComputationNodeBasePtr& input) { return m_staticNodes.find(input) != m_staticNodes.end(); });
+            if (isStatic)
+                node->SetEvalTimeStampOutdatedWrtAll();
+        }
+        if (isStatic)
+            m_staticNodes.insert(node);
+    }
+}
+
 // print memory-sharing information to log
 void ComputationNetwork::PrintMemorySharingStructure(const vector<ComputationNodeBasePtr>& nodes)
 {
@@ -950,6 +1442,18 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
 
     VerifyIsCompiled("AllocateAllMatrices");
 
+    // Nodes that run concurrently on the inter-op threads must not get matrices that another one released, since the
+    // order in which they run is not known here. This costs the memory that sharing would save, which is all that
+    // gradient checkpointing and the compact activation stash are for; hence these are not combined with it.
+    bool concurrent = GetNumInterOpThreads() > 1 && m_deviceId == CPUDEVICE;
+    if (concurrent && trainRootNode != nullptr && (GetRecomputeValues() || ComputationNodeBase::GetCompressActivationStash()))
+        InvalidArgument("AllocateAllMatrices: interOpThreads > 1 cannot be combined with recomputeValues or compressActivationStash on the CPU, "
+                        "since concurrent nodes do not share matrices, so these would not save any memory.");
+    if (concurrent)
+        fprintf(stderr, "WARNING: Node values and gradients do not share matrices, since nodes run concurrently on %d inter-op threads. This increases memory use.\n",
+                (int)GetNumInterOpThreads());
+    m_matrixPool.SetMemSharing(!concurrent);
+
     std::vector<ComputationNodeBasePtr> forwardPropRoots;
     forwardPropRoots.insert(forwardPropRoots.end(), evalRootNodes.begin(), evalRootNodes.end());
     forwardPropRoots.insert(forwardPropRoots.end(), outValueRootNodes.begin(), outValueRootNodes.end());
@@ -966,25 +1470,53 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
     bool performingBackPropagation = (trainRootNode != nullptr);
 
     // Create a composite Eval order with the specified nodes as roots
-    // For each node determine parents and whether the output of the
-    // node is needed during back propagation
-    std::unordered_map<ComputationNodeBasePtr, bool> outputValueNeededDuringBackProp;
+    // For each node determine parents
     std::unordered_map<ComputationNodeBasePtr, std::unordered_set<ComputationNodeBasePtr>> parentsMap;
     for (auto& rootNode : forwardPropRoots)
+    {
+        for (const auto& node : GetEvalOrder(rootNode))
+        {
+            for (int i = 0; i < node->GetNumInputs(); i++)
+                parentsMap[node->GetInputs()[i]].insert(node);
+        }
+    }
+
+    // Construct the composite forward prop eval order by enumerating the
+    // nodes corresponding to each of our roots and then arranging them in the
+    // relative order that they appear in the global evaluation order
+    const std::list<ComputationNodeBasePtr>& allNodesEvalOrder = GetEvalOrder(nullptr);
+    std::list<ComputationNodeBasePtr> nodesForForwardPropRoots = ComputationNodeBase::EnumerateNodes(forwardPropRoots);
+    std::vector<ComputationNodeBasePtr> compositeForwardPropEvalOrder;
+    for (auto& node : allNodesEvalOrder)
+    {
+        if (std::find(nodesForForwardPropRoots.cbegin(), nodesForForwardPropRoots.cend(), node) != nodesForForwardPropRoots.cend())
+        {
+            compositeForwardPropEvalOrder.push_back(node);
+        }
+    }
+
+    // elementwise fusion: some nodes are computed by the node they feed into, and have no values of their own
+    PlanElementwiseFusion(compositeForwardPropEvalOrder, forwardPropRoots, parentsMap);
+
+    // For each node determine whether the output of the node is needed during back propagation
+    // The nodes of a fused expression do not need their own values for backprop, but the head needs the values of the expression's inputs.
+    auto isFused = [](const ComputationNodeBasePtr& node) { return node->GetElementwiseFusion() || node->IsFusedIntoConsumer(); };
+    std::unordered_map<ComputationNodeBasePtr, bool> outputValueNeededDuringBackProp;
+    for (auto& rootNode : forwardPropRoots)
     {
         for (const auto& node : GetEvalOrder(rootNode))
         {
             for (int i = 0; i < node->GetNumInputs(); i++)
             {
                 ComputationNodeBasePtr input = node->GetInputs()[i];
-                parentsMap[input].insert(node);
 
                 if (performingBackPropagation)
                 {
                     if (outputValueNeededDuringBackProp.find(input) == outputValueNeededDuringBackProp.end())
-                        outputValueNeededDuringBackProp[input] = input->NeedsGradient() && input->OutputUsedInComputingInputNodesGradients();
+                        outputValueNeededDuringBackProp[input] = input->NeedsGradient() && input->OutputUsedInComputingInputNodesGradients() && !isFused(input);
 
-                    outputValueNeededDuringBackProp[input] |= (node->NeedsGradient() && node->InputUsedInComputingInputNodesGradients(i));
+                    if (!isFused(node))
+                        outputValueNeededDuringBackProp[input] |= (node->NeedsGradient() && node->InputUsedInComputingInputNodesGradients(i));
                 }
                 else
                 {
@@ -993,6 +1525,21 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
             }
         }
     }
+    if (performingBackPropagation)
+    {
+        for (auto& node : compositeForwardPropEvalOrder)
+        {
+            if (node->GetElementwiseFusion() && node->NeedsGradient())
+            {
+                for (auto& input : node->GetElementwiseFusion()->GetInputs())
+                    outputValueNeededDuringBackProp[input] = true;
+            }
+        }
+    }
+
+    // gradient checkpointing: some values are recomputed instead of being kept for backprop
+    if (performingBackPropagation)
+        PlanRecomputeSegments(trainRootNode, parentsMap, outputValueNeededDuringBackProp);
 
     std::unordered_map<ComputationNodeBasePtr, int> parentCount;
     for (auto& keyValue : parentsMap)
@@ -1000,20 +1547,6 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
         parentCount[keyValue.first] = keyValue.second.size();
     }
 
-    // Construct the composite forward prop eval order by enumerating the
-    // nodes corresponding to each of our roots and then arranging them in the
-    // relative order that they appear in the global evaluation order
-    const std::list<ComputationNodeBasePtr>& allNodesEvalOrder = GetEvalOrder(nullptr);
-    std::list<ComputationNodeBasePtr> nodesForForwardPropRoots = ComputationNodeBase::EnumerateNodes(forwardPropRoots);
-    std::vector<ComputationNodeBasePtr> compositeForwardPropEvalOrder;
-    for (auto& node : allNodesEvalOrder)
-    {
-        if (std::find(nodesForForwardPropRoots.cbegin(), nodesForForwardPropRoots.cend(), node) != nodesForForwardPropRoots.cend())
-        {
-            compositeForwardPropEvalOrder.push_back(node);
-        }
-    }
-
     set<ComputationNodeBasePtr> completedEvaluate;
     for (auto& nodeIter : compositeForwardPropEvalOrder)
     {
@@ -1039,7 +1572,14 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
             nodeIter->RequestMatricesBeforeForwardProp(m_matrixPool);
             // we only release matrices for the children since the root node's information will be used and should not be shared
             // with others
-            ReleaseMatricesAfterEvalForChildren(nodeIter, parentCount);
+            // The inputs of a fused expression are read by its head, so they are released after the head.
+            if (nodeIter->GetElementwiseFusion())
+            {
+                for (auto& member : nodeIter->GetElementwiseFusion()->GetMembers())
+                    ReleaseMatricesAfterEvalForChildren(member, parentCount);
+            }
+            else if (!nodeIter->IsFusedIntoConsumer())
+                ReleaseMatricesAfterEvalForChildren(nodeIter, parentCount);
         }
     }
 
@@ -1053,6 +1593,31 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
         // we need to call it here since we always compute gradients for children and root node is not children of other node
         trainRootNode->RequestMatricesBeforeBackprop(m_matrixPool);
 
+        // gradient checkpointing: recomputed values are needed from before the first Backprop() that reads them until their segment is done
+        const auto& recomputeSegments = dynamic_pointer_cast<PARTraversalFlowControlNode>(GetNestedNetwork(trainRootNode))->m_recomputeSegments;
+        auto requestRecomputedValues = [&](const ComputationNodeBasePtr& nestedNode)
+        {
+            for (const auto& segment : recomputeSegments)
+            {
+                if (segment.recomputeBefore == nestedNode)
+                {
+                    for (const auto& node : segment.nodes)
+                        node->RequestRecomputedValueMatrix(m_matrixPool);
+                }
+            }
+        };
+        auto releaseRecomputedValues = [&](const ComputationNodeBasePtr& nestedNode)
+        {
+            for (const auto& segment : recomputeSegments)
+            {
+                if (segment.restoreAfter == nestedNode)
+                {
+                    for (const auto& node : segment.nodes)
+                        node->ReleaseRecomputedValueMatrix(m_matrixPool);
+                }
+            }
+        };
+
         for (auto iter = backPropNodes.rbegin(); iter != backPropNodes.rend(); iter++) // for gradient computation, traverse in reverse order
         {
             auto n = *iter;
@@ -1065,18 +1630,22 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
                     // SEQ mode: allocate all in loop first, then deallocate again
                     // TODO: next step: use PARTraversalFlowControlNode::AllocateGradientMatricesForInputs() and ReleaseMatricesAfterBackprop()...
                     // BUGBUG: naw, ^^ would not work! Wrong order! Need to rethink this. Need to make AllocateEvalMatrices() and AllocateGradientMatrices() the virtual functions.
+                    requestRecomputedValues(recInfo);
                     recInfo->AllocateGradientMatricesForInputs(m_matrixPool);
                     // Loops are computed sample by sample so we have to allocate them all
                     recInfo->ReleaseMatricesAfterBackprop(m_matrixPool);
+                    releaseRecomputedValues(recInfo);
                 }
             }
             else
             {
                 // PAR mode: we can allocate and immediately deallocate one by one
-                n->AllocateGradientMatricesForInputs(m_matrixPool);
+                requestRecomputedValues(n);
+                AllocateGradientMatricesForInputsOfNodeOrFusion(n, m_matrixPool);
                 // Root node's information will be used and should not be shared with others, also it's small (1x1)
                 if ((n != trainRootNode) && n->NeedsGradient())
                     n->ReleaseMatricesAfterBackprop(m_matrixPool);
+                releaseRecomputedValues(n);
             }
         }
     }
@@ -1099,4 +1668,202 @@ void ComputationNetwork::ReleaseMatricesAfterEvalForChildren(ComputationNodeBase
     }
 }
 
+// elementwise fusion (see SetFuseElementwiseOps()): find the expressions that are computed in a single pass (see ElementwiseFusion.h)
+// Going backwards through the evaluation order, each fusable node that is not fused yet heads an expression. The expression absorbs
+// an input, recursively, if it is fusable as well and its value is not used anywhere else: the expression is its only parent, it
+// is not a root, and its value is not kept (see MarkValueNonSharableNodes()). It must also be in the head's recurrent loop, if any,
+// and have the head's MBLayout and sample shape. All other inputs of the expression must be dense and either have the head's
+// MBLayout and sample shape, or be broadcast: without MBLayout but with the head's sample shape, or scalar.
+void ComputationNetwork::PlanElementwiseFusion(const std::vector<ComputationNodeBasePtr>& nodes,
+                                               const std::vector<ComputationNodeBasePtr>& forwardPropRoots,
+                                               const std::unordered_map<ComputationNodeBasePtr, std::unordered_set<ComputationNodeBasePtr>>& parentsMap)
+{
+    for (auto& node : GetAllNodes())
+    {
+        node->SetElementwiseFusion(nullptr);
+        node->SetFusedIntoConsumer(false);
+    }
+    if (!GetFuseElementwiseOps() || GetRecomputeValues())
+        return;
+
+    auto haveSameSampleShape = [](const ComputationNodeBasePtr& a, const ComputationNodeBasePtr& b)
+    {
+        size_t rank = max(a->GetSampleLayout().GetRank(), b->GetSampleLayout().GetRank());
+        return a->GetSampleLayout().PadRank(rank) == b->GetSampleLayout().PadRank(rank);
+    };
+
+    size_t numFusions = 0, numFusedNodes = 0;
+    for (auto nodeIter = nodes.rbegin(); nodeIter != nodes.rend(); nodeIter++)
+    {
+        const auto& head = *nodeIter;
+        ElementwiseFusion::Op op;
+        if (head->IsFusedIntoConsumer() || head->GetDeviceId() != CPUDEVICE || !ElementwiseFusion::TryGetOp(head, op))
+            continue;
+        auto loop = head->IsPartOfLoop() ? FindInRecurrentLoops(m_allSEQNodes, head) : nullptr;
+
+        // Each absorbed node has a single parent, so the expression is a tree.
+        set<ComputationNodeBasePtr> expression{ head };
+        function<void(const ComputationNodeBasePtr&)> absorbInputs = [&](const ComputationNodeBasePtr& node)
+        {
+            for (const auto& input : node->GetInputs())
+            {
+                auto parents = parentsMap.find(input);
+                if (expression.find(input) != expression.end() || !ElementwiseFusion::TryGetOp(input, op) ||
+                    parents == parentsMap.end() || parents->second.size() != 1 ||
+                    find(forwardPropRoots.begin(), forwardPropRoots.end(), input) != forwardPropRoots.end() || !input->IsValueSharable() ||
+                    input->GetMBLayout() != head->GetMBLayout() || !haveSameSampleShape(input, head) ||
+                    (input->IsPartOfLoop() ? FindInRecurrentLoops(m_allSEQNodes, input) : nullptr) != loop)
+                    continue;
+                expression.insert(input);
+                absorbInputs(input);
+            }
+        };
+        absorbInputs(head);
+        if (expression.size() < 2)
+            continue;
+
+        // the members in evaluation order, and whether all inputs from outside can be read by ElementwiseFusion
+        vector<ComputationNodeBasePtr> members;
+        bool inputsAreSupported = true;
+        function<void(const ComputationNodeBasePtr&)> addMembers = [&](const ComputationNodeBasePtr& node)
+        {
+            for (const auto& input : node->GetInputs())
+            {
+                if (expression.find(input) != expression.end())
+                {
+                    if (find(members.begin(), members.end(), input) == members.end()) // (e.g. x .* x)
+                        addMembers(input);
+                }
+                else
+                {
+                    bool isScalar = input->GetSampleLayout().GetNumElements() == 1;
+                    inputsAreSupported &= (!input->ValuePtr() || input->ValuePtr()->GetMatrixType() != SPARSE) &&
+                                          (input->GetMBLayout() == head->GetMBLayout() || !input->HasMBLayout()) &&
+                                          (isScalar || haveSameSampleShape(input, head));
+                }
+            }
+            members.push_back(node);
+        };
+        addMembers(head);
+        if (!inputsAreSupported)
+            continue;
+
+        head->SetElementwiseFusion(make_shared<ElementwiseFusion>(members));
+        for (auto& member : members)
+        {
+            if (member != head)
+                member->SetFusedIntoConsumer(true);
+        }
+        numFusions++;
+        numFusedNodes += members.size();
+    }
+
+    if (TraceLevel() > 0)
+        fprintf(stderr, "Elementwise fusion: %d nodes are computed as %d fused expressions.\n", (int)numFusedNodes, (int)numFusions);
+}
+
+// gradient checkpointing (see SetRecomputeValues()): decide which values are recomputed before backprop instead of being kept from forward prop
+// The top-level nodes of the criterion's network are cut into segments of consecutive nodes. A node's value is recomputed if
+//  - its forward prop can be repeated (see CanRecomputeValue()); recurrent loops, leaves, and nodes with non-shared values are never recomputed;
+//  - backprop or a recomputed parent in the same segment needs the value (otherwise it is released after forward prop anyway); and
+//  - it is not read by a node recomputed in another segment, since that one is recomputed at a different time.
+// The recomputed values are released after forward prop, and the values of all other inputs of recomputed nodes are kept instead.
+// Each segment is recomputed before the first Backprop() that reads one of its values, and released after the segment's last Backprop().
+void ComputationNetwork::PlanRecomputeSegments(const ComputationNodeBasePtr& trainRootNode,
+                                               const std::unordered_map<ComputationNodeBasePtr, std::unordered_set<ComputationNodeBasePtr>>& parentsMap,
+                                               std::unordered_map<ComputationNodeBasePtr, bool>& outputValueNeededDuringBackProp)
+{
+    auto network = dynamic_pointer_cast<PARTraversalFlowControlNode>(GetNestedNetwork(trainRootNode));
+    auto& segments = network->m_recomputeSegments;
+    segments.clear();
+    if (!s_recomputeValues || !g_shareNodeValueMatrices)
+        return;
+
+    // position of each node in the nested network; members of a loop are at the loop's position
+    const auto nestedNodes = network->GetNestedNodes();
+    std::unordered_map<ComputationNodeBasePtr, size_t> nestedIndex;
+    for (size_t i = 0; i < nestedNodes.size(); i++)
+    {
+        auto loop = dynamic_pointer_cast<SEQTraversalFlowControlNode>(nestedNodes[i]);
+        for (const auto& member : loop ? loop->m_nestedNodes : vector<ComputationNodeBasePtr>{ nestedNodes[i] })
+            nestedIndex[member] = i;
+    }
+    static const std::unordered_set<ComputationNodeBasePtr> noParents;
+    auto parentsOf = [&](const ComputationNodeBasePtr& node) -> const std::unordered_set<ComputationNodeBasePtr>&
+    {
+        auto parents = parentsMap.find(node);
+        return parents != parentsMap.end() ? parents->second : noParents;
+    };
+
+    // decide in reverse order, since a node depends on the decisions for its parents
+    size_t segmentLength = s_recomputeSegmentLength > 0 ? s_recomputeSegmentLength : max((size_t)1, (size_t)sqrt((double)nestedNodes.size()));
+    std::unordered_map<ComputationNodeBasePtr, size_t> recomputedInSegment;
+    for (size_t i = nestedNodes.size(); i-- > 0;)
+    {
+        const auto& node = nestedNodes[i];
+        if (node == trainRootNode || dynamic_pointer_cast<FlowControlNode>(node) || node->IsLeaf() || node->RequiresPreCompute() ||
+            !node->IsValueSharable() || !node->NeedsGradient() || !node->CanRecomputeValue())
+            continue;
+
+        size_t segment = i / segmentLength;
+        bool needed = outputValueNeededDuringBackProp[node];
+        bool readByOtherSegment = false;
+        for (const auto& parent : parentsOf(node))
+        {
+            auto parentSegment = recomputedInSegment.find(parent);
+            if (parentSegment == recomputedInSegment.end())
+                continue;
+            else if (parentSegment->second == segment)
+                needed = true;
+            else
+                readByOtherSegment = true;
+        }
+        if (needed && !readByOtherSegment)
+            recomputedInSegment[node] = segment;
+    }
+
+    // form the segments, with their nodes in evaluation order
+    size_t lastSegment = SIZE_MAX;
+    std::vector<size_t> recomputeBeforeIndex;
+    for (size_t i = 0; i < nestedNodes.size(); i++)
+    {
+        const auto& node = nestedNodes[i];
+        auto recomputed = recomputedInSegment.find(node);
+        if (recomputed == recomputedInSegment.end())
+            continue;
+        if (recomputed->second != lastSegment)
+        {
+            lastSegment = recomputed->second;
+            segments.push_back(PARTraversalFlowControlNode::RecomputeSegment());
+            segments.back().restoreAfter = node;
+            recomputeBeforeIndex.push_back(i);
+        }
+        segments.back().nodes.push_back(node);
+
+        // the value is read by the node's own Backprop() and by its parents'
+        for (const auto& parent : parentsOf(node))
+        {
+            auto parentIndex = nestedIndex.find(parent);
+            if (parentIndex != nestedIndex.end())
+                recomputeBeforeIndex.back() = max(recomputeBeforeIndex.back(), parentIndex->second);
+        }
+        recomputeBeforeIndex.back() = max(recomputeBeforeIndex.back(), i);
+
+        outputValueNeededDuringBackProp[node] = false;
+        for (const auto& input : node->GetInputs())
+        {
+            if (recomputedInSegment.find(input) == recomputedInSegment.end())
+                outputValueNeededDuringBackProp[input] = true;
+        }
+    }
+    for (size_t k = 0; k < segments.size(); k++)
+        segments[k].recomputeBefore = nestedNodes[recomputeBeforeIndex[k]];
+
+    if (TraceLevel() > 0)
+    {
+        fprintf(stderr, "\nGradient checkpointing: %d of %d top-level nodes are recomputed for backprop, in %d segments of up to %d nodes.\n",
+                (int)recomputedInSegment.size(), (int)nestedNodes.size(), (int)segments.size(), (int)segmentLength);
+    }
+}
+
 }}}
@@ -815,8 +815,10 @@ template WriteFormattingOptions::WriteFormattingOptions(const ScriptableObjects:
 
 atomic_ullong TimeStamp::s_timeStampCounter = ATOMIC_VAR_INIT(0);
 
-template <> map<size_t, map<size_t, shared_ptr<SingleMatrix>>> ComputationNode<float>::s_constOnes{};
-template <> map<size_t, map<size_t, shared_ptr<DoubleMatrix>>> ComputationNode<double>::s_constOnes{};
+bool ComputationNodeBase::s_compressActivationStash = false;
+
+template <> map<tuple<DEVICEID_TYPE, size_t, size_t>, shared_ptr<SingleMatrix>> ComputationNode<float>::s_constOnes{};
+template <> map<tuple<DEVICEID_TYPE, size_t, size_t>, shared_ptr<DoubleMatrix>> ComputationNode<double>::s_constOnes{};
 
 // -----------------------------------------------------------------------
 // instantiate the core class templates
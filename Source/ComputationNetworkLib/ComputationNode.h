@@ -23,6 +23,9 @@
 #include <algorithm>
 #include <assert.h>
 #include <atomic>
+#include <functional>
+#include <mutex>
+#include <tuple>
 
 #define DEFAULT_HIDDEN_ACTIVATION 0.1
 
@@ -60,7 +63,9 @@ enum CopyNodeFlags // flags to be passed to the CopyTo() function
     copyNodeValue          = 1, // copy everything except for the input links
     copyNodeInputLinks     = 2, // copy over input links
     copyNodeAll            = 3, // copy everything
-    copyNodeAcrossNetworks = 4  // allow a cross network child copy
+    copyNodeAcrossNetworks = 4, // allow a cross network child copy
+    copyNodeShareValue     = 8, // together with copyNodeValue: share the value matrix instead of copying it
+    copyNodeValueToHost    = 16 // together with copyNodeValue: copy the value into CPU memory, without gradient and minibatch data
 };
 
 #pragma region base computation class
@@ -70,6 +75,9 @@ enum CopyNodeFlags // flags to be passed to the CopyTo() function
 // =======================================================================
 
 class ComputationNodeBase;
+class ElementwiseFusion; // (ElementwiseFusion.h)
+typedef std::shared_ptr<ElementwiseFusion> ElementwiseFusionPtr;
+
 struct /*interface*/ IComputationNode
 {
     typedef shared_ptr<ComputationNodeBase> ComputationNodeBasePtr;
@@ -110,6 +118,9 @@ struct /*interface*/ IComputationNode
     virtual void AllocateGradientMatricesForInputs(MatrixPool& matrixPool) = 0;
     virtual void RequestMatricesBeforeBackprop(MatrixPool& matrixPool) = 0; // request matrices that are needed for gradient computation
     virtual void ReleaseMatricesAfterBackprop(MatrixPool& matrixPool) = 0;  // release gradient and temp matrices that no longer needed after all the children's gradients are computed.
+    virtual void RequestRecomputedValueMatrix(MatrixPool& matrixPool) = 0;  // request the matrix that the value is recomputed into before backprop (see CanRecomputeValue())
+    virtual void ReleaseRecomputedValueMatrix(MatrixPool& matrixPool) = 0;
+    virtual void SwapRecomputedValue() = 0;                                 // exchange the value with the recomputed one
 
     // --- optional overrides that describe a feature or property of the node
 
@@ -719,6 +730,14 @@ public:
 #endif
     }
 
+    // capture ForwardProp() for the time steps of a recurrent loop
+    // Returns a function that does the same as ForwardProp(FrameRange(GetMBLayout(), t)) for any time step t, with
+    // everything that does not depend on t (slicing, layout checks, tensor shapes) resolved once; or an empty function
+    // if the node does not support this, in which case ForwardProp() is called. The result depends only on the number of
+    // parallel sequences and time steps of the MBLayout, and on the value matrices of the node and its inputs: it remains
+    // valid for later minibatches of the same geometry as long as those matrices are not replaced. See SEQTraversalFlowControlNode::GetCapturedSteps().
+    virtual std::function<void(size_t)> CaptureForwardStep() { return nullptr; }
+
     // check whether a node is out of date w.r.t. its children, for lazy evaluation
     // If this returns true, node must be evaluated to update m_value.
     // This is virtual because it is overridden by traversal nodes, which would check all their nodes' inputs.
@@ -766,6 +785,39 @@ public:
     void SetOutputNeededDuringBackprop(bool f) { m_outputNeededDuringBackprop = f; }
     bool IsOutputNeededDuringBackprop() const { return !g_shareNodeValueMatrices || m_outputNeededDuringBackprop; }
 
+    // Can the value be released after forward prop and recomputed before backprop (gradient checkpointing)?
+    // This requires that repeating ForwardProp() gives the same value and has no side effects.
+    // Override for nodes that e.g. draw random numbers, update statistics, or use temp matrices that are released after forward prop.
+    virtual bool CanRecomputeValue() const { return true; }
+
+    // if true, nodes whose backprop needs only part of the information of a full-precision matrix keep that part in
+    // compact form instead, so that the matrix can be released after forward prop (see ActivationStash.h)
+    // This must be set before the matrices are allocated.
+    static void SetCompressActivationStash(bool compress) { s_compressActivationStash = compress; }
+    static bool GetCompressActivationStash() { return s_compressActivationStash; }
+
+protected:
+    // whether this node uses the compact stash; the stash only makes a difference if the released matrices are shared
+    bool UseCompressedActivationStash() const { return s_compressActivationStash && g_shareNodeValueMatrices && m_deviceId == CPUDEVICE; }
+
+private:
+    static bool s_compressActivationStash;
+
+public:
+    // elementwise fusion (see ElementwiseFusion.h), set up by ComputationNetwork::AllocateAllMatrices()
+    // The last node of a fused expression holds the fusion and computes all of it. The other nodes are fused into their consumer;
+    // they are not computed and have no value or gradient of their own.
+    const ElementwiseFusionPtr& GetElementwiseFusion() const { return m_elementwiseFusion; }
+    void SetElementwiseFusion(const ElementwiseFusionPtr& fusion) { m_elementwiseFusion = fusion; }
+    bool IsFusedIntoConsumer() const { return m_fusedIntoConsumer; }
+    void SetFusedIntoConsumer(bool fused) { m_fusedIntoConsumer = fused; }
+
+private:
+    ElementwiseFusionPtr m_elementwiseFusion;
+    bool m_fusedIntoConsumer = false;
+
+public:
+
     // -----------------------------------------------------------------------
     // helpers for network traversal
     // -----------------------------------------------------------------------
@@ -918,6 +970,54 @@ struct ITakesDynamicAxis
     virtual const std::wstring GetRequestedDynamicAxis() const = 0;
 };
 
+// =======================================================================
+// StepTensor -- the slice of a tensor for any time step of a recurrent loop
+// This is the slice for time step 0, moved by a fixed number of elements per
+// step. It is used to implement CaptureForwardStep().
+// =======================================================================
+
+template <class ElemType>
+struct StepTensor
+{
+    TensorView<ElemType> step0; // slice for time step 0
+    ptrdiff_t stride;           // elements per time step; 0 for data without MBLayout, which is the same for all steps
+
+    TensorView<ElemType> At(size_t t) const
+    {
+        if (stride == 0)
+            return step0;
+        return step0.Reshaped(TensorShape(step0.GetShape()).MoveInPlace(stride * (ptrdiff_t)t));
+    }
+
+    // determine the StepTensor from a function that returns the slice for a FrameRange, e.g. a node's ValueTensorFor()
+    // Returns false if the slices are not related by a fixed stride, or if the data is sparse.
+    static bool TryCapture(const std::function<TensorView<ElemType>(const FrameRange&)>& sliceFor, const MBLayoutPtr& pMBLayout, StepTensor& result)
+    {
+        if (!pMBLayout || pMBLayout->GetNumTimeSteps() < 2)
+            return false;
+        size_t lastStep = pMBLayout->GetNumTimeSteps() - 1;
+        FrameRange fr(pMBLayout, 0);
+        auto slice0 = sliceFor(fr);
+        auto slice1 = sliceFor(fr.WithTimeStep(1));
+        auto sliceLast = sliceFor(fr.WithTimeStep(lastStep));
+        if (slice0.GetSOB().GetMatrixType() != MatrixType::DENSE ||
+            &slice0.GetSOB() != &slice1.GetSOB() || &slice0.GetSOB() != &sliceLast.GetSOB())
+            return false;
+        const auto& shape0 = slice0.GetShape();
+        for (const auto& shape : { slice1.GetShape(), sliceLast.GetShape() })
+        {
+            if (shape.GetDims() != shape0.GetDims() || shape.GetStrides() != shape0.GetStrides())
+                return false;
+        }
+        ptrdiff_t stride = (ptrdiff_t)slice1.GetShape().GetOffset() - (ptrdiff_t)shape0.GetOffset();
+        if ((ptrdiff_t)sliceLast.GetShape().GetOffset() != (ptrdiff_t)shape0.GetOffset() + stride * (ptrdiff_t)lastStep)
+            return false;
+        result.step0 = slice0;
+        result.stride = stride;
+        return true;
+    }
+};
+
 // =======================================================================
 // ComputationNode -- abstract base class for computation nodes, deriving
 // from CompuationNodeBase, parameterized by float vs. double
@@ -969,14 +1069,22 @@ public:
         if (flags & CopyNodeFlags::copyNodeValue)
         {
             auto node = DownCast(nodeP);
-            if (m_value)
+            if (m_value && (flags & CopyNodeFlags::copyNodeShareValue))
+                node->m_value = m_value;
+            else if (m_value && (flags & CopyNodeFlags::copyNodeValueToHost))
+            {
+                node->m_value = make_shared<Matrix<ElemType>>(CPUDEVICE);
+                if (!HasMBLayout()) // values of nodes with MBLayout are activations and are not persisted
+                    node->m_value->AssignValuesOf(*m_value);
+            }
+            else if (m_value)
             {
                 node->CreateValueMatrixIfNull();
                 node->m_value->SetValue(*m_value);
             }
             else
                 node->m_value = nullptr;
-            if (m_gradient)
+            if (m_gradient && !(flags & CopyNodeFlags::copyNodeValueToHost))
             {
                 node->CreateGradientMatrixIfNull();
                 node->m_gradient->SetValue(*m_gradient);
@@ -1376,6 +1484,10 @@ public:
     {
         Base::BeginForwardProp();
 
+        // a node fused into its consumer has no value to update (see ElementwiseFusion.h)
+        if (IsFusedIntoConsumer())
+            return;
+
         // update the actual m_value allocation
         if (!IsLeaf() && !RequiresPreCompute()) // TODO: guard this through overrides instead
             UpdateFunctionValuesSize();
@@ -1404,7 +1516,8 @@ public:
         InvalidateMissingValueColumns(FrameRange(m_pMBLayout)); // blast NaNs into columns that are gaps in a packed layout
 #endif
         // tracing
-        Trace();
+        if (!IsFusedIntoConsumer())
+            Trace();
     }
 
 #if 0   // (keep it around in case we need to add stuff in the future)
@@ -1491,7 +1604,7 @@ public:
     // request matrices needed to do node function value evaluation
     virtual void RequestMatricesBeforeForwardProp(MatrixPool& matrixPool) override
     {
-        if (IsValueSharable())
+        if (IsValueSharable() && !IsFusedIntoConsumer())
             RequestMatrixFromPool(m_value, matrixPool);
         else
             CreateMatrixIfNull(m_value);
@@ -1501,7 +1614,7 @@ public:
     // don't release matrices that need to be used in the gradient computation
     virtual void ReleaseMatricesAfterForwardProp(MatrixPool& matrixPool) override
     {
-        if (!IsOutputNeededDuringBackprop() && (m_value->GetMatrixType() != SPARSE) && IsValueSharable())
+        if (!IsOutputNeededDuringBackprop() && (m_value->GetMatrixType() != SPARSE) && IsValueSharable() && !IsFusedIntoConsumer())
             ReleaseMatrixToPool(m_value, matrixPool);
     }
 
@@ -1535,6 +1648,23 @@ public:
         }
     }
 
+    // gradient checkpointing: the value is recomputed into a separate matrix, since the original one has been reused after forward prop
+    virtual void RequestRecomputedValueMatrix(MatrixPool& matrixPool) override
+    {
+        RequestMatrixFromPool(m_recomputedValue, matrixPool);
+    }
+
+    virtual void ReleaseRecomputedValueMatrix(MatrixPool& matrixPool) override
+    {
+        ReleaseMatrixToPool(m_recomputedValue, matrixPool);
+    }
+
+    virtual void SwapRecomputedValue() override
+    {
+        if (m_recomputedValue)
+            m_value.swap(m_recomputedValue);
+    }
+
     void CreateValueMatrixIfNull()
     {
         CreateMatrixIfNull(m_value);
@@ -1729,24 +1859,25 @@ public:
         }
     }
 
-    // NOTE: we should reimplement this to be thread-safe and use a larger than requested initialized memory block
+    // NOTE: we should reimplement this to use a larger than requested initialized memory block
     // we can then just wrap that memory block in a matrix of the correct dimensions since it will be const no one can change it
     // should only need one memory block per device
-    // Thread-safety could be achieved by changing this to a shared_ptr.
     // When using the TensorView interface, one could instead just use a 1x1 matrix with a view that broadcasts its columns (stride 0).
+    // This is locked, and there is one matrix per device, since networks that share parameters (ComputationNetwork::CloneSharingParameters())
+    // may be evaluated concurrently on different threads and devices, and nodes of one network may run concurrently (see InterOpScheduler.h).
+    // A matrix, once created, never moves, so the returned reference stays valid without the lock.
     static const Matrix<ElemType>& ConstOnes(const size_t rows, const size_t cols, const DEVICEID_TYPE deviceId)
     {
-        if (s_constOnes.find(rows) == s_constOnes.end() ||
-            s_constOnes[rows].find(cols) == s_constOnes[rows].end()) // not found
+        static std::mutex constOnesMutex;
+        std::lock_guard<std::mutex> lock(constOnesMutex);
+
+        auto& m = s_constOnes[std::make_tuple(deviceId, rows, cols)];
+        if (!m) // not found
         {
-            shared_ptr<Matrix<ElemType>> matrix = make_shared<Matrix<ElemType>>(rows, cols, (DEVICEID_TYPE) deviceId);
-            matrix->SetValue(1);
-            s_constOnes[rows][cols] = matrix;
+            m = make_shared<Matrix<ElemType>>(rows, cols, (DEVICEID_TYPE) deviceId);
+            m->SetValue(1);
         }
 
-        shared_ptr<Matrix<ElemType>> m = s_constOnes[rows][cols];
-        m->TransferFromDeviceToDevice(m->GetDeviceId(), deviceId);
-
         return *m;
     }
 
@@ -1757,8 +1888,9 @@ public:
 protected:
 
     shared_ptr<Matrix<ElemType>> m_value, m_gradient;
+    shared_ptr<Matrix<ElemType>> m_recomputedValue; // gradient checkpointing: swapped with m_value while the value is recomputed for backprop
 
-    static std::map<size_t, std::map<size_t, shared_ptr<Matrix<ElemType>>>> s_constOnes;
+    static std::map<std::tuple<DEVICEID_TYPE, size_t, size_t>, shared_ptr<Matrix<ElemType>>> s_constOnes;
 };
 
 // convenience wrapper for ComputationNode::New()
@@ -1885,6 +2017,9 @@ public:
     virtual std::string FormatOperationPrototype(const std::string& extraArgs) const override { return ""; }
     virtual void DumpNodeInfo(const bool /*printValues*/, const bool /*printMetadata*/, File& fstream) const override {}
     virtual std::set<std::pair<const MatrixBase*, std::wstring>> GetMatrixInfo() const override { NOT_IMPLEMENTED; }
+    virtual void RequestRecomputedValueMatrix(MatrixPool& matrixPool) override { NOT_IMPLEMENTED; }
+    virtual void ReleaseRecomputedValueMatrix(MatrixPool& matrixPool) override { NOT_IMPLEMENTED; }
+    virtual void SwapRecomputedValue() override { NOT_IMPLEMENTED; }
 
     virtual void ForwardProp(const FrameRange&, const ComputationNodeBasePtr, const ComputationNodeBasePtr) { NOT_IMPLEMENTED; }
 
@@ -2041,6 +2176,7 @@ protected:
     using Base::SetLearningRateMultiplier;                                                                                                               \
     using Base::UpdateFunctionMBSize;                                                                                                                    \
     using Base::UpdateFunctionValuesSize;                                                                                                                \
+    using Base::UseCompressedActivationStash;                                                                                                            \
     using Base::Validate;                                                                                                                                \
     using Base::ValidateBinaryReduce;                                                                                                                    \
     using Base::ValidateBinaryZip;                                                                                                                       \
@@ -2161,6 +2297,16 @@ public:
     {
         ValidateBinaryZip(isFinalValidationPass, true /*allowBroadcast*/);
     }
+
+protected:
+    // capture the tensors of the usual elementwise ForwardProp() (see CaptureForwardStep())
+    bool TryCaptureBinaryStep(StepTensor<ElemType>& result, StepTensor<ElemType>& input0, StepTensor<ElemType>& input1)
+    {
+        size_t rank = DetermineElementwiseTensorRank();
+        return StepTensor<ElemType>::TryCapture([&](const FrameRange& fr) { return             ValueTensorFor(rank, fr); },                  GetMBLayout(), result) &&
+               StepTensor<ElemType>::TryCapture([&](const FrameRange& fr) { return InputRef(0).ValueTensorFor(rank, fr.AllowBroadcast()); }, GetMBLayout(), input0) &&
+               StepTensor<ElemType>::TryCapture([&](const FrameRange& fr) { return InputRef(1).ValueTensorFor(rank, fr.AllowBroadcast()); }, GetMBLayout(), input1);
+    }
 };
 
 #define UsingBinaryElementwiseNodeBaseMembers UsingComputationNodeMembersBoilerplate;
@@ -9,6 +9,7 @@
 #include "Matrix.h"
 #include "ComputationNode.h"
 #include "ConvolutionEngine.h"
+#include <stdint.h>
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -699,12 +700,23 @@ public:
         Matrix<ElemType> sliceOutputValue = ValueFor(fr);
         const Matrix<ElemType>& input0 = InputRef(0).ValueFor(fr);
         m_convEng->ForwardPooling(input0, sliceOutputValue);
+
+        if (UseArgmaxStash() && !Environment().IsInferring() && InputRef(0).NeedsGradient())
+            StashArgmax(input0, sliceOutputValue, sliceOutputValue.Data() - Value().Data());
     }
 
     void BackpropTo(const size_t inputIndex, const FrameRange& fr) override
     {
         auto sliceOutputGrad = GradientFor(fr);
         Matrix<ElemType> sliceInput0Grad = InputRef(0).GradientFor(fr);
+
+        // the values may be in use by other nodes by now, so the position of the frames is taken from the gradient
+        if (UseArgmaxStash())
+        {
+            BackpropFromArgmax(sliceOutputGrad, sliceInput0Grad, sliceOutputGrad.Data() - Gradient().Data());
+            return;
+        }
+
         Matrix<ElemType> sliceInput0Value = InputRef(0).ValueFor(fr);
         Matrix<ElemType> sliceOutputValue = ValueFor(fr);
 
@@ -714,7 +726,12 @@ public:
     bool OutputUsedInComputingInputNodesGradients() const override
     {
         // The PoolingNode requires output values only for max pooling.
-        return m_poolKind == PoolKind::Max;
+        return m_poolKind == PoolKind::Max && !UseArgmaxStash();
+    }
+
+    bool InputUsedInComputingInputNodesGradients(size_t /*childIndex*/) const override
+    {
+        return !UseArgmaxStash();
     }
 
 public:
@@ -749,8 +766,78 @@ public:
                                                                 m_maxTempMemSizeInSamples, m_poolKind,
                                                                 ConvolutionEngineKind::All, NodeName());
             }
+
+            // the largest pooling window, for the argmax stash
+            const auto& g = *m_convEng->Geometry();
+            m_maxWindowSize = g.MpRowIndices().empty() ? SIZE_MAX : 0;
+            for (auto i0 : g.MpRowIndices())
+                m_maxWindowSize = max(m_maxWindowSize, (size_t)g.Indices()[i0]);
         }
     }
+
+private:
+    // With a compressed activation stash (see ActivationStash.h), max pooling keeps the position of the maximum within
+    // each pooling window as one byte, instead of the input and output values. On the CPU, pooling is done by the
+    // reference engine, and the positions are the same that its MaxPoolingBackward() finds: the first input >= the maximum.
+    static const uint8_t s_noArgmax = 255; // e.g. for NaN
+    bool UseArgmaxStash() const
+    {
+        return m_poolKind == PoolKind::Max && UseCompressedActivationStash() && m_maxWindowSize < s_noArgmax;
+    }
+
+    void StashArgmax(const Matrix<ElemType>& input, const Matrix<ElemType>& output, size_t offset)
+    {
+        const auto& g = *m_convEng->Geometry();
+        const ElemType* in = input.Data();
+        const ElemType* out = output.Data();
+        size_t inRows = input.GetNumRows(), outRows = output.GetNumRows();
+        m_argmax.resize(Value().GetNumElements());
+#pragma omp parallel for
+        for (int64_t sample = 0; sample < (int64_t)output.GetNumCols(); sample++)
+        {
+            for (size_t row = 0; row < outRows; row++)
+            {
+                const ElemType* inBase = in + sample * inRows + g.MpRowCol()[row];
+                int i0 = g.MpRowIndices()[row];
+                int size = g.Indices()[i0++];
+                ElemType m = out[sample * outRows + row];
+                uint8_t argmax = s_noArgmax;
+                for (int i = 0; i < size; i++)
+                {
+                    if (inBase[g.Indices()[i0 + i]] >= m)
+                    {
+                        argmax = (uint8_t)i;
+                        break;
+                    }
+                }
+                m_argmax[offset + sample * outRows + row] = argmax;
+            }
+        }
+    }
+
+    // same as MaxPoolingBackward(), including the order of the additions
+    void BackpropFromArgmax(const Matrix<ElemType>& outputGradient, Matrix<ElemType>& inputGradient, size_t offset) const
+    {
+        const auto& g = *m_convEng->Geometry();
+        const ElemType* srcGrad = outputGradient.Data();
+        ElemType* grad = inputGradient.Data();
+        size_t inRows = inputGradient.GetNumRows(), outRows = outputGradient.GetNumRows();
+#pragma omp parallel for
+        for (int64_t sample = 0; sample < (int64_t)outputGradient.GetNumCols(); sample++)
+        {
+            for (size_t row = 0; row < outRows; row++)
+            {
+                uint8_t argmax = m_argmax[offset + sample * outRows + row];
+                if (argmax == s_noArgmax)
+                    continue;
+                int i0 = g.MpRowIndices()[row] + 1;
+                grad[sample * inRows + g.MpRowCol()[row] + g.Indices()[i0 + argmax]] += srcGrad[sample * outRows + row];
+            }
+        }
+    }
+
+    size_t m_maxWindowSize = SIZE_MAX;
+    std::vector<uint8_t> m_argmax; // [output element] position of the maximum in its pooling window, with the argmax stash
 };
 
 // -----------------------------------------------------------------------
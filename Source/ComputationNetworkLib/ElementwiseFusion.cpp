@@ -0,0 +1,301 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// ElementwiseFusion.cpp -- computing expressions of elementwise nodes in a single pass
+//
+
+#include "Basics.h"
+#include "ElementwiseFusion.h"
+#include "LinearAlgebraNodes.h"
+#include "NonlinearityNodes.h"
+#include "TensorOps.h"
+#include <unordered_map>
+
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+static const size_t blockSize = 256; // elements computed at a time; all registers of a block stay in the cache
+
+/*static*/ bool ElementwiseFusion::TryGetOp(const ComputationNodeBasePtr& node, Op& op)
+{
+    const auto& operation = node->OperationName();
+    size_t numInputs = 1;
+    if      (operation == OperationNameOf(PlusNode))            op = Op::Plus,            numInputs = 2;
+    else if (operation == OperationNameOf(MinusNode))           op = Op::Minus,           numInputs = 2;
+    else if (operation == OperationNameOf(ElementTimesNode))    op = Op::ElementTimes,    numInputs = 2;
+    else if (operation == OperationNameOf(SigmoidNode))         op = Op::Sigmoid;
+    else if (operation == OperationNameOf(TanhNode))            op = Op::Tanh;
+    else if (operation == OperationNameOf(RectifiedLinearNode)) op = Op::RectifiedLinear;
+    else if (operation == OperationNameOf(ExpNode))             op = Op::Exp;
+    else
+        return false;
+    return node->GetNumInputs() == numInputs;
+}
+
+ElementwiseFusion::ElementwiseFusion(const vector<ComputationNodeBasePtr>& members)
+    : m_members(members)
+{
+    // registers: first the inputs from outside, then one per member
+    unordered_map<const ComputationNodeBase*, size_t> registers;
+    for (const auto& member : m_members)
+        registers[member.get()] = SIZE_MAX;
+    for (const auto& member : m_members)
+    {
+        for (const auto& input : member->GetInputs())
+        {
+            if (registers.insert(make_pair(input.get(), m_inputs.size())).second)
+                m_inputs.push_back(input);
+        }
+    }
+    for (const auto& member : m_members)
+    {
+        Instruction instruction;
+        if (!TryGetOp(member, instruction.op))
+            LogicError("ElementwiseFusion: %ls %ls operation cannot be fused.", member->NodeName().c_str(), member->OperationName().c_str());
+        for (size_t i = 0; i < 2; i++)
+        {
+            auto arg = registers.find(member->GetInputs()[min(i, member->GetNumInputs() - 1)].get());
+            if (arg->second == SIZE_MAX)
+                LogicError("ElementwiseFusion: Members must be in evaluation order (%ls %ls operation).", member->NodeName().c_str(), member->OperationName().c_str());
+            instruction.args[i] = arg->second;
+        }
+        registers[member.get()] = m_inputs.size() + m_program.size();
+        m_program.push_back(instruction);
+    }
+}
+
+// where the elements of the inputs and the output are
+// The output is a numRows x numColumns matrix. An input element (row, column) is at [column * columnStride + row * rowStride];
+// a stride of 0 broadcasts the input along that axis.
+template <class ElemType>
+struct ElementwiseFusion::Operands
+{
+    size_t numRows;
+    size_t numColumns;
+    vector<const ElemType*> inputs;
+    vector<size_t> rowStrides;
+    vector<size_t> columnStrides;
+
+    Operands(const ElementwiseFusion& fusion, ComputationNode<ElemType>& head, const Matrix<ElemType>& output, const FrameRange& fr)
+    {
+        numRows = head.GetSampleMatrixNumRows();
+        numColumns = numRows > 0 ? output.GetNumElements() / numRows : 0;
+        bool isContiguous = true; // if all inputs are laid out like the output or are scalars, all columns can be processed as one
+        for (const auto& inputp : fusion.m_inputs)
+        {
+            auto input = dynamic_pointer_cast<ComputationNode<ElemType>>(inputp);
+            if (input->Value().GetMatrixType() != DENSE || input->Value().GetDeviceId() != CPUDEVICE)
+                LogicError("ElementwiseFusion: Input %ls %ls operation must be a dense matrix on the CPU.", input->NodeName().c_str(), input->OperationName().c_str());
+            size_t inputRows = input->GetSampleMatrixNumRows();
+            inputs.push_back(input->HasMBLayout() ? input->ValueFor(fr).Data() : input->Value().Data());
+            rowStrides.push_back(inputRows == 1 && numRows != 1 ? 0 : 1);
+            columnStrides.push_back(input->HasMBLayout() ? inputRows : 0);
+            isContiguous &= (rowStrides.back() == 1 && columnStrides.back() == numRows) || (rowStrides.back() == 0 && columnStrides.back() == 0);
+        }
+        if (isContiguous || numColumns == 1)
+        {
+            numRows *= numColumns;
+            numColumns = 1;
+        }
+    }
+};
+
+template <class ElemType>
+static void Apply(ElementwiseFusion::Op op, const ElemType* a, const ElemType* b, ElemType* y, size_t n)
+{
+    switch (op)
+    {
+    case ElementwiseFusion::Op::Plus:            for (size_t i = 0; i < n; i++) y[i] = a[i] + b[i];                   break;
+    case ElementwiseFusion::Op::Minus:           for (size_t i = 0; i < n; i++) y[i] = a[i] - b[i];                   break;
+    case ElementwiseFusion::Op::ElementTimes:    for (size_t i = 0; i < n; i++) y[i] = a[i] * b[i];                   break;
+    case ElementwiseFusion::Op::Sigmoid:         for (size_t i = 0; i < n; i++) y[i] = OpSigmoid(a[i]);               break;
+    case ElementwiseFusion::Op::Tanh:            for (size_t i = 0; i < n; i++) y[i] = OpTanh(a[i]);                  break;
+    case ElementwiseFusion::Op::RectifiedLinear: for (size_t i = 0; i < n; i++) y[i] = OpLinearRectifier(a[i]);       break;
+    case ElementwiseFusion::Op::Exp:             for (size_t i = 0; i < n; i++) y[i] = OpExp(a[i]);                   break;
+    }
+}
+
+// compute all registers for the elements [row, row + n) of a column
+// 'registers' receives a pointer to the n elements of each register; the result of the last instruction goes to 'output' if given.
+template <class ElemType>
+void ElementwiseFusion::RunBlock(const Operands<ElemType>& operands, size_t column, size_t row, size_t n,
+                                 vector<ElemType>& buffer, vector<const ElemType*>& registers, ElemType* output) const
+{
+    for (size_t k = 0; k < m_inputs.size(); k++)
+    {
+        const ElemType* input = operands.inputs[k] + column * operands.columnStrides[k];
+        if (operands.rowStrides[k] == 1)
+            registers[k] = input + row;
+        else // scalar: broadcast into the register
+        {
+            ElemType* reg = &buffer[k * blockSize];
+            fill(reg, reg + n, *input);
+            registers[k] = reg;
+        }
+    }
+    for (size_t i = 0; i < m_program.size(); i++)
+    {
+        size_t r = m_inputs.size() + i;
+        ElemType* result = (output && i + 1 == m_program.size()) ? output : &buffer[r * blockSize];
+        Apply(m_program[i].op, registers[m_program[i].args[0]], registers[m_program[i].args[1]], result, n);
+        registers[r] = result;
+    }
+}
+
+template <class ElemType>
+bool ElementwiseFusion::TryForwardProp(const FrameRange& fr)
+{
+    auto head = dynamic_pointer_cast<ComputationNode<ElemType>>(m_members.back());
+    if (!head)
+        return false;
+
+    auto output = head->ValueFor(fr);
+    Operands<ElemType> operands(*this, *head, output, fr);
+    size_t numRegisters = m_inputs.size() + m_program.size();
+    size_t numBlocks = (operands.numRows + blockSize - 1) / blockSize;
+
+    // blocks of rows are independent; each thread runs its blocks for all columns
+#pragma omp parallel
+    {
+        vector<ElemType> buffer(numRegisters * blockSize);
+        vector<const ElemType*> registers(numRegisters);
+#pragma omp for
+        for (long block = 0; block < (long) numBlocks; block++)
+        {
+            size_t row = block * blockSize;
+            size_t n = min(blockSize, operands.numRows - row);
+            for (size_t column = 0; column < operands.numColumns; column++)
+                RunBlock(operands, column, row, n, buffer, registers, output.Data() + column * operands.numRows + row);
+        }
+    }
+    return true;
+}
+
+void ElementwiseFusion::ForwardProp(const FrameRange& fr)
+{
+    if (!TryForwardProp<float>(fr) && !TryForwardProp<double>(fr))
+        LogicError("ElementwiseFusion: Unsupported element type.");
+}
+
+template <class ElemType>
+bool ElementwiseFusion::TryBackprop(const FrameRange& fr, const vector<bool>& inputsToBackprop)
+{
+    auto head = dynamic_pointer_cast<ComputationNode<ElemType>>(m_members.back());
+    if (!head)
+        return false;
+    if (head->NeedsGradient())
+        head->LazyZeroGradient(); // (like ComputationNode::Backprop())
+    if (find(inputsToBackprop.begin(), inputsToBackprop.end(), true) == inputsToBackprop.end())
+        return true;
+
+    // if an input is reduced over time, gaps must not contribute to its gradient (as in PlusNode and ElementTimesNode)
+    bool reducesInTime = false;
+    vector<ElemType*> inputGradients(m_inputs.size(), nullptr);
+    bool hasScalarGradients = false;
+    for (size_t k = 0; k < m_inputs.size(); k++)
+    {
+        if (!inputsToBackprop[k])
+            continue;
+        auto input = dynamic_pointer_cast<ComputationNode<ElemType>>(m_inputs[k]);
+        input->LazyZeroGradient();
+        inputGradients[k] = input->HasMBLayout() ? input->GradientFor(fr).Data() : input->Gradient().Data();
+        reducesInTime |= input->ReducesInTimeWrt(head);
+        hasScalarGradients |= input->GetSampleMatrixNumRows() == 1 && head->GetSampleMatrixNumRows() != 1;
+    }
+    if (reducesInTime)
+    {
+        head->MaskMissingGradientColumnsToZero(fr);
+        for (const auto& input : m_inputs)
+        {
+            if (input->HasMBLayout())
+                input->MaskMissingValueColumnsToZero(fr);
+        }
+    }
+
+    // the intermediate values and the head's value are recomputed from the inputs
+    auto gradient = head->GradientFor(fr);
+    Operands<ElemType> operands(*this, *head, gradient, fr);
+    size_t numRegisters = m_inputs.size() + m_program.size();
+    size_t numBlocks = (operands.numRows + blockSize - 1) / blockSize;
+
+    // Each thread owns distinct rows of all gradients, except for scalar inputs, whose gradients sum over all rows.
+    // Those are rare enough to just run in sequence.
+#pragma omp parallel if (!hasScalarGradients)
+    {
+        vector<ElemType> buffer(numRegisters * blockSize);
+        vector<const ElemType*> registers(numRegisters);
+        vector<ElemType> adjoints(numRegisters * blockSize);
+#pragma omp for
+        for (long block = 0; block < (long) numBlocks; block++)
+        {
+            size_t row = block * blockSize;
+            size_t n = min(blockSize, operands.numRows - row);
+            for (size_t column = 0; column < operands.numColumns; column++)
+            {
+                RunBlock(operands, column, row, n, buffer, registers, (ElemType*) nullptr);
+
+                // reverse pass over the program, from the head's gradient to the inputs
+                fill(adjoints.begin(), adjoints.end(), (ElemType) 0);
+                const ElemType* headGradient = gradient.Data() + column * operands.numRows + row;
+                for (size_t i = m_program.size(); i-- > 0;)
+                {
+                    size_t r = m_inputs.size() + i;
+                    const ElemType* dy = i + 1 == m_program.size() ? headGradient : &adjoints[r * blockSize];
+                    const ElemType* y = registers[r];
+                    const ElemType* a = registers[m_program[i].args[0]];
+                    const ElemType* b = registers[m_program[i].args[1]];
+                    ElemType* da = &adjoints[m_program[i].args[0] * blockSize];
+                    ElemType* db = &adjoints[m_program[i].args[1] * blockSize];
+                    switch (m_program[i].op)
+                    {
+                    case Op::Plus:            for (size_t j = 0; j < n; j++) da[j] += dy[j], db[j] += dy[j];                                                break;
+                    case Op::Minus:           for (size_t j = 0; j < n; j++) da[j] += dy[j], db[j] -= dy[j];                                                break;
+                    case Op::ElementTimes:    for (size_t j = 0; j < n; j++) da[j] += dy[j] * b[j], db[j] += dy[j] * a[j];                                  break;
+                    case Op::Sigmoid:         for (size_t j = 0; j < n; j++) da[j] += OpElementwiseProductWithSigmoidDerivativeFromOutput(dy[j], y[j]);         break;
+                    case Op::Tanh:            for (size_t j = 0; j < n; j++) da[j] += OpElementwiseProductWithTanhDerivativeFromOutput(dy[j], y[j]);            break;
+                    case Op::RectifiedLinear: for (size_t j = 0; j < n; j++) da[j] += OpElementwiseProductWithLinearRectifierDerivativeFromOutput(dy[j], y[j]); break;
+                    case Op::Exp:             for (size_t j = 0; j < n; j++) da[j] += dy[j] * y[j];                                                         break;
+                    }
+                }
+
+                for (size_t k = 0; k < m_inputs.size(); k++)
+                {
+                    if (!inputGradients[k])
+                        continue;
+                    const ElemType* dx = &adjoints[k * blockSize];
+                    ElemType* inputGradient = inputGradients[k] + column * operands.columnStrides[k];
+                    if (operands.rowStrides[k] == 1)
+                    {
+                        for (size_t j = 0; j < n; j++)
+                            inputGradient[row + j] += dx[j];
+                    }
+                    else
+                    {
+                        for (size_t j = 0; j < n; j++)
+                            *inputGradient += dx[j];
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void ElementwiseFusion::Backprop(const FrameRange& fr, bool childrenInThisLoop, bool childrenInOuterLoop)
+{
+    const auto& head = m_members.back();
+    vector<bool> inputsToBackprop(m_inputs.size());
+    for (size_t k = 0; k < m_inputs.size(); k++)
+    {
+        const auto& input = m_inputs[k];
+        inputsToBackprop[k] = input->NeedsGradient() &&
+                              ((childrenInThisLoop  && input->IsPartOfLoop() == head->IsPartOfLoop()) ||
+                               (childrenInOuterLoop && input->IsPartOfLoop() != head->IsPartOfLoop()));
+    }
+    if (!TryBackprop<float>(fr, inputsToBackprop) && !TryBackprop<double>(fr, inputsToBackprop))
+        LogicError("ElementwiseFusion: Unsupported element type.");
+}
+
+}}}
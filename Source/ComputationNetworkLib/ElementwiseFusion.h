@@ -0,0 +1,79 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// ElementwiseFusion.h -- computing expressions of elementwise nodes in a single pass
+//
+// With ComputationNetwork::SetFuseElementwiseOps(true), AllocateAllMatrices() looks for expressions of elementwise
+// nodes (Plus, Minus, ElementTimes, Sigmoid, Tanh, RectifiedLinear, Exp) whose intermediate values are not used
+// anywhere else, such as the gates of an LSTM built from primitives. The last node of such an expression (the head)
+// computes all of it in one pass over the elements, reading only the inputs of the expression. The other nodes are
+// fused into their consumer: they are not computed, and get no value or gradient matrices from the MatrixPool.
+// Backprop likewise computes the gradients of all inputs of the expression in one pass, recomputing the intermediate
+// values from the inputs instead of keeping them.
+//
+// The elements are processed in blocks that stay in the cache, one instruction of the expression at a time.
+// The inputs must be dense and either have the head's shape and MBLayout, or be broadcast: a tensor without MBLayout
+// that has the head's sample shape (e.g. a bias), or a scalar. The nodes stay in the network as they are, so this
+// does not change how models are saved.
+//
+// This applies to nodes on the CPU only.
+//
+#pragma once
+
+#include "Basics.h"
+#include "ComputationNode.h"
+#include <memory>
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+class ElementwiseFusion
+{
+public:
+    enum class Op
+    {
+        Plus,
+        Minus,
+        ElementTimes,
+        Sigmoid,
+        Tanh,
+        RectifiedLinear,
+        Exp
+    };
+
+    // the op of a node that can be part of a fused expression
+    static bool TryGetOp(const ComputationNodeBasePtr& node, Op& op);
+
+    // 'members' are the nodes of the expression in evaluation order; the last one is the head
+    ElementwiseFusion(const std::vector<ComputationNodeBasePtr>& members);
+
+    const std::vector<ComputationNodeBasePtr>& GetMembers() const { return m_members; }
+    const std::vector<ComputationNodeBasePtr>& GetInputs() const { return m_inputs; } // inputs of the expression from outside of it
+
+    // compute the head's value
+    void ForwardProp(const FrameRange& fr);
+
+    // add the gradients of the expression's inputs; the flags select inputs like ComputationNode::Backprop() does
+    void Backprop(const FrameRange& fr, bool childrenInThisLoop, bool childrenInOuterLoop);
+
+private:
+    struct Instruction
+    {
+        Op op;
+        size_t args[2]; // registers read: [0, m_inputs.size()) are the inputs, followed by the results of the instructions
+    };
+
+    template <class ElemType> struct Operands;
+
+    template <class ElemType> bool TryForwardProp(const FrameRange& fr);
+    template <class ElemType> bool TryBackprop(const FrameRange& fr, const std::vector<bool>& inputsToBackprop);
+    template <class ElemType> void RunBlock(const Operands<ElemType>& operands, size_t column, size_t row, size_t n,
+                                            std::vector<ElemType>& buffer, std::vector<const ElemType*>& registers, ElemType* output) const;
+
+    std::vector<ComputationNodeBasePtr> m_members;
+    std::vector<ComputationNodeBasePtr> m_inputs;
+    std::vector<Instruction> m_program; // one per member, in evaluation order
+};
+
+}}}
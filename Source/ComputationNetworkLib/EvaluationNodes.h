@@ -121,6 +121,9 @@ public:
         ReleaseMatrixToPool(m_maxValues, matrixPool);
     }
 
+    // the temp matrices are released after forward prop
+    virtual bool CanRecomputeValue() const override { return false; }
+
 private:
     shared_ptr<Matrix<ElemType>> m_maxIndexes0, m_maxIndexes1;
     shared_ptr<Matrix<ElemType>> m_maxValues;
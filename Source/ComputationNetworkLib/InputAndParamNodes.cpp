@@ -406,13 +406,20 @@ void LearnableParameter<ElemType>::ReviseFromFile(const wstring& reviseFromFileP
 
 template <class ElemType>
 void LearnableParameter<ElemType>::Save(File& fstream) const /*override*/
+{
+    SaveDescriptor(fstream);
+    fstream << Value();
+}
+
+// save everything but the value
+template <class ElemType>
+void LearnableParameter<ElemType>::SaveDescriptor(File& fstream) const
 {
     if (!m_initString.empty())
         LogicError("LearnableParameter: Cannot Save() before deferred initialization has completed.");
     Base::Save(fstream);
     fstream << m_learningRateMultiplier;
     m_sampleLayout.Save(fstream);
-    fstream << Value();
 }
 
 template <class ElemType>
@@ -452,6 +459,106 @@ void LearnableParameter<ElemType>::Load(File& fstream, size_t modelVersion) /*ov
     m_initString.clear(); // deferred initialization not possible after loading
 }
 
+// counterpart of SaveDescriptor()
+// Mappable models are always written in the current format, so there are no legacy variants to handle here.
+template <class ElemType>
+void LearnableParameter<ElemType>::LoadDescriptor(File& fstream, size_t modelVersion)
+{
+    Base::Load(fstream, modelVersion);
+
+    TensorShape sampleLayout;
+    fstream >> m_learningRateMultiplier;
+    sampleLayout.Load(fstream);
+    SetDims(sampleLayout, false);
+
+    m_initString.clear(); // deferred initialization not possible after loading
+}
+
+// read the header of a matrix as written by Matrix::Write(), up to the elements
+// Returns false if the matrix is not dense.
+template <class ElemType>
+static bool ReadDenseMatrixHeader(File& fstream, /*out*/ size_t& numRows, /*out*/ size_t& numCols)
+{
+    char type;
+    fstream >> type;
+    if (type != 'd')
+        return false;
+    fstream.GetMarker(fileMarkerBeginSection, wstring(L"BMAT"));
+    size_t elemSize;
+    fstream >> elemSize;
+    if (elemSize != sizeof(ElemType))
+        RuntimeError("LearnableParameter: Element size %d in file does not match the expected %d.", (int)elemSize, (int)sizeof(ElemType));
+    wstring matrixName;
+    int format;
+    fstream >> matrixName >> format >> numRows >> numCols;
+    return true;
+}
+
+template <class ElemType>
+bool LearnableParameter<ElemType>::LoadSkippingValue(File& fstream, size_t modelVersion, /*out*/ uint64_t& valueOffset)
+{
+    if (modelVersion < CNTK_MODEL_VERSION_3 || !fstream.CanSeek() || fstream.IsTextBased())
+    {
+        Load(fstream, modelVersion);
+        return false;
+    }
+
+    LoadDescriptor(fstream, modelVersion);
+
+    valueOffset = fstream.GetPosition();
+    size_t numRows, numCols;
+    if (!ReadDenseMatrixHeader<ElemType>(fstream, numRows, numCols))
+    {
+        fstream.SetPosition(valueOffset);
+        let sampleLayout = GetSampleLayout();
+        LoadValue(fstream);
+        SetDims(sampleLayout, false);
+        VerifyDataSize(Value());
+        return false;
+    }
+    fstream.SetPosition(fstream.GetPosition() + numRows * numCols * sizeof(ElemType));
+    fstream.GetMarker(fileMarkerEndSection, wstring(L"EMAT"));
+    return true;
+}
+
+// counterpart of LoadSkippingValue()
+// The elements are read with a single read, straight into the matrix if it lives on the CPU.
+template <class ElemType>
+void LearnableParameter<ElemType>::LoadValueAt(File& fstream, uint64_t valueOffset)
+{
+    fstream.SetPosition(valueOffset);
+    size_t numRows, numCols;
+    if (!ReadDenseMatrixHeader<ElemType>(fstream, numRows, numCols))
+        LogicError("LoadValueAt: %ls %ls operation has no dense value at the given file offset.", NodeName().c_str(), OperationName().c_str());
+
+    CreateMatrixIfNull(m_value);
+    if (m_deviceId == CPUDEVICE)
+    {
+        Value().Resize(numRows, numCols);
+        fstream.ReadArray(Value().Data(), numRows * numCols);
+    }
+    else
+    {
+        vector<ElemType> buffer(numRows * numCols);
+        fstream.ReadArray(buffer.data(), buffer.size());
+        Value().SetValue(numRows, numCols, m_deviceId, buffer.data());
+    }
+    fstream.GetMarker(fileMarkerEndSection, wstring(L"EMAT"));
+    VerifyDataSize(Value()); // sanity check
+}
+
+// set the value from an external buffer, e.g. a memory-mapped model file
+// On the CPU, the matrix uses the buffer in place, and the node keeps 'owner' alive. Other devices get a copy.
+template <class ElemType>
+void LearnableParameter<ElemType>::AttachValueBuffer(ElemType* data, size_t numRows, size_t numCols, const shared_ptr<void>& owner)
+{
+    CreateMatrixIfNull(m_value);
+    bool inPlace = m_deviceId == CPUDEVICE;
+    Value().SetValue(numRows, numCols, m_deviceId, data, inPlace ? matrixFlagDontOwnBuffer : matrixFlagNormal);
+    m_valueBufferOwner = inPlace ? owner : nullptr;
+    VerifyDataSize(Value()); // sanity check
+}
+
 template <class ElemType>
 /*virtual*/ void LearnableParameter<ElemType>::CopyTo(ComputationNodeBasePtr nodeP, const wstring& newName, const CopyNodeFlags flags) const /*override*/
 {
@@ -466,6 +573,8 @@ template <class ElemType>
         node->m_initOutputRank = m_initOutputRank;
         node->m_initOnCPUOnly  = m_initOnCPUOnly;
         node->m_initValue      = m_initValue;
+        if (flags & CopyNodeFlags::copyNodeShareValue)
+            node->m_valueBufferOwner = m_valueBufferOwner; // the shared value may point into it
     }
 }
 
@@ -122,6 +122,20 @@ public:
     virtual void Save(File& fstream) const override;
     virtual void Load(File& fstream, size_t modelVersion) override;
 
+    // mappable model format (ComputationNetwork::SaveMappable()): the value is not part of the node record
+    // but stored as a separate aligned blob, which is attached after loading the descriptor
+    void SaveDescriptor(File& fstream) const;
+    void LoadDescriptor(File& fstream, size_t modelVersion);
+    // 'owner' keeps the buffer alive for as long as the value uses it in place, e.g. the MappedModelFile of a mappable model.
+    void AttachValueBuffer(ElemType* data, size_t numRows, size_t numCols, const std::shared_ptr<void>& owner);
+
+    // parallel model loading (ComputationNetwork::ReadPersistableParameters()): LoadSkippingValue() loads the node
+    // but only skips over its value, returning the value's offset in the file; LoadValueAt() reads the value later,
+    // through a different file handle, which may happen concurrently for different nodes.
+    // LoadSkippingValue() returns false if the value cannot be skipped (legacy or text format); then the node is loaded fully.
+    bool LoadSkippingValue(File& fstream, size_t modelVersion, /*out*/ uint64_t& valueOffset);
+    void LoadValueAt(File& fstream, uint64_t valueOffset);
+
     virtual void CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const override;
 
     // computation functions don't do anything for parameter nodes
@@ -151,6 +165,10 @@ private:
     int m_initOutputRank;
     bool m_initOnCPUOnly;
     ElemType m_initValue;
+
+    // owner of the external buffer that Value() uses in place (see AttachValueBuffer()), nullptr if the value owns its storage
+    // This is shared with the nodes that share Value() (CopyNodeFlags::copyNodeShareValue).
+    std::shared_ptr<void> m_valueBufferOwner;
 };
 
 // -----------------------------------------------------------------------
@@ -0,0 +1,223 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// InterOpScheduler.cpp -- concurrent execution of independent nodes (inter-operator parallelism)
+//
+
+#include "Basics.h"
+#include "InterOpScheduler.h"
+#include "CPUMatrix.h" // for SetNumThreadsForCurrentThread()
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// -----------------------------------------------------------------------
+// InterOpTaskGraph
+// -----------------------------------------------------------------------
+
+void InterOpTaskGraph::Init(size_t numTasks)
+{
+    m_successors.assign(numTasks, vector<size_t>());
+    m_numPredecessors.assign(numTasks, 0);
+}
+
+void InterOpTaskGraph::AddDependency(size_t before, size_t after)
+{
+    if (before >= after)
+        LogicError("InterOpTaskGraph: Dependencies must point forward in the sequential order (%d -> %d).", (int)before, (int)after);
+    auto& successors = m_successors[before];
+    if (find(successors.begin(), successors.end(), after) != successors.end())
+        return;
+    successors.push_back(after);
+    m_numPredecessors[after]++;
+}
+
+bool InterOpTaskGraph::IsSequential() const
+{
+    // Tasks are in a valid order already, so it is sufficient to check that each one depends on its predecessor.
+    for (size_t task = 1; task < m_successors.size(); task++)
+    {
+        const auto& successors = m_successors[task - 1];
+        if (find(successors.begin(), successors.end(), task) == successors.end())
+            return false;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------
+// InterOpThreadPool -- the threads that run the graphs
+//
+// All state is guarded by one mutex. Tasks are coarse (whole nodes), so a
+// central ready queue is sufficient.
+// -----------------------------------------------------------------------
+
+class InterOpThreadPool
+{
+    struct GraphRun
+    {
+        const InterOpTaskGraph* graph;
+        const function<void(size_t)>* runTask;
+        vector<size_t> numPending; // number of predecessors that have not completed yet
+        deque<size_t> ready;
+        size_t numCompleted = 0;
+        size_t numRunning = 0;
+        exception_ptr error;
+
+        bool IsDone() const { return numCompleted == graph->GetNumTasks() || (error && numRunning == 0); }
+    };
+
+    mutex m_mutex;
+    condition_variable m_changed; // a task became ready or completed, or the pool shuts down
+    vector<thread> m_threads;
+    GraphRun* m_run = nullptr;
+    bool m_shutdown = false;
+    int m_numIntraOpThreads = 1;
+
+    // run one ready task; called and returns with the lock held
+    void RunOneTask(GraphRun& run, unique_lock<mutex>& lock)
+    {
+        size_t task = run.ready.front();
+        run.ready.pop_front();
+        run.numRunning++;
+        lock.unlock();
+
+        exception_ptr error;
+        try
+        {
+            (*run.runTask)(task);
+        }
+        catch (...)
+        {
+            error = current_exception();
+        }
+
+        lock.lock();
+        run.numRunning--;
+        run.numCompleted++;
+        if (error && !run.error)
+        {
+            run.error = error;
+            run.ready.clear(); // don't start anything else
+        }
+        if (!run.error)
+        {
+            for (auto successor : run.graph->GetSuccessors(task))
+            {
+                if (--run.numPending[successor] == 0)
+                    run.ready.push_back(successor);
+            }
+        }
+        m_changed.notify_all();
+    }
+
+    void WorkerLoop()
+    {
+        CPUMatrix<float /*any will do*/>::SetNumThreadsForCurrentThread(m_numIntraOpThreads);
+        unique_lock<mutex> lock(m_mutex);
+        for (;;)
+        {
+            m_changed.wait(lock, [this]() { return m_shutdown || (m_run && !m_run->ready.empty()); });
+            if (m_shutdown)
+                return;
+            RunOneTask(*m_run, lock);
+        }
+    }
+
+    void Stop()
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_shutdown = true;
+        }
+        m_changed.notify_all();
+        for (auto& t : m_threads)
+            t.join();
+        m_threads.clear();
+        m_shutdown = false;
+    }
+
+public:
+    ~InterOpThreadPool()
+    {
+        Stop();
+    }
+
+    // (re-)create the worker threads (the calling thread is the remaining one)
+    void Resize(size_t numThreads, int numIntraOpThreads)
+    {
+        Stop();
+        m_numIntraOpThreads = numIntraOpThreads;
+        for (size_t i = 1; i < numThreads; i++)
+            m_threads.push_back(thread([this]() { WorkerLoop(); }));
+    }
+
+    size_t GetNumThreads() const { return m_threads.size() + 1; }
+
+    void Run(const InterOpTaskGraph& graph, const function<void(size_t)>& runTask)
+    {
+        GraphRun run;
+        run.graph = &graph;
+        run.runTask = &runTask;
+        run.numPending.resize(graph.GetNumTasks());
+        for (size_t task = 0; task < graph.GetNumTasks(); task++)
+        {
+            run.numPending[task] = graph.GetNumPredecessors(task);
+            if (run.numPending[task] == 0)
+                run.ready.push_back(task);
+        }
+
+        // the calling thread works along, with its share of the CPU threads
+        int numCallerThreads = CPUMatrix<float>::GetNumThreads();
+        CPUMatrix<float>::SetNumThreadsForCurrentThread(m_numIntraOpThreads);
+        auto restoreCallerThreads = MakeScopeExit([numCallerThreads]() { CPUMatrix<float>::SetNumThreadsForCurrentThread(numCallerThreads); });
+
+        unique_lock<mutex> lock(m_mutex);
+        m_run = &run;
+        m_changed.notify_all();
+        while (!run.IsDone())
+        {
+            if (!run.ready.empty())
+                RunOneTask(run, lock);
+            else
+                m_changed.wait(lock);
+        }
+        m_run = nullptr;
+        lock.unlock();
+
+        if (run.error)
+            rethrow_exception(run.error);
+    }
+};
+
+/*static*/ size_t InterOpScheduler::Run(const InterOpTaskGraph& graph, size_t numThreads, const function<void(size_t)>& runTask)
+{
+    static InterOpThreadPool pool;
+    static mutex poolMutex; // one graph at a time
+
+    unique_lock<mutex> lock(poolMutex, try_to_lock);
+    if (numThreads <= 1 || !lock.owns_lock())
+    {
+        for (size_t task = 0; task < graph.GetNumTasks(); task++) // (the tasks are in a valid order)
+            runTask(task);
+        return 1;
+    }
+
+    if (pool.GetNumThreads() != numThreads)
+    {
+        int numIntraOpThreads = max(1, CPUMatrix<float>::GetNumThreads() / (int)numThreads);
+        pool.Resize(numThreads, numIntraOpThreads);
+    }
+    pool.Run(graph, runTask);
+    return numThreads;
+}
+
+}}}
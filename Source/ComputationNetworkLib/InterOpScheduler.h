@@ -0,0 +1,55 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// InterOpScheduler.h -- concurrent execution of independent nodes (inter-operator parallelism)
+//
+// A sequence of tasks (e.g. the nodes of a PARTraversalFlowControlNode in evaluation order) is turned into
+// a dependency graph: a task waits for the earlier tasks it depends on, e.g. a node for its inputs. Running
+// the tasks in any order that respects the graph gives the same results as running them in sequence, as long
+// as the graph covers everything the tasks share (see PARTraversalFlowControlNode::RunConcurrently()).
+//
+// Ready tasks are run by a pool of threads. Each thread limits the threads that its CPU operations use,
+// so that the total stays within what CPUMatrix::SetNumThreads() was given.
+//
+#pragma once
+
+#include "Basics.h"
+#include <functional>
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+class InterOpTaskGraph
+{
+public:
+    // start a graph of tasks without dependencies, numbered in the order of the sequential execution
+    void Init(size_t numTasks);
+
+    // 'after' must wait for 'before'; requires before < after
+    void AddDependency(size_t before, size_t after);
+
+    size_t GetNumTasks() const { return m_successors.size(); }
+    const std::vector<size_t>& GetSuccessors(size_t task) const { return m_successors[task]; }
+    size_t GetNumPredecessors(size_t task) const { return m_numPredecessors[task]; }
+
+    // true if no two tasks can run concurrently, in which case running the graph is not worth it
+    bool IsSequential() const;
+
+private:
+    std::vector<std::vector<size_t>> m_successors;
+    std::vector<size_t> m_numPredecessors;
+};
+
+class InterOpScheduler
+{
+public:
+    // run all tasks of the graph on up to 'numThreads' threads including the calling one
+    // 'runTask' is called once per task, after all of its predecessors have completed. If a task throws,
+    // no further tasks are started, and the first exception is rethrown once the running tasks are done.
+    // If the threads are busy with another graph (e.g. from another thread), the tasks are run in sequence.
+    // Returns the number of threads the tasks were run on (1 if in sequence).
+    static size_t Run(const InterOpTaskGraph& graph, size_t numThreads, const std::function<void(size_t)>& runTask);
+};
+
+}}}
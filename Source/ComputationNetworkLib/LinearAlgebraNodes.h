@@ -48,6 +48,14 @@ public:
         result.AssignSumOf(input0, input1);
     }
 
+    virtual std::function<void(size_t)> /*ComputationNodeBase::*/ CaptureForwardStep() override
+    {
+        StepTensor<ElemType> result, input0, input1;
+        if (!Base::TryCaptureBinaryStep(result, input0, input1))
+            return nullptr;
+        return [result, input0, input1](size_t t) { result.At(t).AssignSumOf(input0.At(t), input1.At(t)); };
+    }
+
     virtual void /*ComputationNode::*/ BackpropTo(const size_t inputIndex, const FrameRange& fr) override
     {
         size_t rank = DetermineElementwiseTensorRank();
@@ -149,6 +157,14 @@ public:
         result.AssignDifferenceOf(input0, input1);
     }
 
+    virtual std::function<void(size_t)> /*ComputationNodeBase::*/ CaptureForwardStep() override
+    {
+        StepTensor<ElemType> result, input0, input1;
+        if (!Base::TryCaptureBinaryStep(result, input0, input1))
+            return nullptr;
+        return [result, input0, input1](size_t t) { result.At(t).AssignDifferenceOf(input0.At(t), input1.At(t)); };
+    }
+
     virtual void /*ComputationNode::*/ BackpropTo(const size_t inputIndex, const FrameRange& fr) override
     {
         size_t rank = DetermineElementwiseTensorRank();
@@ -195,6 +211,14 @@ public:
         ForwardPropImpl(*this, fr, true/*allowBroadcast*/);
     }
 
+    virtual std::function<void(size_t)> /*ComputationNodeBase::*/ CaptureForwardStep() override
+    {
+        StepTensor<ElemType> result, input0, input1;
+        if (!Base::TryCaptureBinaryStep(result, input0, input1))
+            return nullptr;
+        return [result, input0, input1](size_t t) { result.At(t).AssignElementwiseProductOf(input0.At(t), input1.At(t)); };
+    }
+
     virtual void /*ComputationNode::*/ BackpropTo(const size_t inputIndex, const FrameRange& fr) override
     {
         BackpropToImpl(*this, inputIndex, fr, true/*allowBroadcast*/);
@@ -363,6 +387,19 @@ public:
         output.AssignMatrixProductOf(false/*transC*/, input0, m_transpose/*transA*/, input1, false/*transB*/);
     }
 
+    // only the regular case is captured, where the left argument is not minibatch data
+    virtual std::function<void(size_t)> /*ComputationNodeBase::*/ CaptureForwardStep() override
+    {
+        if (InputRef(0).HasMBLayout())
+            return nullptr;
+        StepTensor<ElemType> input0, input1, output;
+        if (!StepTensor<ElemType>::TryCapture([&](const FrameRange& fr) { return OneSampleTensorFor(0,  /*gradient=*/false, fr.AllowBroadcast()); }, GetMBLayout(), input0) ||
+            !StepTensor<ElemType>::TryCapture([&](const FrameRange& fr) { return OneSampleTensorFor(1,  /*gradient=*/false, fr.AllowBroadcast()); }, GetMBLayout(), input1) ||
+            !StepTensor<ElemType>::TryCapture([&](const FrameRange& fr) { return OneSampleTensorFor(-1, /*gradient=*/false, fr); },                  GetMBLayout(), output))
+            return nullptr;
+        return [input0, input1, output](size_t t) { output.At(t).AssignMatrixProductOf(false/*transC*/, input0.At(t), m_transpose/*transA*/, input1.At(t), false/*transB*/); };
+    }
+
     virtual void /*ComputationNode::*/ BackpropTo(const size_t inputIndex, const FrameRange& fr) override
     {
         // special treatment if A is minibatch data; see Forward() for comment
@@ -24,11 +24,23 @@ class MatrixPool
 {
     vector<shared_ptr<Matrix<float>>>  m_releasedFloatMatrices;
     vector<shared_ptr<Matrix<double>>> m_releasedDoubleMatrices;
+    bool m_memSharing = true;
 
     template <class ElemType>
     vector<shared_ptr<Matrix<ElemType>>>& GetReleasedMatrices();
 
 public:
+    // disable to give every request a matrix of its own, e.g. for nodes that run concurrently (see ComputationNetwork::SetNumInterOpThreads())
+    void SetMemSharing(bool enable)
+    {
+        m_memSharing = enable;
+        if (!enable)
+        {
+            m_releasedFloatMatrices.clear();
+            m_releasedDoubleMatrices.clear();
+        }
+    }
+
     // release here means the matrix can be put back and shared by others
     template <class ElemType>
     void Release(shared_ptr<Matrix<ElemType>> freeMatrix)
@@ -36,8 +48,9 @@ public:
         if (freeMatrix == nullptr || freeMatrix->GetMatrixType() == SPARSE)
             LogicError("MatrixPool::Release: freeMatrix should not be null or sparse.");
 //#define SUPRESS_MEMSHARING // #define this to disable memory sharing through this structure
-        // TODO: Make this a runtime option.
 #ifndef SUPRESS_MEMSHARING
+        if (!m_memSharing)
+            return;
         vector<shared_ptr<Matrix<ElemType>>>& releasedMatrices = GetReleasedMatrices<ElemType>();
 #ifdef _DEBUG
         for (int i = 0; i < releasedMatrices.size(); i++)
@@ -0,0 +1,170 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// NodeProfiler.cpp -- per-node timing of forward and backward propagation
+//
+
+#define _CRT_SECURE_NO_WARNINGS // "secure" CRT not available on all platforms  --add this at the top of all CPP files that give "function or variable may be unsafe" warnings
+
+#include "Basics.h"
+#include "NodeProfiler.h"
+#include "fileutil.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+NodeProfiler::NodeProfiler(size_t maxTraceEvents)
+    : m_startTime(Clock::now()), m_maxTraceEvents(maxTraceEvents)
+{
+}
+
+// size of the matrix that a ForwardProp() (value) or Backprop() (gradient) call writes
+template <class ElemType>
+static bool TryGetOutputBytes(const ComputationNodeBasePtr& nodep, NodeProfiler::Pass pass, size_t& bytes)
+{
+    auto node = dynamic_pointer_cast<ComputationNode<ElemType>>(nodep);
+    if (!node)
+        return false;
+    auto matrix = dynamic_pointer_cast<Matrix<ElemType>>(pass == NodeProfiler::Pass::forward ? node->ValuePtr() : node->GradientPtr());
+    bytes = matrix ? matrix->BufferSize() : 0;
+    return true;
+}
+
+NodeProfiler::NodeStats& NodeProfiler::GetStats(const ComputationNodeBasePtr& node)
+{
+    auto iter = m_nodeIndices.find(node.get());
+    if (iter != m_nodeIndices.end())
+        return m_stats[iter->second];
+
+    m_nodeIndices[node.get()] = m_stats.size();
+    m_stats.push_back(NodeStats());
+    m_stats.back().name = node->NodeName();
+    m_stats.back().operation = node->OperationName();
+    return m_stats.back();
+}
+
+void NodeProfiler::Record(const ComputationNodeBasePtr& node, Pass pass, Clock::duration duration, bool countCall)
+{
+    lock_guard<mutex> lock(m_mutex);
+    auto& stats = GetStats(node);
+    stats.seconds[(int)pass] += chrono::duration<double>(duration).count();
+    if (!countCall)
+        return;
+
+    stats.calls[(int)pass]++;
+    stats.flops[(int)pass] += EstimateFlops(node, pass);
+    size_t bytes = 0;
+    TryGetOutputBytes<float>(node, pass, bytes) || TryGetOutputBytes<double>(node, pass, bytes);
+    stats.maxBytes[(int)pass] = max(stats.maxBytes[(int)pass], bytes);
+}
+
+void NodeProfiler::Trace(const ComputationNodeBasePtr& node, Pass pass, Clock::time_point begin, Clock::time_point end)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_traceEvents.size() >= m_maxTraceEvents)
+        return;
+
+    auto iter = m_traceIndices.find(node.get());
+    size_t nodeIndex;
+    if (iter != m_traceIndices.end())
+        nodeIndex = iter->second;
+    else
+    {
+        nodeIndex = m_traceNames.size();
+        m_traceIndices[node.get()] = nodeIndex;
+        m_traceNames.push_back(node->NodeName() + L" (" + node->OperationName() + L")");
+    }
+    auto thread = find(m_traceThreads.begin(), m_traceThreads.end(), this_thread::get_id());
+    size_t threadIndex = thread - m_traceThreads.begin();
+    if (thread == m_traceThreads.end())
+        m_traceThreads.push_back(this_thread::get_id());
+    m_traceEvents.push_back(TraceEvent{nodeIndex, pass, threadIndex, begin, end - begin});
+}
+
+// The estimate counts a multiply-add as two operations:
+//  - Times and Convolution: 2 * (output elements) * (inner dimension), where the inner dimension is taken from the
+//    weight (first input) as the number of elements per output row; backprop computes the gradient w.r.t. both inputs.
+//  - everything else: one operation per output element and input, both for forward and backward.
+/*static*/ double NodeProfiler::EstimateFlops(const ComputationNodeBasePtr& node, Pass pass)
+{
+    double outputElements = (double)node->GetSampleMatrixNumRows() * (double)node->GetSampleMatrixNumCols();
+    const auto& operation = node->OperationName();
+    if ((operation == L"Times" || operation == L"TransposeTimes" || operation == L"Convolution") && node->GetNumInputs() >= 2)
+    {
+        const auto& weightLayout = node->Input(0)->GetSampleLayout();
+        double innerDim = weightLayout.GetRank() > 0 && weightLayout[0] > 0 ? (double)weightLayout.GetNumElements() / weightLayout[0] : 1;
+        if (operation == L"TransposeTimes")
+            innerDim = weightLayout.GetRank() > 0 ? (double)weightLayout[0] : 1;
+        double flops = 2 * outputElements * innerDim;
+        return pass == Pass::forward ? flops : 2 * flops;
+    }
+    return outputElements * max((size_t)1, node->GetNumInputs());
+}
+
+void NodeProfiler::PrintTable(FILE* f, const string& title) const
+{
+    vector<size_t> order(m_stats.size());
+    iota(order.begin(), order.end(), 0);
+    auto totalSeconds = [this](size_t i) { return m_stats[i].seconds[0] + m_stats[i].seconds[1]; };
+    sort(order.begin(), order.end(), [&](size_t a, size_t b) { return totalSeconds(a) > totalSeconds(b); });
+    double allSeconds = 0;
+    for (size_t i = 0; i < m_stats.size(); i++)
+        allSeconds += totalSeconds(i);
+
+    fprintf(f, "\n%s: %d nodes, %.3f seconds in ForwardProp() and Backprop()\n", title.c_str(), (int)m_stats.size(), allSeconds);
+    fprintf(f, "%6s %10s %10s %8s %8s %10s %9s %9s  %s\n", "%time", "fwd ms", "bwd ms", "fwd cnt", "bwd cnt", "GFLOP", "GFLOP/s", "max MB", "node (operation)");
+    for (auto i : order)
+    {
+        const auto& stats = m_stats[i];
+        double seconds = totalSeconds(i);
+        double gflops = (stats.flops[0] + stats.flops[1]) * 1e-9;
+        size_t maxBytes = max(stats.maxBytes[0], stats.maxBytes[1]);
+        fprintf(f, "%6.2f %10.3f %10.3f %8d %8d %10.3f %9.2f %9.2f  %ls (%ls)\n",
+                allSeconds > 0 ? 100 * seconds / allSeconds : 0.0, stats.seconds[0] * 1e3, stats.seconds[1] * 1e3,
+                (int)stats.calls[0], (int)stats.calls[1], gflops, seconds > 0 ? gflops / seconds : 0.0,
+                maxBytes / (1024.0 * 1024.0), stats.name.c_str(), stats.operation.c_str());
+    }
+    if (m_traceEvents.size() >= m_maxTraceEvents)
+        fprintf(f, "(trace truncated after %d events)\n", (int)m_maxTraceEvents);
+}
+
+// escape a node name for use as a JSON string
+static string JsonString(const wstring& s)
+{
+    string utf8 = msra::strfun::utf8(s);
+    string result;
+    for (char c : utf8)
+    {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        if ((unsigned char)c < 0x20)
+            continue;
+        result += c;
+    }
+    return result;
+}
+
+// The file is in the Trace Event Format read by chrome://tracing.
+// All events are complete events ("ph":"X"); forward and backward of each thread go into separate rows ("tid").
+void NodeProfiler::WriteChromeTrace(const wstring& fileName) const
+{
+    FILE* f = fopenOrDie(fileName, L"w");
+    fprintf(f, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < m_traceEvents.size(); i++)
+    {
+        const auto& event = m_traceEvents[i];
+        double ts = chrono::duration<double, micro>(event.begin - m_startTime).count();
+        double dur = chrono::duration<double, micro>(event.duration).count();
+        fprintf(f, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                i > 0 ? ",\n" : "", JsonString(m_traceNames[event.nodeIndex]).c_str(),
+                event.pass == Pass::forward ? "forward" : "backward", (int)(2 * event.threadIndex) + (int)event.pass, ts, dur);
+    }
+    fprintf(f, "\n],\n\"displayTimeUnit\":\"ms\"}\n");
+    fcloseOrDie(f);
+}
+
+}}}
@@ -0,0 +1,97 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// NodeProfiler.h -- per-node timing of forward and backward propagation
+//
+// When a NodeProfiler is installed in the ComputationEnvironment, the PAR and SEQ traversal
+// flow-control nodes time every ForwardProp() and Backprop() call. For each node, the profiler
+// aggregates the wall time, an estimate of the floating-point operations, and the size of the
+// matrix the call writes (value in forward, gradient in backward). The result can be printed as a
+// table sorted by time, and the individual calls exported as a Chrome trace (chrome://tracing).
+//
+// Record() and Trace() may be called concurrently when nodes run on the inter-op threads (see InterOpScheduler.h).
+//
+// Note that GPU kernels are launched asynchronously, so on the GPU the times are launch times
+// unless the device is synchronized after each call (e.g. CUDA_LAUNCH_BLOCKING=1).
+//
+#pragma once
+
+#include "Basics.h"
+#include "ComputationNode.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+class NodeProfiler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum class Pass : int
+    {
+        forward = 0,
+        backward = 1
+    };
+
+    NodeProfiler(size_t maxTraceEvents = 1000000);
+
+    // aggregate one call of a node
+    // Calls inside a recurrent loop are summed up over the time steps by the caller and recorded once per minibatch.
+    // Pass 'countCall' = false to add time to a call that has already been recorded; FLOPs and bytes are counted once per call.
+    void Record(const ComputationNodeBasePtr& node, Pass pass, Clock::duration duration, bool countCall = true);
+
+    // add a trace event for a call of a node or of an entire recurrent loop
+    // Events beyond the maximum number given to the constructor are dropped.
+    void Trace(const ComputationNodeBasePtr& node, Pass pass, Clock::time_point begin, Clock::time_point end);
+
+    // print the aggregated statistics, slowest node first
+    void PrintTable(FILE* f, const std::string& title) const;
+
+    // write the trace events as a Chrome trace JSON file
+    void WriteChromeTrace(const std::wstring& fileName) const;
+
+    // rough number of floating-point operations of a node's ForwardProp() or Backprop() over the current minibatch
+    static double EstimateFlops(const ComputationNodeBasePtr& node, Pass pass);
+
+private:
+    struct NodeStats
+    {
+        std::wstring name;
+        std::wstring operation;
+        size_t calls[2] = {0, 0};
+        double seconds[2] = {0, 0};
+        double flops[2] = {0, 0};
+        size_t maxBytes[2] = {0, 0};
+    };
+    struct TraceEvent
+    {
+        size_t nodeIndex; // into m_traceNames
+        Pass pass;
+        size_t threadIndex; // into m_traceThreads
+        Clock::time_point begin;
+        Clock::duration duration;
+    };
+
+    NodeStats& GetStats(const ComputationNodeBasePtr& node);
+
+    std::mutex m_mutex;
+    Clock::time_point m_startTime;
+    std::unordered_map<const ComputationNodeBase*, size_t> m_nodeIndices; // node -> index into m_stats
+    std::vector<NodeStats> m_stats;
+    std::unordered_map<const ComputationNodeBase*, size_t> m_traceIndices; // node -> index into m_traceNames
+    std::vector<std::wstring> m_traceNames;
+    std::vector<std::thread::id> m_traceThreads;
+    std::vector<TraceEvent> m_traceEvents;
+    size_t m_maxTraceEvents;
+};
+
+typedef std::shared_ptr<NodeProfiler> NodeProfilerPtr;
+
+}}}
@@ -6,6 +6,7 @@
 
 #include "Basics.h"
 #include "ComputationNode.h"
+#include "ActivationStash.h"
 #include "Matrix.h"
 #include "TensorView.h"
 
@@ -55,6 +56,16 @@ public:
         result.DoUnaryOpOf(0, input, 1, opForward, opSum);
     }
 
+    virtual std::function<void(size_t)> /*ComputationNodeBase::*/ CaptureForwardStep() override
+    {
+        size_t rank = DetermineElementwiseTensorRank();
+        StepTensor<ElemType> result, input;
+        if (!StepTensor<ElemType>::TryCapture([&](const FrameRange& fr) { return             ValueTensorFor(rank, fr); }, GetMBLayout(), result) ||
+            !StepTensor<ElemType>::TryCapture([&](const FrameRange& fr) { return InputRef(0).ValueTensorFor(rank, fr); }, GetMBLayout(), input))
+            return nullptr;
+        return [result, input](size_t t) { result.At(t).DoUnaryOpOf(0, input.At(t), 1, opForward, opSum); };
+    }
+
     virtual void /*ComputationNode::*/ BackpropTo(const size_t inputIndex, const FrameRange& fr) override
     {
         assert(inputIndex == 0), inputIndex;
@@ -105,7 +116,6 @@ public:
 // Pass (Input)
 // SigmoidNode (input)
 // TanhNode (input)
-// RectifiedLinearNode (input)
 // LogNode (input)
 // ExpNode (input)
 // FloorNode (input)
@@ -147,7 +157,6 @@ DeclareUnaryElementWiseWithOpCodeNode(Log,             Log,             Elementw
 DeclareUnaryElementWiseWithOpCodeNode(Negate,          Negate,          Negate,                                                    unaryGradient);
 DeclareUnaryElementWiseWithOpCodeNode(Pass,            Copy,            Copy,                                                      unaryGradient);
 DeclareUnaryElementWiseWithOpCodeNode(Reciprocal,      Reciprocal,      ElementwiseProductWithReciprocalDerivative,                binaryWithOutputGradient);
-DeclareUnaryElementWiseWithOpCodeNode(RectifiedLinear, LinearRectifier, ElementwiseProductWithLinearRectifierDerivativeFromOutput, binaryWithOutputGradient);
 DeclareUnaryElementWiseWithOpCodeNode(Sigmoid,         Sigmoid,         ElementwiseProductWithSigmoidDerivativeFromOutput,         binaryWithOutputGradient);
 DeclareUnaryElementWiseWithOpCodeNode(Sin,             Sin,             ElementwiseProductWithSinDerivative,                       binaryWithInputGradient);
 DeclareUnaryElementWiseWithOpCodeNode(Sqrt,            Sqrt,            ElementwiseProductWithSqrtDerivative,                      binaryWithOutputGradient);
@@ -155,6 +164,68 @@ DeclareUnaryElementWiseWithOpCodeNode(Tanh,            Tanh,            Elementw
 
 #pragma pop_macro("DeclareUnaryElementWiseWithOpCodeNode")
 
+// -----------------------------------------------------------------------
+// RectifiedLinearNode (input)
+// Like the nodes above. With a compressed activation stash (see ActivationStash.h), backprop
+// uses a bitmask of the positive outputs instead of the output value.
+// -----------------------------------------------------------------------
+
+template <class ElemType>
+class RectifiedLinearNode : public UnaryElementWiseWithOpCodeNodeBase<ElemType, opLinearRectifier, opElementwiseProductWithLinearRectifierDerivativeFromOutput, binaryWithOutputGradient>
+{
+    typedef UnaryElementWiseWithOpCodeNodeBase<ElemType, opLinearRectifier, opElementwiseProductWithLinearRectifierDerivativeFromOutput, binaryWithOutputGradient> Base;
+    UnaryElementWiseWithOpCodeNodeBaseMembers;
+    static const std::wstring TypeName()
+    {
+        return L"RectifiedLinear";
+    }
+
+public:
+    DeclareConstructorFromConfigWithNumInputs(RectifiedLinearNode);
+    RectifiedLinearNode(DEVICEID_TYPE deviceId, const wstring& name)
+        : Base(deviceId, name)
+    {
+    }
+
+    virtual void /*ComputationNode::*/ ForwardProp(const FrameRange& fr) override
+    {
+        Base::ForwardProp(fr);
+        if (UseCompressedActivationStash() && !Environment().IsInferring() && InputRef(0).NeedsGradient())
+        {
+            auto sliceOutputValue = ValueFor(fr);
+            m_positiveOutputs.Resize(Value().GetNumElements());
+            m_positiveOutputs.Set(sliceOutputValue.Data() - Value().Data(), sliceOutputValue.Data(), sliceOutputValue.GetNumElements(), /*positiveOnly=*/true);
+        }
+    }
+
+    virtual std::function<void(size_t)> /*ComputationNodeBase::*/ CaptureForwardStep() override
+    {
+        return UseCompressedActivationStash() ? nullptr : Base::CaptureForwardStep(); // (the stash is written by ForwardProp())
+    }
+
+    virtual void /*ComputationNode::*/ BackpropTo(const size_t inputIndex, const FrameRange& fr) override
+    {
+        if (!UseCompressedActivationStash())
+        {
+            Base::BackpropTo(inputIndex, fr);
+            return;
+        }
+
+        // the value matrix may be in use by another node by now, so the position of the frames is taken from the gradient
+        auto sliceOutputGrad =             GradientFor(fr);
+        auto sliceInputGrad  = InputRef(0).GradientFor(fr);
+        m_positiveOutputs.AddMasked(sliceOutputGrad.Data() - Gradient().Data(), sliceOutputGrad.Data(), sliceInputGrad.Data(), sliceOutputGrad.GetNumElements());
+    }
+
+    virtual bool OutputUsedInComputingInputNodesGradients() const override
+    {
+        return !UseCompressedActivationStash();
+    }
+
+private:
+    ActivationBitmask m_positiveOutputs;
+};
+
 // -----------------------------------------------------------------------
 // SoftmaxNodeBase (input) -- shared base of Softmax and LogSoftmax
 // -----------------------------------------------------------------------
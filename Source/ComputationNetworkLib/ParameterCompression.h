@@ -0,0 +1,188 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// ParameterCompression.h -- lossy compression of parameter matrices for model distribution
+//
+// fp16:  each element as IEEE half-precision float
+// int8:  each element as an 8-bit code, with a separate value range per column (see ValueQuantizer)
+//
+#pragma once
+
+#include "Basics.h"
+#include "File.h"
+#include "Matrix.h"
+#include "ValueQuantizer.h"
+#include <vector>
+#include <algorithm>
+#include <string.h>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+enum class ParameterCompression : int
+{
+    none = 0,
+    fp16 = 1,
+    int8 = 2
+};
+
+static inline ParameterCompression ParseParameterCompression(const std::wstring& s)
+{
+    if (s == L"none")
+        return ParameterCompression::none;
+    else if (s == L"fp16")
+        return ParameterCompression::fp16;
+    else if (s == L"int8")
+        return ParameterCompression::int8;
+    else
+        InvalidArgument("ParseParameterCompression: '%ls' is not a valid parameter compression; use 'none', 'fp16', or 'int8'.", s.c_str());
+}
+
+// IEEE 754 half precision, rounding to nearest even
+static inline unsigned short FloatToHalf(float f)
+{
+    unsigned int x;
+    memcpy(&x, &f, sizeof(x));
+    const unsigned int sign = (x >> 16) & 0x8000;
+    const unsigned int floatExp = (x >> 23) & 0xff;
+    unsigned int mant = x & 0x7fffff;
+    if (floatExp == 0xff) // Inf or NaN
+        return (unsigned short)(sign | 0x7c00 | (mant ? 0x200 : 0));
+    const int exp = (int)floatExp - 127 + 15;
+    if (exp >= 0x1f) // overflow: Inf
+        return (unsigned short)(sign | 0x7c00);
+    unsigned int half, rem, halfway;
+    if (exp <= 0) // subnormal or 0
+    {
+        if (exp < -10)
+            return (unsigned short)sign;
+        mant |= 0x800000;
+        const unsigned int shift = 14 - exp;
+        half = mant >> shift;
+        rem = mant & ((1u << shift) - 1);
+        halfway = 1u << (shift - 1);
+    }
+    else
+    {
+        half = ((unsigned int)exp << 10) | (mant >> 13);
+        rem = mant & 0x1fff;
+        halfway = 0x1000;
+    }
+    if (rem > halfway || (rem == halfway && (half & 1)))
+        half++; // (a carry into the exponent is correct, including overflow to Inf)
+    return (unsigned short)(sign | half);
+}
+
+static inline float HalfToFloat(unsigned short h)
+{
+    const unsigned int sign = (unsigned int)(h & 0x8000) << 16;
+    unsigned int exp = (h >> 10) & 0x1f;
+    unsigned int mant = h & 0x3ff;
+    unsigned int x;
+    if (exp == 0x1f) // Inf or NaN
+        x = sign | 0x7f800000 | (mant << 13);
+    else if (exp != 0)
+        x = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+    else if (mant == 0)
+        x = sign;
+    else // subnormal: normalize
+    {
+        exp = 127 - 15 + 1;
+        while (!(mant & 0x400))
+        {
+            mant <<= 1;
+            exp--;
+        }
+        x = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+    }
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+// write a matrix in compressed form
+// Per-column ranges make no sense for vectors (e.g. biases), so these are stored as fp16 in int8 mode.
+// Format: <compression> <rows> <cols> <data>, where <data> is
+//  - none: the elements
+//  - fp16: the elements as half floats
+//  - int8: the lower and upper end of the range of each column as floats, followed by one byte per element
+template <class ElemType>
+void SaveCompressedMatrix(File& fstream, const Matrix<ElemType>& value, ParameterCompression compression)
+{
+    const size_t numRows = value.GetNumRows();
+    const size_t numCols = value.GetNumCols();
+    if (compression == ParameterCompression::int8 && (numRows < 2 || numCols < 2))
+        compression = ParameterCompression::fp16;
+
+    std::vector<ElemType> data(value.GetNumElements());
+    if (!data.empty())
+        value.CopySection(numRows, numCols, data.data(), numRows);
+
+    fstream << (int)compression << numRows << numCols;
+    if (compression == ParameterCompression::none)
+        fstream.WriteArray(data.data(), data.size());
+    else if (compression == ParameterCompression::fp16)
+    {
+        std::vector<unsigned short> halfs(data.size());
+        for (size_t i = 0; i < data.size(); i++)
+            halfs[i] = FloatToHalf((float)data[i]);
+        fstream.WriteArray(halfs.data(), halfs.size());
+    }
+    else
+    {
+        std::vector<float> lower(numCols), upper(numCols);
+        std::vector<unsigned char> codes(data.size());
+        for (size_t j = 0; j < numCols; j++)
+        {
+            const ElemType* col = data.data() + j * numRows;
+            lower[j] = (float)*std::min_element(col, col + numRows);
+            upper[j] = (float)*std::max_element(col, col + numRows);
+            ValueQuantizer<ElemType> quantizer(/*ldNbits=*/3, lower[j], upper[j]);
+            for (size_t i = 0; i < numRows; i++)
+                codes[j * numRows + i] = (unsigned char)quantizer.template Quantize<false>(col[i]);
+        }
+        fstream.WriteArray(lower.data(), lower.size());
+        fstream.WriteArray(upper.data(), upper.size());
+        fstream.WriteArray(codes.data(), codes.size());
+    }
+}
+
+// counterpart of SaveCompressedMatrix(); the matrix keeps its device
+template <class ElemType>
+void LoadCompressedMatrix(File& fstream, Matrix<ElemType>& value)
+{
+    int compression;
+    size_t numRows, numCols;
+    fstream >> compression >> numRows >> numCols;
+
+    std::vector<ElemType> data(numRows * numCols);
+    if (compression == (int)ParameterCompression::none)
+        fstream.ReadArray(data.data(), data.size());
+    else if (compression == (int)ParameterCompression::fp16)
+    {
+        std::vector<unsigned short> halfs(data.size());
+        fstream.ReadArray(halfs.data(), halfs.size());
+        for (size_t i = 0; i < data.size(); i++)
+            data[i] = (ElemType)HalfToFloat(halfs[i]);
+    }
+    else if (compression == (int)ParameterCompression::int8)
+    {
+        std::vector<float> lower(numCols), upper(numCols);
+        std::vector<unsigned char> codes(data.size());
+        fstream.ReadArray(lower.data(), lower.size());
+        fstream.ReadArray(upper.data(), upper.size());
+        fstream.ReadArray(codes.data(), codes.size());
+        for (size_t j = 0; j < numCols; j++)
+        {
+            ValueQuantizer<ElemType> quantizer(/*ldNbits=*/3, lower[j], upper[j]);
+            for (size_t i = 0; i < numRows; i++)
+                data[j * numRows + i] = quantizer.Unquantize(codes[j * numRows + i]);
+        }
+    }
+    else
+        RuntimeError("LoadCompressedMatrix: Unknown compression type %d.", compression);
+
+    value.SetValue(numRows, numCols, value.GetDeviceId(), data.data());
+}
+
+}}}
@@ -304,7 +304,7 @@ template<class ElemType, int direction>
             // truncated BPTT carry-over
             size_t T_delayedActivation = m_delayedActivationMBLayout ? m_delayedActivationMBLayout->GetNumTimeSteps() : 0; // (note: should never happen in full-sequence mode)
             auto tensorShape = GetTensorShape(rank);
-            auto slice = TensorSliceWithMBLayoutFor(tensorShape.GetDims(), FrameRange(m_delayedActivationMBLayout, t_delayed/*<0*/ + T_delayedActivation), m_delayedActivationMBLayout);
+            auto slice = TensorSliceWithMBLayoutFor(tensorShape.GetDims(), CarryOverFrameRange(fr, t_delayed/*<0*/ + T_delayedActivation), m_delayedActivationMBLayout);
             tensorShape.NarrowTo(slice);
             src = TensorView<ElemType>(m_delayedValue, tensorShape);
         }
@@ -379,7 +379,7 @@ template<class ElemType>
                 // truncated BPTT carry-over
                 size_t T_delayedActivation = m_delayedActivationMBLayout ? m_delayedActivationMBLayout->GetNumTimeSteps() : 0; // (note: should never happen in full-sequence mode)
                 auto tensorShape = GetTensorShape(rank);
-                auto slice = TensorSliceWithMBLayoutFor(tensorShape.GetDims(), FrameRange(m_delayedActivationMBLayout, t_delayed/*<0*/ + t_latency +  T_delayedActivation), m_delayedActivationMBLayout);
+                auto slice = TensorSliceWithMBLayoutFor(tensorShape.GetDims(), this->CarryOverFrameRange(fr, t_delayed/*<0*/ + t_latency +  T_delayedActivation), m_delayedActivationMBLayout);
                 tensorShape.NarrowTo(slice);
                 src = TensorView<ElemType>(m_delayedValue, tensorShape);
             }
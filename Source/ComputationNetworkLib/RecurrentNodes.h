@@ -69,6 +69,7 @@ public:
     virtual void /*ComputationNode::*/ BackpropTo(const size_t inputIndex, const FrameRange& fr) override;
     virtual bool OutputUsedInComputingInputNodesGradients() const override { return false; }
     virtual bool InputUsedInComputingInputNodesGradients(size_t /*childIndex*/) const override { return false; }
+    virtual bool CanRecomputeValue() const override { return false; } // forward prop carries state across minibatches
     virtual void /*ComputationNodeBase::*/ Validate(bool isFinalValidationPass) override;
     virtual int /*IRecurrentNode::*/ GetRecurrenceSteppingDirection() const override { return -direction; }
     virtual NodeStatePtr /*IStatefulNode::*/ ExportState() override;
@@ -77,6 +78,13 @@ public:
     ElemType InitialActivationValue() const { return m_initialStateValue; }
 
 protected:
+    // frame of m_delayedValue that a truncated sequence in fr continues from, narrowed like fr if its loop skips inactive sequences
+    FrameRange CarryOverFrameRange(const FrameRange& fr, size_t t) const
+    {
+        FrameRange frCarryOver(m_delayedActivationMBLayout, t);
+        return fr.HasSequencePrefix() ? frCarryOver.WithSequencePrefix(fr.m_seqPrefix) : frCarryOver;
+    }
+
     ElemType m_initialStateValue;                           // starting value for hidden activation vector at boundary
     int m_timeStep;                                         // delay in frames (typ. 1)
 
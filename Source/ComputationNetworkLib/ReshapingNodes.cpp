@@ -481,4 +481,194 @@ template <class ElemType>
 template class ScatterPackedNode<float>;
 template class ScatterPackedNode<double>;
 
+// -----------------------------------------------------------------------
+// ContextWindowNode(input, leftContext, rightContext, frameDim=0) -- splice each frame with its neighbors
+// -----------------------------------------------------------------------
+
+// Determines for each context position and output column the input column to copy from.
+// This resolves the sequence boundaries on the CPU, so that the device only performs Gather/Scatter.
+template <class ElemType>
+void ContextWindowNode<ElemType>::UpdatePackedIndex()
+{
+    let& pMBLayout = InputRef(0).GetMBLayout();
+    let numCols = pMBLayout->GetNumCols();
+    let numTimeSteps = (ptrdiff_t)pMBLayout->GetNumTimeSteps();
+    let numContextFrames = GetNumContextFrames();
+
+    m_packedIndexBuffer.assign(numContextFrames * numCols, (ElemType)-1); // -1 indicates a gap to Gather/Scatter
+    for (let& seq : pMBLayout->GetAllSequences())
+    {
+        if (seq.seqId == GAP_SEQUENCE_ID)
+            continue;
+        // the part of the sequence that is inside this minibatch, relative to the sequence start
+        let tFirst = (size_t)max(-seq.tBegin, (ptrdiff_t)0);
+        let tLast  = (size_t)min((ptrdiff_t)seq.GetNumTimeSteps(), numTimeSteps - seq.tBegin) - 1;
+        for (size_t t = tFirst; t <= tLast; t++)
+        {
+            let j = pMBLayout->GetColumnIndex(seq, t);
+            for (size_t k = 0; k < numContextFrames; k++)
+            {
+                let tSource = (ptrdiff_t)(t + k) - (ptrdiff_t)m_leftContext;
+                let tClamped = (size_t)min(max(tSource, (ptrdiff_t)tFirst), (ptrdiff_t)tLast); // index does not move beyond boundary
+                m_packedIndexBuffer[k * numCols + j] = (ElemType)pMBLayout->GetColumnIndex(seq, tClamped);
+            }
+        }
+    }
+    m_packedIndex->SetValue(1, m_packedIndexBuffer.size(), m_packedIndex->GetDeviceId(), m_packedIndexBuffer.data());
+}
+
+// Gathers the frames at the input locations, with their neighbors, from the chunks of the frame stores.
+// The indices are resolved on the CPU per chunk, like UpdatePackedIndex() does, so that the device only performs Gather.
+template <class ElemType>
+void ContextWindowNode<ElemType>::ForwardPropFromFrameStore()
+{
+    let& pMBLayout = InputRef(0).GetMBLayout();
+    let& input = InputRef(0).Value();
+    let numCols = input.GetNumCols();
+    let numContextFrames = GetNumContextFrames();
+
+    // the locations are a few numbers per column, hence they are resolved on the CPU
+    vector<ElemType> locations(FrameLocation::dim * numCols);
+    input.CopySection(FrameLocation::dim, numCols, locations.data(), FrameLocation::dim);
+
+    // the chunks used by this minibatch, with their frames on the device
+    for (auto& deviceChunk : m_deviceChunks)
+        deviceChunk.second.used = false;
+    vector<Matrix<ElemType>*> chunkFrames;        // [c]
+    map<pair<size_t, size_t>, size_t> chunkIndex; // (store id, chunk id) -> c
+    m_packedIndexBuffer.clear();                  // [(c * numContextFrames + k) * numCols + j]
+    for (let& seq : pMBLayout->GetAllSequences())
+    {
+        if (seq.seqId == GAP_SEQUENCE_ID)
+            continue;
+        for (size_t t = (size_t)max(seq.tBegin, (ptrdiff_t)0); t < min(seq.tEnd, pMBLayout->GetNumTimeSteps()); t++)
+        {
+            let j = pMBLayout->GetColumnIndex(seq, t - seq.tBegin);
+            let* location = &locations[j * FrameLocation::dim];
+            let key = make_pair((size_t)location[FrameLocation::storeId], (size_t)location[FrameLocation::chunkId]);
+            auto iter = chunkIndex.find(key);
+            if (iter == chunkIndex.end())
+            {
+                auto& deviceChunk = m_deviceChunks[key];
+                auto store = FrameStore::Get(key.first);
+                auto chunk = store ? store->GetChunk(key.second) : nullptr;
+                if (!chunk && !deviceChunk.frames)
+                    LogicError("%ls: The frames of chunk %d are no longer available from the reader.", NodeDescription().c_str(), (int)key.second);
+                if (chunk && chunk != deviceChunk.chunk) // (a chunk that is loaded again is uploaded again)
+                {
+                    if (chunk->frameDim != m_frameDim)
+                        InvalidArgument("%ls: The reader delivers frames of dimension %d, but frameDim is %d.", NodeDescription().c_str(), (int)chunk->frameDim, (int)m_frameDim);
+                    vector<ElemType> frames(chunk->frames.begin(), chunk->frames.end());
+                    deviceChunk.frames = make_shared<Matrix<ElemType>>(chunk->frameDim, chunk->numFrames, frames.data(), m_deviceId, matrixFlagNormal);
+                    deviceChunk.chunk = chunk;
+                }
+                deviceChunk.used = true;
+                iter = chunkIndex.insert(make_pair(key, chunkFrames.size())).first;
+                chunkFrames.push_back(deviceChunk.frames.get());
+                m_packedIndexBuffer.resize(chunkFrames.size() * numContextFrames * numCols, (ElemType)-1); // -1 indicates a gap to Gather
+            }
+            let c = iter->second;
+            let frame = (ptrdiff_t)location[FrameLocation::frame];
+            let first = (ptrdiff_t)location[FrameLocation::utteranceBegin];
+            let last = (ptrdiff_t)location[FrameLocation::utteranceEnd] - 1;
+            for (size_t k = 0; k < numContextFrames; k++)
+            {
+                let source = min(max(frame + (ptrdiff_t)k - (ptrdiff_t)m_leftContext, first), last); // index does not move beyond boundary
+                m_packedIndexBuffer[(c * numContextFrames + k) * numCols + j] = (ElemType)source;
+            }
+        }
+    }
+
+    // chunks that the reader has released and that this minibatch did not use are dropped
+    for (auto iter = m_deviceChunks.begin(); iter != m_deviceChunks.end();)
+    {
+        auto store = iter->second.used ? nullptr : FrameStore::Get(iter->first.first);
+        if (!iter->second.used && (!store || !store->GetChunk(iter->first.second)))
+            iter = m_deviceChunks.erase(iter);
+        else
+            iter++;
+    }
+
+    auto& output = Value();
+    if (chunkFrames.empty()) // (only gaps)
+    {
+        output.SetValue(0);
+        return;
+    }
+    m_packedIndex->SetValue(1, m_packedIndexBuffer.size(), m_packedIndex->GetDeviceId(), m_packedIndexBuffer.data());
+    for (size_t k = 0; k < numContextFrames; k++)
+    {
+        // each column is gathered from one chunk and skipped by the others
+        m_frameBuffer->Resize(m_frameDim, numCols);
+        m_frameBuffer->SetValue(0);
+        for (size_t c = 0; c < chunkFrames.size(); c++)
+            m_frameBuffer->DoGatherColumnsOf(/*beta=*/1, m_packedIndex->ColumnSlice((c * numContextFrames + k) * numCols, numCols), *chunkFrames[c], /*alpha=*/1);
+        output.AssignToRowSliceValuesOf(*m_frameBuffer, k * m_frameDim, m_frameDim);
+    }
+}
+
+template <class ElemType>
+/*virtual*/ void ContextWindowNode<ElemType>::ForwardPropNonLooping() /*override*/
+{
+    if (IsGatheringFromFrameStore())
+        return ForwardPropFromFrameStore();
+
+    UpdatePackedIndex();
+
+    let& input = InputRef(0).Value();
+    auto& output = Value();
+    let numCols = input.GetNumCols();
+    let inputDim = input.GetNumRows();
+    for (size_t k = 0; k < GetNumContextFrames(); k++)
+    {
+        m_frameBuffer->DoGatherColumnsOf(/*beta=*/0, m_packedIndex->ColumnSlice(k * numCols, numCols), input, /*alpha=*/1);
+        output.AssignToRowSliceValuesOf(*m_frameBuffer, k * inputDim, inputDim);
+    }
+}
+
+template <class ElemType>
+/*virtual*/ void ContextWindowNode<ElemType>::BackpropToNonLooping(size_t /*inputIndex*/) /*override*/
+{
+    if (IsGatheringFromFrameStore()) // frame locations have no gradient
+        return;
+
+    auto& inputGradient = InputRef(0).Gradient();
+    let& outputGradient = Gradient();
+    let numCols = inputGradient.GetNumCols();
+    let inputDim = inputGradient.GetNumRows();
+    for (size_t k = 0; k < GetNumContextFrames(); k++)
+    {
+        m_frameBuffer->AssignRowSliceValuesOf(outputGradient, k * inputDim, inputDim);
+        inputGradient.DoScatterColumnsOf(/*beta=*/1, m_packedIndex->ColumnSlice(k * numCols, numCols), *m_frameBuffer, /*alpha=*/1);
+    }
+}
+
+template <class ElemType>
+/*virtual*/ void ContextWindowNode<ElemType>::Validate(bool isFinalValidationPass) /*override*/
+{
+    Base::Validate(isFinalValidationPass);
+    InferMBLayoutFromInputsForStandardCase(isFinalValidationPass);
+
+    if (isFinalValidationPass && !HasMBLayout())
+        InvalidArgument("%ls requires its input to have a time dimension.", NodeDescription().c_str());
+
+    if (IsGatheringFromFrameStore())
+    {
+        if (isFinalValidationPass && GetInputSampleLayout(0).GetNumElements() != FrameLocation::dim)
+            InvalidArgument("%ls: With frameDim, the input must be the %d-dimensional frame locations that the reader delivers with deferContextExpansion in frame mode.",
+                            NodeDescription().c_str(), (int)FrameLocation::dim);
+        SetDims(TensorShape(m_frameDim * GetNumContextFrames()), HasMBLayout());
+        return;
+    }
+
+    // the context frames are stacked, so the trailing dimension gets multiplied (same as RowRepeat)
+    SmallVector<size_t> dims = GetInputSampleLayout(0).GetDims();
+    dims.back() *= GetNumContextFrames();
+
+    SetDims(TensorShape(dims), HasMBLayout());
+}
+
+template class ContextWindowNode<float>;
+template class ContextWindowNode<double>;
+
 }}}
@@ -10,6 +10,7 @@
 #include "Matrix.h"
 #include "ComputationNode.h"
 #include "Sequences.h"
+#include "FrameStore.h"
 
 #include <unordered_set>
 #include <map>
@@ -802,6 +803,121 @@ public:
     virtual void Validate(bool isFinalValidationPass) override;
 };
 
+// -----------------------------------------------------------------------
+// ContextWindowNode(input, leftContext, rightContext, frameDim=0) -- splice each frame with its neighbors
+// Output frame t is the row-wise stack of input frames t-leftContext..t+rightContext
+// of the same sequence. Frames outside of the sequence are replaced by its first/last
+// frame, which is the same expansion that the HTK reader does for 'contextWindow'.
+// This allows the reader to deliver the raw frames ('deferContextExpansion') and do
+// the expansion on the compute device instead of moving the expanded frames.
+// Note: With truncated BPTT, frames are clamped to the part of the sequence
+// that is inside the current minibatch.
+// In frame mode, every minibatch column is a sequence of its own, i.e. the neighbors are
+// not in the minibatch. There, the reader delivers the location of each frame instead
+// (see FrameLocation), and the node is given the dimension of the frames ('frameDim').
+// It then gathers each frame and its neighbors in the same utterance from the chunk
+// frames that the reader published in a FrameStore, which are moved to the device once
+// per chunk. Locations are not differentiable, so no gradient is passed back in this case.
+// -----------------------------------------------------------------------
+
+template <class ElemType>
+class ContextWindowNode : public ComputationNodeNonLooping<ElemType>, public NumInputs<1>
+{
+    typedef ComputationNodeNonLooping<ElemType> Base; UsingComputationNodeMembersBoilerplate;
+    static const std::wstring TypeName() { return L"ContextWindow"; }
+
+public:
+    ContextWindowNode(DEVICEID_TYPE deviceId, const wstring& name, size_t leftContext = 0, size_t rightContext = 0, size_t frameDim = 0)
+        : Base(deviceId, name),
+          m_leftContext(leftContext),
+          m_rightContext(rightContext),
+          m_frameDim(frameDim)
+    {
+    }
+    ContextWindowNode(const ScriptableObjects::IConfigRecordPtr configp)
+        : ContextWindowNode(configp->Get(L"deviceId"), L"<placeholder>", configp->Get(L"leftContext"), configp->Get(L"rightContext"), configp->Get(L"frameDim"))
+    {
+        AttachInputsFromConfig(configp, this->GetExpectedNumInputs());
+    }
+
+    virtual void CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const override
+    {
+        Base::CopyTo(nodeP, newName, flags);
+        if (flags & CopyNodeFlags::copyNodeValue)
+        {
+            auto node = dynamic_pointer_cast<ContextWindowNode<ElemType>>(nodeP);
+            node->m_leftContext = m_leftContext;
+            node->m_rightContext = m_rightContext;
+            node->m_frameDim = m_frameDim;
+        }
+    }
+
+    // Models without this node are unaffected by its format, so it does not need a new model version.
+    virtual void Save(File& fstream) const override
+    {
+        Base::Save(fstream);
+        fstream << m_leftContext << m_rightContext << m_frameDim;
+    }
+
+    virtual void Load(File& fstream, size_t modelVersion) override
+    {
+        Base::Load(fstream, modelVersion);
+        fstream >> m_leftContext >> m_rightContext >> m_frameDim;
+    }
+
+    virtual std::string FormatOperationPrototype(const std::string& extraArgs) const override
+    {
+        return Base::FormatOperationPrototype(extraArgs + msra::strfun::strprintf(", leftContext=%lu, rightContext=%lu, frameDim=%lu", m_leftContext, m_rightContext, m_frameDim));
+    }
+
+    virtual void /*ComputationNodeNonLooping::*/ ForwardPropNonLooping() override;
+    virtual void /*ComputationNodeNonLooping::*/ BackpropToNonLooping(size_t inputIndex) override;
+    virtual bool OutputUsedInComputingInputNodesGradients() const override { return false; }
+    virtual bool InputUsedInComputingInputNodesGradients(size_t /*childIndex*/) const override { return false; }
+    virtual void Validate(bool isFinalValidationPass) override;
+
+    virtual void RequestMatricesBeforeForwardProp(MatrixPool& matrixPool) override
+    {
+        Base::RequestMatricesBeforeForwardProp(matrixPool);
+        RequestMatrixFromPool(m_packedIndex, matrixPool);
+        RequestMatrixFromPool(m_frameBuffer, matrixPool);
+    }
+
+    virtual void ReleaseMatricesAfterBackprop(MatrixPool& matrixPool) override
+    {
+        Base::ReleaseMatricesAfterBackprop(matrixPool);
+        ReleaseMatrixToPool(m_packedIndex, matrixPool);
+        ReleaseMatrixToPool(m_frameBuffer, matrixPool);
+    }
+
+    size_t GetNumContextFrames() const { return m_leftContext + 1 + m_rightContext; }
+    bool IsGatheringFromFrameStore() const { return m_frameDim != 0; }
+
+private:
+    void UpdatePackedIndex();
+    void ForwardPropFromFrameStore();
+
+    size_t m_leftContext;
+    size_t m_rightContext;
+    size_t m_frameDim; // 0 unless the input holds frame locations
+
+    // the frames of the chunks used recently, on the device, by (store id, chunk id)
+    struct DeviceChunk
+    {
+        std::shared_ptr<const FrameStoreChunk> chunk; // what the frames were uploaded from
+        shared_ptr<Matrix<ElemType>> frames;
+        bool used;
+    };
+    std::map<std::pair<size_t, size_t>, DeviceChunk> m_deviceChunks;
+
+    // [0, k * numCols + j] column of the input that goes into context position k of output column j, -1 for gaps
+    shared_ptr<Matrix<ElemType>> m_packedIndex;
+    // holds one context position of all frames while moving it in and out of the stacked rows
+    shared_ptr<Matrix<ElemType>> m_frameBuffer;
+    // CPU-side buffer for creating m_packedIndex (kept as object state to avoid memory allocations)
+    std::vector<ElemType> m_packedIndexBuffer;
+};
+
 // -----------------------------------------------------------------------
 // DiagonalNode -- extract diagonal elements of a square matrix into a row vector
 // -----------------------------------------------------------------------
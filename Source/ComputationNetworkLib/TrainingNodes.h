@@ -6,6 +6,7 @@
 
 #include "Basics.h"
 #include "ComputationNode.h"
+#include "ActivationStash.h"
 #include "BatchNormalizationEngine.h"
 #include "RNGHandle.h"
 #include "CPURNGHandle.h"
@@ -1232,6 +1233,9 @@ public:
     virtual bool OutputUsedInComputingInputNodesGradients() const override { return false; }
 
     virtual bool InputUsedInComputingInputNodesGradients(size_t /*childIndex*/) const override { return false;}
+
+    virtual bool CanRecomputeValue() const override { return false; } // a recomputation would draw new samples
+
     virtual void /*ComputationNode::*/ ForwardPropNonLooping() override{}
 
 protected:
@@ -2084,7 +2088,9 @@ public:
         Matrix<ElemType> sliceInput0Grad = InputRef(0).GradientFor(fr);
         Matrix<ElemType> sliceOutputGrad = GradientFor(fr);
 
-        if (m_dropoutRate > 0)
+        if (m_dropoutRate > 0 && UseCompressedActivationStash()) // the mask is only kept as bits (see ActivationStash.h)
+            m_keptElements.AddMaskedProduct(sliceOutputGrad.Data() - Gradient().Data(), sliceOutputGrad.Data(), sliceInput0Grad.Data(), sliceOutputGrad.GetNumElements(), GetMaskScale());
+        else if (m_dropoutRate > 0)
             sliceInput0Grad.AddElementProductOf(sliceOutputGrad, DataFor(*m_maskOfDropout, fr));
         else
             sliceInput0Grad += sliceOutputGrad;
@@ -2092,6 +2098,7 @@ public:
 
     virtual bool OutputUsedInComputingInputNodesGradients() const override { return false; }
     virtual bool InputUsedInComputingInputNodesGradients(size_t /*childIndex*/) const override { return false; }
+    virtual bool CanRecomputeValue() const override { return false; } // a recomputation would draw a new mask
 
     virtual void UpdateFunctionMBSize() override
     {
@@ -2114,9 +2121,14 @@ public:
         {
             // determine drop-out mask for this minibatch
             auto sliceMask = DataFor(*m_maskOfDropout, fr);
-            sliceMask.SetUniformRandomMask((ElemType)m_dropoutRate, (ElemType)(1.0 / (1.0 - m_dropoutRate)) /*pre-scaled*/, GetRNGHandle());
+            sliceMask.SetUniformRandomMask((ElemType)m_dropoutRate, GetMaskScale() /*pre-scaled*/, GetRNGHandle());
             // apply dropout mask
             sliceOutputValue.AssignElementProductOf(sliceMask, sliceInput0Value);
+            if (UseCompressedActivationStash())
+            {
+                m_keptElements.Resize(m_maskOfDropout->GetNumElements());
+                m_keptElements.Set(sliceMask.Data() - m_maskOfDropout->Data(), sliceMask.Data(), sliceMask.GetNumElements(), /*positiveOnly=*/false);
+            }
         }
     }
 
@@ -2156,18 +2168,31 @@ public:
         RequestMatrixFromPool(m_maskOfDropout, matrixPool);
     }
 
+    // with a compressed activation stash, the mask is not needed by backprop
+    virtual void ReleaseMatricesAfterForwardProp(MatrixPool& matrixPool)
+    {
+        Base::ReleaseMatricesAfterForwardProp(matrixPool);
+        if (UseCompressedActivationStash())
+            ReleaseMatrixToPool(m_maskOfDropout, matrixPool);
+    }
+
     // release gradient and temp matrices that no longer needed after all the children's gradients are computed.
     virtual void ReleaseMatricesAfterBackprop(MatrixPool& matrixPool)
     {
         Base::ReleaseMatricesAfterBackprop(matrixPool);
-        ReleaseMatrixToPool(m_maskOfDropout, matrixPool);
+        if (!UseCompressedActivationStash())
+            ReleaseMatrixToPool(m_maskOfDropout, matrixPool);
     }
 
     double GetDropoutRate() const { return m_dropoutRate; }
 
 private:
+    // the value of the kept elements in the mask
+    ElemType GetMaskScale() const { return (ElemType)(1.0 / (1.0 - m_dropoutRate)); }
+
     double m_dropoutRate;
     shared_ptr<Matrix<ElemType>> m_maskOfDropout;
+    ActivationBitmask m_keptElements; // the mask as bits, with a compressed activation stash
 };
 
 template class DropoutNode<float>;
@@ -2525,6 +2550,7 @@ public:
     }
 
     virtual bool OutputUsedInComputingInputNodesGradients() const override { return false; }
+    virtual bool CanRecomputeValue() const override { return false; } // forward prop updates the running statistics
 
     void Validate(bool isFinalValidationPass) override
     {
@@ -44,6 +44,11 @@ void CNTKEvalBase<ElemType>::Init(const std::string& config)
     m_config.Parse(config);
     size_t nThreads = m_config("numCPUThreads", "1");
     CPUMatrix<ElemType>::SetNumThreads(nThreads);
+    ComputationNetwork::SetNumInterOpThreads(m_config(L"interOpThreads", (size_t)1));
+    ComputationNetwork::SetShrinkRecurrentLoops(m_config(L"shrinkRecurrentLoops", false));
+    ComputationNetwork::SetCaptureRecurrentSteps(m_config(L"captureRecurrentSteps", false), m_config(L"maxCapturedGeometries", (size_t)64));
+    ComputationNetwork::SetFuseElementwiseOps(m_config(L"fuseElementwiseOps", false));
+    ComputationNetwork::SetCacheStaticSubgraphs(m_config(L"cacheStaticSubgraphs", false));
     g_shareNodeValueMatrices = m_config(L"shareNodeValueMatrices", false);
 }
 
@@ -308,6 +313,46 @@ VariableSchema CNTKEvalExtended<ElemType>::GetInputSchema() const
     return inputLayouts;
 }
 
+template<typename ElemType>
+template<template<typename> class ValueContainer>
+size_t CNTKEvalExtended<ElemType>::GetNumberOfSamples(const ValueBuffer<ElemType, ValueContainer>& buffer, size_t inputIndex) const
+{
+    auto& inputNode = m_inputNodes[inputIndex];
+    auto matrix = dynamic_pointer_cast<Matrix<ElemType>>(inputNode->ValuePtr());
+    auto type = matrix->GetMatrixType();
+    size_t numRows = inputNode->GetSampleLayout().GetNumElements();
+
+    if (buffer.m_buffer.data() == nullptr)
+        RuntimeError("Input %ls: Buffer is not allocated.", inputNode->GetName().c_str());
+    if (type == MatrixType::DENSE)
+    {
+        if (buffer.m_buffer.size() % numRows != 0)
+            RuntimeError("Input %ls: Expected input data to be a multiple of %" PRIu64 ", but it is %" PRIu64 ".", 
+                         inputNode->GetName().c_str(), numRows, buffer.m_buffer.size());
+        if (buffer.m_buffer.size() == 0)
+            RuntimeError("Input %ls: Expected at least one element.", inputNode->GetName().c_str());
+    }
+    else if (type == MatrixType::SPARSE)
+    {
+        if (buffer.m_colIndices.data() == nullptr)
+            RuntimeError("Input %ls: Due to sparse input format, expected colIndices array, but was nullptr.", inputNode->GetName().c_str());
+        if (buffer.m_indices.data() == nullptr)
+            RuntimeError("Input %ls: Due to sparse input format, expected Indices array, but was nullptr.", inputNode->GetName().c_str());
+        if (buffer.m_colIndices.size() < 2)
+            RuntimeError("Input %ls: Expected at least one element (2 entries in colIndices array).", inputNode->GetName().c_str());
+        if (buffer.m_colIndices[0] != 0)
+            RuntimeError("Input %ls: First element of column indices must be 0", inputNode->GetName().c_str());
+        if (buffer.m_colIndices[buffer.m_colIndices.size() - 1] != buffer.m_indices.size())
+            RuntimeError("Input %ls: Last element of column indices must be equal to the size of indices (%ld), but was %d", 
+                         inputNode->GetName().c_str(), buffer.m_indices.size(), 
+                         buffer.m_colIndices[buffer.m_colIndices.size() - 1]);
+    }
+
+    size_t numCols = type == MatrixType::DENSE ? buffer.m_buffer.size() / numRows : buffer.m_colIndices.size() - 1;
+    assert(numCols >= 1);
+    return numCols;
+}
+
 template<typename ElemType>
 template<template<typename> class ValueContainer>
 void CNTKEvalExtended<ElemType>::ForwardPassT(const std::vector<ValueBuffer<ElemType, ValueContainer> >& inputs, std::vector<ValueBuffer<ElemType, ValueContainer> >& outputs, bool resetRNN)
@@ -321,6 +366,24 @@ void CNTKEvalExtended<ElemType>::ForwardPassT(const std::vector<ValueBuffer<Elem
     if (outputs.size() != m_outputNodes.size())
         RuntimeError("Expected %d outputs, but got %d.", (int)m_outputNodes.size(), (int)outputs.size());
 
+    // ValueRefs point to memory that the caller keeps alive for the duration of this call. On the CPU we bind
+    // the dense input matrices and, where the size is known upfront, the output matrices to that memory instead
+    // of copying. A bound matrix temporarily replaces the node's own one, which is moved back before returning,
+    // so that no matrix holds on to caller memory beyond this call.
+    const bool bindCallerBuffers = std::is_same<ValueContainer<ElemType>, VectorRef<ElemType>>::value;
+    std::vector<std::pair<shared_ptr<Matrix<ElemType>>, shared_ptr<Matrix<ElemType>>>> boundMatrices; // (bound matrix, its own storage)
+    auto bindCallerBuffer = [&boundMatrices](const shared_ptr<Matrix<ElemType>>& matrix, size_t numRows, size_t numCols, ElemType* data)
+    {
+        auto original = make_shared<Matrix<ElemType>>(std::move(*matrix));
+        *matrix = Matrix<ElemType>(numRows, numCols, data, CPUDEVICE, matrixFlagDontOwnBuffer);
+        boundMatrices.emplace_back(matrix, original);
+    };
+    auto unbindCallerBuffers = MakeScopeExit([&boundMatrices]()
+    {
+        for (auto& bound : boundMatrices)
+            *bound.first = std::move(*bound.second);
+    });
+
     size_t i = 0;
     for (auto& inputNode : m_inputNodes)
     {
@@ -331,40 +394,17 @@ void CNTKEvalExtended<ElemType>::ForwardPassT(const std::vector<ValueBuffer<Elem
         auto type = matrix->GetMatrixType();
         size_t numRows = inputNode->GetSampleLayout().GetNumElements();
 
-        if (buffer.m_buffer.data() == nullptr)
-            RuntimeError("Input %ls: Buffer is not allocated.", m_inputNodes[i]->GetName().c_str());
-        if (type == MatrixType::DENSE)
-        {
-            if (buffer.m_buffer.size() % numRows != 0)
-                RuntimeError("Input %ls: Expected input data to be a multiple of %" PRIu64 ", but it is %" PRIu64 ".", 
-                             m_inputNodes[i]->GetName().c_str(), numRows, buffer.m_buffer.size());
-            if (buffer.m_buffer.size() == 0)
-                RuntimeError("Input %ls: Expected at least one element.", m_inputNodes[i]->GetName().c_str());
-        }
-        else if (type == MatrixType::SPARSE)
-        {
-            if (buffer.m_colIndices.data() == nullptr)
-                RuntimeError("Input %ls: Due to sparse input format, expected colIndices array, but was nullptr.", m_inputNodes[i]->GetName().c_str());
-            if (buffer.m_indices.data() == nullptr)
-                RuntimeError("Input %ls: Due to sparse input format, expected Indices array, but was nullptr.", m_inputNodes[i]->GetName().c_str());
-            if (buffer.m_colIndices.size() < 2)
-                RuntimeError("Input %ls: Expected at least one element (2 entries in colIndices array).", m_inputNodes[i]->GetName().c_str());
-            if (buffer.m_colIndices[0] != 0)
-                RuntimeError("Input %ls: First element of column indices must be 0", m_inputNodes[i]->GetName().c_str());
-            if (buffer.m_colIndices[buffer.m_colIndices.size() - 1] != buffer.m_indices.size())
-                RuntimeError("Input %ls: Last element of column indices must be equal to the size of indices (%ld), but was %d", 
-                             m_inputNodes[i]->GetName().c_str(), buffer.m_indices.size(), 
-                             buffer.m_colIndices[buffer.m_colIndices.size() - 1]);
-        }
-
-        int numCols = type == MatrixType::DENSE ? buffer.m_buffer.size() / numRows : buffer.m_colIndices.size() - 1;
-        assert(numCols >= 1);
+        size_t numCols = GetNumberOfSamples(buffer, i);
         inputNode->GetMBLayout()->Init(1, numCols);
         
         // INT_MIN is used to specify the lower bound of look-back step of recurrent nodes
         inputNode->GetMBLayout()->AddSequence(0, 0, resetRNN ? 0 : INT_MIN, numCols);
 
-        if (type == MatrixType::DENSE)
+        if (type == MatrixType::DENSE && bindCallerBuffers && matrix->GetDeviceId() == CPUDEVICE)
+        {
+            bindCallerBuffer(matrix, numRows, numCols, buffer.m_buffer.data());
+        }
+        else if (type == MatrixType::DENSE)
             matrix->SetValue(numRows, numCols, matrix->GetDeviceId(), buffer.m_buffer.data(), matrixFlagNormal);
         else if (type == MatrixType::SPARSE)
         {
@@ -379,6 +419,34 @@ void CNTKEvalExtended<ElemType>::ForwardPassT(const std::vector<ValueBuffer<Elem
 
     ComputationNetwork::BumpEvalTimeStamp(m_inputNodes);
 
+    // A computed output that has the inputs' MBLayout, which is resized to [sample dim x MB columns] before it is
+    // computed, can be computed right into the caller's buffer, unless its matrix may be shared with other nodes
+    // (see AllocateAllMatrices()); those are copied out below. Outputs with a layout of their own only know their
+    // size after they have been computed. All outputs are bound before any of them is computed, since one output
+    // may be an input to another.
+    if (bindCallerBuffers)
+    {
+        for (size_t i = 0; i < m_outputNodes.size(); ++i)
+        {
+            auto node = m_outputNodes[i];
+            auto outputMatrix = dynamic_pointer_cast<Matrix<ElemType>>(node->ValuePtr());
+            bool hasInputLayout = node->HasMBLayout() &&
+                                  std::any_of(m_inputNodes.begin(), m_inputNodes.end(), [&node](const ComputationNodeBasePtr& inputNode) { return inputNode->GetMBLayout() == node->GetMBLayout(); });
+            if (node->IsLeaf() || !hasInputLayout || outputMatrix->GetDeviceId() != CPUDEVICE || outputMatrix->GetMatrixType() != MatrixType::DENSE)
+                continue;
+            if (g_shareNodeValueMatrices && node->IsValueSharable())
+                continue;
+
+            size_t numRows = node->GetSampleMatrixNumRows();
+            size_t numCols = node->GetMBLayout()->GetNumCols();
+            auto& vec = outputs[i].m_buffer;
+            if (numRows * numCols == 0 || vec.capacity() < numRows * numCols)
+                continue; // leave it to the copy below, which reports the error
+
+            bindCallerBuffer(outputMatrix, numRows, numCols, const_cast<ElemType*>(vec.data()));
+        }
+    }
+
     for (size_t i = 0; i < m_outputNodes.size(); ++i)
     {
         auto node = m_outputNodes[i];
@@ -407,8 +475,183 @@ void CNTKEvalExtended<ElemType>::ForwardPassT(const std::vector<ValueBuffer<Elem
 
         vec.resize(numElements);
         ElemType* data = const_cast<ElemType*>(vec.data());
-        outputMatrix->CopyToArray(data, numElements);
+        if (outputMatrix->Data() != data) // (already there if the output was bound to the buffer)
+            outputMatrix->CopyToArray(data, numElements);
+    }
+}
+
+// Packs the sequences of the batch into a single minibatch, with sequence s in parallel sequence s,
+// runs the network once and copies the columns of every output sequence back to its buffer.
+template<typename ElemType>
+template<template<typename> class ValueContainer>
+void CNTKEvalExtended<ElemType>::ForwardPassBatchT(const std::vector<std::vector<ValueBuffer<ElemType, ValueContainer>>>& inputs,
+                                                   std::vector<std::vector<ValueBuffer<ElemType, ValueContainer>>>& outputs, const std::vector<bool>& resetRNN)
+{
+    if (!m_started)
+        RuntimeError("ForwardPass() called before StartForwardEvaluation()");
+
+    size_t numSequences = inputs.size();
+    if (numSequences == 0)
+        RuntimeError("Expected at least one sequence.");
+    if (outputs.size() != numSequences)
+        RuntimeError("Expected outputs for %d sequences, but got %d.", (int)numSequences, (int)outputs.size());
+    if (resetRNN.size() != numSequences)
+        RuntimeError("Expected reset flags for %d sequences, but got %d.", (int)numSequences, (int)resetRNN.size());
+
+    size_t numInputs = (size_t)std::distance(m_inputMatrices.begin(), m_inputMatrices.end());
+    for (size_t s = 0; s < numSequences; ++s)
+    {
+        if (inputs[s].size() != numInputs)
+            RuntimeError("Sequence %d: Expected %d inputs, but got %d.", (int)s, (int)numInputs, (int)inputs[s].size());
+        if (outputs[s].size() != m_outputNodes.size())
+            RuntimeError("Sequence %d: Expected %d outputs, but got %d.", (int)s, (int)m_outputNodes.size(), (int)outputs[s].size());
+    }
+
+    std::vector<size_t> sequenceLengths(numSequences);
+    for (size_t i = 0; i < m_inputNodes.size(); ++i)
+    {
+        auto& inputNode = m_inputNodes[i];
+        auto matrix = dynamic_pointer_cast<Matrix<ElemType>>(inputNode->ValuePtr());
+        auto type = matrix->GetMatrixType();
+        size_t numRows = inputNode->GetSampleLayout().GetNumElements();
+
+        size_t maxLength = 0;
+        for (size_t s = 0; s < numSequences; ++s)
+        {
+            sequenceLengths[s] = GetNumberOfSamples(inputs[s][i], i);
+            maxLength = std::max(maxLength, sequenceLengths[s]);
+        }
+
+        auto& layout = inputNode->GetMBLayout();
+        layout->Init(numSequences, maxLength);
+        for (size_t s = 0; s < numSequences; ++s)
+        {
+            // INT_MIN is used to specify the lower bound of look-back step of recurrent nodes
+            layout->AddSequence(s, s, resetRNN[s] ? 0 : INT_MIN, sequenceLengths[s]);
+            if (sequenceLengths[s] < maxLength)
+                layout->AddGap(s, sequenceLengths[s], maxLength);
+        }
+
+        // Column t * numSequences + s holds sample t of sequence s, gaps are left empty.
+        size_t numCols = maxLength * numSequences;
+        if (type == MatrixType::DENSE)
+        {
+            m_packedValues.assign(numRows * numCols, 0);
+            for (size_t s = 0; s < numSequences; ++s)
+            {
+                const ElemType* source = inputs[s][i].m_buffer.data();
+                for (size_t t = 0; t < sequenceLengths[s]; ++t)
+                    memcpy(&m_packedValues[(t * numSequences + s) * numRows], source + t * numRows, numRows * sizeof(ElemType));
+            }
+
+            matrix->SetValue(numRows, numCols, matrix->GetDeviceId(), m_packedValues.data(), matrixFlagNormal);
+        }
+        else if (type == MatrixType::SPARSE)
+        {
+            m_packedValues.clear();
+            m_packedIndices.clear();
+            m_packedColIndices.assign(1, 0);
+            for (size_t t = 0; t < maxLength; ++t)
+            {
+                for (size_t s = 0; s < numSequences; ++s)
+                {
+                    if (t < sequenceLengths[s])
+                    {
+                        const auto& buffer = inputs[s][i];
+                        for (int k = buffer.m_colIndices[t]; k < buffer.m_colIndices[t + 1]; ++k)
+                        {
+                            m_packedValues.push_back(buffer.m_buffer[k]);
+                            m_packedIndices.push_back(buffer.m_indices[k]);
+                        }
+                    }
+
+                    m_packedColIndices.push_back((int)m_packedIndices.size());
+                }
+            }
+
+            matrix->SetMatrixFromCSCFormat(m_packedColIndices.data(), m_packedIndices.data(), m_packedValues.data(),
+                                           m_packedValues.size(), numRows, numCols);
+        }
     }
+
+    ComputationNetwork::BumpEvalTimeStamp(m_inputNodes);
+
+    std::vector<bool> found(numSequences);
+    for (size_t i = 0; i < m_outputNodes.size(); ++i)
+    {
+        auto node = m_outputNodes[i];
+        this->m_net->ForwardProp(node);
+        shared_ptr<Matrix<ElemType>> outputMatrix = dynamic_pointer_cast<Matrix<ElemType>>(node->ValuePtr());
+
+        size_t numElements = outputMatrix->GetNumElements();
+        size_t numRows = outputMatrix->GetNumRows();
+        m_packedValues.resize(numElements);
+        ElemType* packed = m_packedValues.data();
+        size_t packedSize = m_packedValues.size();
+        outputMatrix->CopyToArray(packed, packedSize);
+
+        auto pMBLayout = node->GetMBLayout();
+        if (!pMBLayout)
+        {
+            // Output does not depend on the dynamic axis: every sequence gets the full value.
+            for (size_t s = 0; s < numSequences; ++s)
+            {
+                ValueContainer<ElemType>& vec = outputs[s][i].m_buffer;
+                if (vec.capacity() < numElements)
+                    RuntimeError("Not enough space in output buffer for output '%ls' of sequence %d.", node->GetName().c_str(), (int)s);
+
+                vec.resize(numElements);
+                memcpy(const_cast<ElemType*>(vec.data()), packed, numElements * sizeof(ElemType));
+            }
+            continue;
+        }
+
+        std::fill(found.begin(), found.end(), false);
+        for (const auto& seq : pMBLayout->GetAllSequences())
+        {
+            if (seq.seqId == GAP_SEQUENCE_ID)
+                continue;
+            if (seq.seqId >= numSequences)
+                RuntimeError("Output '%ls' has an unexpected sequence %d.", node->GetName().c_str(), (int)seq.seqId);
+
+            // Only the part of the sequence that lies within this minibatch is returned.
+            size_t begin = (size_t)std::max(seq.tBegin, (ptrdiff_t)0);
+            size_t end = std::min(seq.tEnd, pMBLayout->GetNumTimeSteps());
+            size_t sequenceElements = (end - begin) * numRows;
+
+            ValueContainer<ElemType>& vec = outputs[seq.seqId][i].m_buffer;
+            if (vec.capacity() < sequenceElements)
+                RuntimeError("Not enough space in output buffer for output '%ls' of sequence %d.", node->GetName().c_str(), (int)seq.seqId);
+
+            vec.resize(sequenceElements);
+            ElemType* data = const_cast<ElemType*>(vec.data());
+            for (size_t t = begin; t < end; ++t)
+            {
+                size_t column = t * pMBLayout->GetNumParallelSequences() + seq.s;
+                memcpy(data + (t - begin) * numRows, packed + column * numRows, numRows * sizeof(ElemType));
+            }
+
+            found[seq.seqId] = true;
+        }
+
+        for (size_t s = 0; s < numSequences; ++s)
+        {
+            if (!found[s])
+                RuntimeError("Output '%ls' does not contain sequence %d.", node->GetName().c_str(), (int)s);
+        }
+    }
+}
+
+template<typename ElemType>
+void CNTKEvalExtended<ElemType>::ForwardPass(const std::vector<Values<ElemType>>& inputs, std::vector<Values<ElemType>>& outputs, const std::vector<bool>& resetRNN)
+{
+    ForwardPassBatchT(inputs, outputs, resetRNN);
+}
+
+template<typename ElemType>
+void CNTKEvalExtended<ElemType>::ForwardPass(const std::vector<ValueRefs<ElemType>>& inputs, std::vector<ValueRefs<ElemType>>& outputs, const std::vector<bool>& resetRNN)
+{
+    ForwardPassBatchT(inputs, outputs, resetRNN);
 }
 
 template<typename ElemType>
@@ -435,6 +678,18 @@ void CNTKEvalExtended<ElemType>::ForwardPass(const ValueRefs<ElemType>& inputs,
     ForwardPassT(inputs, outputs, resetRNN);
 }
 
+template <typename ElemType>
+IEvaluateModelExtended<ElemType>* CNTKEvalExtended<ElemType>::CloneSharingParameters()
+{
+    if (this->m_net == nullptr)
+        RuntimeError("CloneSharingParameters() called before CreateNetwork()");
+
+    auto clone = new CNTKEvalExtended<ElemType>();
+    clone->m_config = this->m_config;
+    clone->m_net = this->m_net->CloneSharingParameters();
+    return clone;
+}
+
 template <typename ElemType>
 void CNTKEvalExtended<ElemType>::Destroy()
 {
@@ -461,4 +716,347 @@ extern "C" EVAL_API void GetEvalExtendedD(IEvaluateModelExtended<double>** peval
 
 template class CNTKEvalExtended<double>;
 template class CNTKEvalExtended<float>;
+
+// ----------------------------------------------------------------------------
+// Batching interface
+// ----------------------------------------------------------------------------
+
+template <typename ElemType>
+CNTKEvalBatching<ElemType>::CNTKEvalBatching()
+    : m_eval(new CNTKEvalExtended<ElemType>()),
+    m_maxBatchSize(32),
+    m_maxBatchDelay(1000),
+    m_stopping(false),
+    m_batchSizes(m_maxBatchSize + 1),
+    m_queueLatencies(32)
+{
+}
+
+template <typename ElemType>
+CNTKEvalBatching<ElemType>::CNTKEvalBatching(CNTKEvalExtended<ElemType>* eval, size_t maxBatchSize, std::chrono::microseconds maxBatchDelay)
+    : m_eval(eval),
+    m_maxBatchSize(maxBatchSize),
+    m_maxBatchDelay(maxBatchDelay),
+    m_stopping(false),
+    m_batchSizes(m_maxBatchSize + 1),
+    m_queueLatencies(32)
+{
+}
+
+template <typename ElemType>
+IEvaluateModelExtended<ElemType>* CNTKEvalBatching<ElemType>::CloneSharingParameters()
+{
+    std::unique_lock<std::mutex> lock(m_evaluationLock);
+    auto eval = static_cast<CNTKEvalExtended<ElemType>*>(m_eval->CloneSharingParameters());
+    return new CNTKEvalBatching<ElemType>(eval, m_maxBatchSize, m_maxBatchDelay);
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::Init(const std::string& config)
+{
+    m_eval->Init(config);
+
+    ConfigParameters batchingConfig;
+    batchingConfig.Parse(config);
+    m_maxBatchSize = batchingConfig(L"maxBatchSize", (size_t)32);
+    if (m_maxBatchSize == 0)
+        InvalidArgument("maxBatchSize must be at least 1.");
+
+    double maxBatchDelay = batchingConfig(L"maxBatchDelay", 1.0);
+    if (maxBatchDelay < 0)
+        InvalidArgument("maxBatchDelay must not be negative.");
+    m_maxBatchDelay = std::chrono::microseconds((long long)(maxBatchDelay * 1000));
+
+    m_batchSizes.assign(m_maxBatchSize + 1, 0);
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::CreateNetwork(const std::string& networkDescription)
+{
+    m_eval->CreateNetwork(networkDescription);
+}
+
+template <typename ElemType>
+VariableSchema CNTKEvalBatching<ElemType>::GetOutputSchema() const
+{
+    return m_eval->GetOutputSchema();
+}
+
+template <typename ElemType>
+VariableSchema CNTKEvalBatching<ElemType>::GetInputSchema() const
+{
+    return m_eval->GetInputSchema();
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::StartForwardEvaluation(const std::vector<wstring>& outputs)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_evaluationLock);
+        m_eval->StartForwardEvaluation(outputs);
+        m_inputSchema = m_eval->GetInputSchema();
+        m_outputSchema = m_eval->GetOutputSchema();
+    }
+
+    if (!m_worker.joinable())
+        m_worker = std::thread([this]() { ProcessRequests(); });
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::Submit(const ValueRefs<ElemType>& inputs, ValueRefs<ElemType>& outputs, bool resetRNN)
+{
+    if (!m_worker.joinable())
+        RuntimeError("ForwardPass() called before StartForwardEvaluation()");
+    if (!resetRNN)
+        RuntimeError("The batching evaluator does not support carrying RNN state between requests.");
+    ValidateRequest(inputs, outputs);
+
+    Request request;
+    request.m_inputs = inputs;
+    request.m_outputs = &outputs;
+    auto done = request.m_done.get_future();
+    {
+        std::unique_lock<std::mutex> lock(m_queueLock);
+        if (m_stopping)
+            RuntimeError("ForwardPass() called after Destroy()");
+
+        request.m_enqueueTime = Clock::now();
+        m_queue.push_back(&request);
+    }
+
+    m_queueChanged.notify_one();
+
+    // Rethrows the exception of the batch evaluation if there was one.
+    done.get();
+}
+
+// A batch fails as a whole, hence requests that would make the evaluation fail are rejected before they join one.
+// This mirrors the checks of CNTKEvalExtended::ForwardPass() for a single request.
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::ValidateRequest(const ValueRefs<ElemType>& inputs, const ValueRefs<ElemType>& outputs) const
+{
+    if (inputs.size() != m_inputSchema.size())
+        RuntimeError("Expected %d inputs, but got %d.", (int)m_inputSchema.size(), (int)inputs.size());
+    if (outputs.size() != m_outputSchema.size())
+        RuntimeError("Expected %d outputs, but got %d.", (int)m_outputSchema.size(), (int)outputs.size());
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        const auto& layout = m_inputSchema[i];
+        const auto& buffer = inputs[i];
+        if (buffer.m_buffer.data() == nullptr)
+            RuntimeError("Input %ls: Buffer is not allocated.", layout.m_name.c_str());
+        if (layout.m_storageType == VariableLayout::Sparse)
+        {
+            if (buffer.m_colIndices.data() == nullptr || buffer.m_indices.data() == nullptr)
+                RuntimeError("Input %ls: Due to sparse input format, expected colIndices and indices arrays, but got nullptr.", layout.m_name.c_str());
+            if (buffer.m_colIndices.size() < 2)
+                RuntimeError("Input %ls: Expected at least one element (2 entries in colIndices array).", layout.m_name.c_str());
+        }
+        else
+        {
+            if (buffer.m_buffer.size() == 0)
+                RuntimeError("Input %ls: Expected at least one element.", layout.m_name.c_str());
+            if (buffer.m_buffer.size() % layout.m_numElements != 0)
+                RuntimeError("Input %ls: Expected input data to be a multiple of %" PRIu64 ", but it is %" PRIu64 ".",
+                             layout.m_name.c_str(), layout.m_numElements, buffer.m_buffer.size());
+        }
+    }
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::ProcessRequests()
+{
+    std::vector<Request*> batch;
+    std::vector<ValueRefs<ElemType>> inputs;
+    std::vector<ValueRefs<ElemType>> outputs;
+    for (;;)
+    {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock(m_queueLock);
+            m_queueChanged.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty())
+                return; // stopping and nothing left to do
+
+            // Let other requests join until the batch is full or the oldest request has waited long enough.
+            auto deadline = m_queue.front()->m_enqueueTime + m_maxBatchDelay;
+            m_queueChanged.wait_until(lock, deadline, [this]() { return m_stopping || m_queue.size() >= m_maxBatchSize; });
+
+            while (!m_queue.empty() && batch.size() < m_maxBatchSize)
+            {
+                batch.push_back(m_queue.front());
+                m_queue.pop_front();
+            }
+        }
+
+        auto start = Clock::now();
+        inputs.clear();
+        outputs.clear();
+        for (auto request : batch)
+        {
+            long long waited = std::chrono::duration_cast<std::chrono::microseconds>(start - request->m_enqueueTime).count();
+            size_t bucket = 0;
+            while (bucket + 1 < m_queueLatencies.size() && (1LL << bucket) <= waited)
+                bucket++;
+            m_queueLatencies[bucket]++;
+
+            inputs.push_back(request->m_inputs);
+            outputs.push_back(*request->m_outputs);
+        }
+        m_batchSizes[batch.size()]++;
+
+        try
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_evaluationLock);
+                m_eval->ForwardPass(inputs, outputs, std::vector<bool>(batch.size(), true));
+            }
+
+            // The outputs reference the callers' memory, only their sizes have to be handed back.
+            for (size_t k = 0; k < batch.size(); ++k)
+            {
+                for (size_t i = 0; i < outputs[k].size(); ++i)
+                    (*batch[k]->m_outputs)[i].m_buffer.resize(outputs[k][i].m_buffer.size());
+                batch[k]->m_done.set_value();
+            }
+        }
+        catch (...)
+        {
+            for (auto request : batch)
+                request->m_done.set_exception(std::current_exception());
+        }
+    }
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::ForwardPass(const ValueRefs<ElemType>& inputs, ValueRefs<ElemType>& outputs, bool resetRNN)
+{
+    Submit(inputs, outputs, resetRNN);
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::ForwardPass(const ValueRefs<ElemType>& inputs, ValueRefs<ElemType>& outputs)
+{
+    Submit(inputs, outputs, true);
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::ForwardPass(const Values<ElemType>& inputs, Values<ElemType>& outputs, bool resetRNN)
+{
+    // Requests are queued as references to the caller's vectors, so that no data is copied.
+    // const cast: the inputs are only read.
+    ValueRefs<ElemType> inputRefs(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        auto& buffer = const_cast<ValueBuffer<ElemType, Vector>&>(inputs[i]);
+        inputRefs[i].m_buffer.InitFrom(buffer.m_buffer);
+        inputRefs[i].m_indices.InitFrom(buffer.m_indices);
+        inputRefs[i].m_colIndices.InitFrom(buffer.m_colIndices);
+    }
+
+    // Output vectors are exposed with their full capacity and shrunk to the result afterwards.
+    ValueRefs<ElemType> outputRefs(outputs.size());
+    for (size_t i = 0; i < outputs.size(); ++i)
+    {
+        outputs[i].m_buffer.resize(outputs[i].m_buffer.capacity());
+        outputRefs[i].m_buffer.InitFrom(outputs[i].m_buffer);
+    }
+
+    Submit(inputRefs, outputRefs, resetRNN);
+
+    for (size_t i = 0; i < outputs.size(); ++i)
+        outputs[i].m_buffer.resize(outputRefs[i].m_buffer.size());
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::ForwardPass(const Values<ElemType>& inputs, Values<ElemType>& outputs)
+{
+    ForwardPass(inputs, outputs, true);
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::ForwardPass(const std::vector<Values<ElemType>>& inputs, std::vector<Values<ElemType>>& outputs, const std::vector<bool>& resetRNN)
+{
+    // Batches formed by the caller are evaluated as they are.
+    std::unique_lock<std::mutex> lock(m_evaluationLock);
+    m_eval->ForwardPass(inputs, outputs, resetRNN);
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::ForwardPass(const std::vector<ValueRefs<ElemType>>& inputs, std::vector<ValueRefs<ElemType>>& outputs, const std::vector<bool>& resetRNN)
+{
+    std::unique_lock<std::mutex> lock(m_evaluationLock);
+    m_eval->ForwardPass(inputs, outputs, resetRNN);
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::PrintStatistics() const
+{
+    size_t numRequests = 0;
+    size_t numBatches = 0;
+    for (size_t n = 0; n < m_batchSizes.size(); ++n)
+    {
+        numRequests += n * m_batchSizes[n];
+        numBatches += m_batchSizes[n];
+    }
+
+    if (numBatches == 0)
+        return;
+
+    fprintf(stderr, "CNTKEvalBatching: %d requests in %d batches, average batch size %.2f\n",
+            (int)numRequests, (int)numBatches, (double)numRequests / numBatches);
+
+    fprintf(stderr, "CNTKEvalBatching: batch size histogram:");
+    for (size_t n = 1; n < m_batchSizes.size(); ++n)
+    {
+        if (m_batchSizes[n] != 0)
+            fprintf(stderr, " %d:%d", (int)n, (int)m_batchSizes[n]);
+    }
+    fprintf(stderr, "\n");
+
+    fprintf(stderr, "CNTKEvalBatching: queue latency histogram (microseconds):");
+    for (size_t k = 0; k < m_queueLatencies.size(); ++k)
+    {
+        if (m_queueLatencies[k] != 0)
+            fprintf(stderr, " <%lld:%d", 1LL << k, (int)m_queueLatencies[k]);
+    }
+    fprintf(stderr, "\n");
+}
+
+template <typename ElemType>
+void CNTKEvalBatching<ElemType>::Destroy()
+{
+    // Let the worker finish the requests that are still queued.
+    {
+        std::unique_lock<std::mutex> lock(m_queueLock);
+        m_stopping = true;
+    }
+    m_queueChanged.notify_all();
+    if (m_worker.joinable())
+        m_worker.join();
+
+    PrintStatistics();
+
+    m_eval->Destroy();
+    delete this;
+}
+
+template <typename ElemType>
+void EVAL_API GetEvalExtendedBatching(IEvaluateModelExtended<ElemType>** peval)
+{
+    *peval = new CNTKEvalBatching<ElemType>();
+}
+
+extern "C" EVAL_API void GetEvalExtendedBatchingF(IEvaluateModelExtended<float>** peval)
+{
+    GetEvalExtendedBatching(peval);
+}
+extern "C" EVAL_API void GetEvalExtendedBatchingD(IEvaluateModelExtended<double>** peval)
+{
+    GetEvalExtendedBatching(peval);
+}
+
+template class CNTKEvalBatching<double>;
+template class CNTKEvalBatching<float>;
 } } }
@@ -13,6 +13,12 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <future>
+#include <chrono>
+#include <condition_variable>
 
 #include "Eval.h"
 #include "EvalReader.h"
@@ -107,6 +113,12 @@ public:
 
     virtual void ForwardPass(const ValueRefs<ElemType>& inputs, ValueRefs<ElemType>& output, bool resetRNN) override;
 
+    virtual void ForwardPass(const std::vector<Values<ElemType>>& inputs, std::vector<Values<ElemType>>& outputs, const std::vector<bool>& resetRNN) override;
+
+    virtual void ForwardPass(const std::vector<ValueRefs<ElemType>>& inputs, std::vector<ValueRefs<ElemType>>& outputs, const std::vector<bool>& resetRNN) override;
+
+    virtual IEvaluateModelExtended<ElemType>* CloneSharingParameters() override;
+
     virtual void Destroy() override;
 
     virtual void CreateNetwork(const std::string& networkDescription) override
@@ -127,9 +139,105 @@ private:
     StreamMinibatchInputs m_inputMatrices;
     bool m_started;
 
+    // Staging buffers used to pack batched inputs and to unpack batched outputs.
+    std::vector<ElemType> m_packedValues;
+    std::vector<int> m_packedIndices;
+    std::vector<int> m_packedColIndices;
+
     template<template<typename> class ValueContainer> 
     void ForwardPassT(const std::vector < ValueBuffer<ElemType, ValueContainer> >& inputs,
                       std::vector < ValueBuffer<ElemType, ValueContainer> >& outputs, bool resetRNN);
 
+    template<template<typename> class ValueContainer>
+    void ForwardPassBatchT(const std::vector<std::vector<ValueBuffer<ElemType, ValueContainer>>>& inputs,
+                           std::vector<std::vector<ValueBuffer<ElemType, ValueContainer>>>& outputs, const std::vector<bool>& resetRNN);
+
+    // Validates an input buffer and returns the number of samples it contains.
+    template<template<typename> class ValueContainer>
+    size_t GetNumberOfSamples(const ValueBuffer<ElemType, ValueContainer>& buffer, size_t inputIndex) const;
+
+};
+
+// ------------------------------------------------------------------------
+// Batching interface
+// ------------------------------------------------------------------------
+// Destroy() deletes the object through 'this' and the interface has no virtual destructor, so the class is final.
+template <typename ElemType>
+class CNTKEvalBatching final : public IEvaluateModelExtended<ElemType>
+{
+public:
+    CNTKEvalBatching();
+    CNTKEvalBatching(CNTKEvalExtended<ElemType>* eval, size_t maxBatchSize, std::chrono::microseconds maxBatchDelay);
+
+    virtual VariableSchema GetOutputSchema() const override;
+
+    virtual void StartForwardEvaluation(const std::vector<wstring>& outputs) override;
+
+    virtual VariableSchema GetInputSchema() const override;
+
+    virtual void ForwardPass(const Values<ElemType>& inputs, Values<ElemType>& output) override;
+
+    virtual void ForwardPass(const Values<ElemType>& inputs, Values<ElemType>& output, bool resetRNN) override;
+
+    virtual void ForwardPass(const ValueRefs<ElemType>& inputs, ValueRefs<ElemType>& output) override;
+
+    virtual void ForwardPass(const ValueRefs<ElemType>& inputs, ValueRefs<ElemType>& output, bool resetRNN) override;
+
+    virtual void ForwardPass(const std::vector<Values<ElemType>>& inputs, std::vector<Values<ElemType>>& outputs, const std::vector<bool>& resetRNN) override;
+
+    virtual void ForwardPass(const std::vector<ValueRefs<ElemType>>& inputs, std::vector<ValueRefs<ElemType>>& outputs, const std::vector<bool>& resetRNN) override;
+
+    virtual IEvaluateModelExtended<ElemType>* CloneSharingParameters() override;
+
+    virtual void CreateNetwork(const std::string& networkDescription) override;
+
+    virtual void Init(const std::string& config) override;
+
+    virtual void Destroy() override;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    // A single-sequence request waiting in the queue.
+    struct Request
+    {
+        ValueRefs<ElemType> m_inputs;
+        ValueRefs<ElemType>* m_outputs;
+        std::promise<void> m_done;
+        Clock::time_point m_enqueueTime;
+    };
+
+    // Queues the request and blocks until its batch has been evaluated.
+    void Submit(const ValueRefs<ElemType>& inputs, ValueRefs<ElemType>& outputs, bool resetRNN);
+
+    // Checks a request against the schemas, so that a bad request fails alone instead of failing its batch.
+    void ValidateRequest(const ValueRefs<ElemType>& inputs, const ValueRefs<ElemType>& outputs) const;
+
+    // Worker thread: collects batches from the queue and evaluates them.
+    void ProcessRequests();
+
+    void PrintStatistics() const;
+
+    // The evaluator doing the actual work. Only used under m_evaluationLock.
+    CNTKEvalExtended<ElemType>* m_eval;
+    std::mutex m_evaluationLock;
+
+    // Schemas of the started evaluation, for validating requests without taking m_evaluationLock.
+    VariableSchema m_inputSchema;
+    VariableSchema m_outputSchema;
+
+    size_t m_maxBatchSize;
+    std::chrono::microseconds m_maxBatchDelay;
+
+    std::deque<Request*> m_queue;
+    std::mutex m_queueLock;
+    std::condition_variable m_queueChanged;
+    std::thread m_worker;
+    bool m_stopping;
+
+    // Statistics: m_batchSizes[n] counts batches of n requests,
+    // m_queueLatencies[k] counts requests that waited less than 2^k microseconds.
+    std::vector<size_t> m_batchSizes;
+    std::vector<size_t> m_queueLatencies;
 };
 } } }
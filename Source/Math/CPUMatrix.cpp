@@ -6066,6 +6066,36 @@ int CPUMatrix<ElemType>::SetNumThreads(int numThreads)
     return numThreads;
 }
 
+// the number of threads that operations called from the current thread use
+// note: this function does not depend on the <ElemType> parameter
+template <class ElemType>
+int CPUMatrix<ElemType>::GetNumThreads()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// Like SetNumThreads(), but only for operations called from the current thread. This is used when
+// several threads run operations concurrently, to keep them from oversubscribing the cores.
+// note: this function does not depend on the <ElemType> parameter
+template <class ElemType>
+int CPUMatrix<ElemType>::SetNumThreadsForCurrentThread(int numThreads)
+{
+    numThreads = std::max(1, numThreads);
+#ifdef _OPENMP
+    omp_set_num_threads(numThreads); // (this is a per-thread setting in OpenMP)
+    numThreads = omp_get_max_threads();
+
+    #ifdef USE_MKL
+        mkl_set_num_threads_local(numThreads);
+    #endif
+#endif
+    return numThreads;
+}
+
 // To ensure Intel MKL calls return the same results on all Intel or Intel compatible CPUs,
 // the function set CBWR compatible mode.
 template <class ElemType>
@@ -0,0 +1,72 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#include "FrameStore.h"
+
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// all stores that exist, by id
+static mutex s_storesMutex;
+static map<size_t, weak_ptr<FrameStore>> s_stores;
+static size_t s_nextStoreId = 0;
+
+/*static*/ shared_ptr<FrameStore> FrameStore::Create()
+{
+    lock_guard<mutex> lock(s_storesMutex);
+    for (auto iter = s_stores.begin(); iter != s_stores.end();) // (drop the stores that are gone)
+    {
+        if (iter->second.expired())
+            iter = s_stores.erase(iter);
+        else
+            iter++;
+    }
+    shared_ptr<FrameStore> store(new FrameStore(s_nextStoreId++));
+    s_stores[store->GetId()] = store;
+    return store;
+}
+
+/*static*/ shared_ptr<FrameStore> FrameStore::Get(size_t id)
+{
+    lock_guard<mutex> lock(s_storesMutex);
+    auto iter = s_stores.find(id);
+    return iter != s_stores.end() ? iter->second.lock() : nullptr;
+}
+
+void FrameStore::AddChunk(size_t chunkId, shared_ptr<const FrameStoreChunk> chunk)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_chunks[chunkId] = chunk;
+}
+
+void FrameStore::RemoveChunk(size_t chunkId)
+{
+    lock_guard<mutex> lock(m_mutex);
+    auto iter = m_chunks.find(chunkId);
+    if (iter == m_chunks.end())
+        return;
+    m_removedChunks.push_back(*iter);
+    m_chunks.erase(iter);
+    if (m_removedChunks.size() > s_numRemovedChunksKept)
+        m_removedChunks.pop_front();
+}
+
+shared_ptr<const FrameStoreChunk> FrameStore::GetChunk(size_t chunkId) const
+{
+    lock_guard<mutex> lock(m_mutex);
+    auto iter = m_chunks.find(chunkId);
+    if (iter != m_chunks.end())
+        return iter->second;
+    for (auto removed = m_removedChunks.rbegin(); removed != m_removedChunks.rend(); removed++) // (the newest if loaded again)
+    {
+        if (removed->first == chunkId)
+            return removed->second;
+    }
+    return nullptr;
+}
+
+}}}
@@ -0,0 +1,86 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// FrameStore.h -- raw feature frames of the chunks that a reader has in memory, shared with the network
+//
+// With deferred context expansion in frame mode (HTKDataDeserializer option 'deferContextExpansion'), the reader
+// does not deliver the frames of a minibatch. For each frame, it delivers the frame's location instead: the
+// store, the chunk, the frame within the chunk, and the bounds of its utterance (see FrameLocation). The frames
+// of each chunk are published here once, when the chunk is loaded, and the ContextWindow node gathers each frame
+// with its context from them on the compute device. Each raw frame is thus moved once per chunk, rather than
+// once for every context position and every minibatch it is used in.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+#ifdef _WIN32
+#ifdef MATH_EXPORTS
+#define MATH_API __declspec(dllexport)
+#else
+#define MATH_API __declspec(dllimport)
+#endif
+#else // no DLLs on Linux
+#define MATH_API
+#endif
+
+// the sample of a frame location, as delivered by the reader
+struct FrameLocation
+{
+    enum : size_t
+    {
+        storeId,        // FrameStore::GetId()
+        chunkId,        // the chunk in the store
+        frame,          // index of the frame in the chunk
+        utteranceBegin, // first frame of its utterance in the chunk
+        utteranceEnd,   // one past the last frame of its utterance in the chunk
+        dim             // number of values
+    };
+};
+
+// the frames of a chunk, column by column without padding
+struct FrameStoreChunk
+{
+    size_t frameDim;
+    size_t numFrames;
+    std::vector<float> frames; // [frameDim * numFrames]
+};
+
+// Lives in the math library, so that the reader and the network, which are separate DLLs, see the same stores.
+class MATH_API FrameStore
+{
+public:
+    // a new store, e.g. one per deserializer; it is found by its id as long as it exists
+    static std::shared_ptr<FrameStore> Create();
+    static std::shared_ptr<FrameStore> Get(size_t id); // nullptr if it no longer exists
+
+    size_t GetId() const { return m_id; }
+
+    void AddChunk(size_t chunkId, std::shared_ptr<const FrameStoreChunk> chunk);
+    // The reader may have delivered locations in this chunk that the network has not consumed yet (prefetch), so
+    // the last few removed chunks are kept. A chunk holds far more frames than a few minibatches, hence this suffices.
+    void RemoveChunk(size_t chunkId);
+    std::shared_ptr<const FrameStoreChunk> GetChunk(size_t chunkId) const; // nullptr if not there
+
+private:
+    explicit FrameStore(size_t id) : m_id(id) { }
+
+    static const size_t s_numRemovedChunksKept = 2;
+
+    const size_t m_id;
+    mutable std::mutex m_mutex;
+    std::map<size_t, std::shared_ptr<const FrameStoreChunk>> m_chunks;
+    std::deque<std::pair<size_t, std::shared_ptr<const FrameStoreChunk>>> m_removedChunks; // oldest first
+};
+
+}}}
@@ -35,16 +35,20 @@ CNTKTextFormatReader::CNTKTextFormatReader(const ConfigParameters& config)
         if (configHelper.ShouldKeepDataInMemory())
             m_deserializer = make_shared<ChunkCache>(m_deserializer);
 
+        // Like verbosity, this is a general config parameter, not specific to the text format reader.
+        bool multiThreadedDeserialization = config(L"multiThreadedDeserialization", false);
+
         size_t window = configHelper.GetRandomizationWindow();
         if (window > 0)
         {
             // Verbosity is a general config parameter, not specific to the text format reader.
             int verbosity = config(L"verbosity", 0);
-            m_sequenceEnumerator = make_shared<BlockRandomizer>(verbosity, window, m_deserializer, true);
+            m_sequenceEnumerator = make_shared<BlockRandomizer>(verbosity, window, m_deserializer, true,
+                BlockRandomizer::DecimationMode::chunk, false, multiThreadedDeserialization);
         }
         else
         {
-            m_sequenceEnumerator = make_shared<NoRandomizer>(m_deserializer);
+            m_sequenceEnumerator = make_shared<NoRandomizer>(m_deserializer, multiThreadedDeserialization);
         }
 
         if (configHelper.IsInFrameMode()) 
@@ -57,7 +61,9 @@ CNTKTextFormatReader::CNTKTextFormatReader(const ConfigParameters& config)
         {
             m_packer = std::make_shared<SequencePacker>(
                 m_sequenceEnumerator,
-                ReaderBase::GetStreamDescriptions());
+                ReaderBase::GetStreamDescriptions(),
+                2,
+                config(L"sortParallelSequencesByLength", false));
         }
     }
     catch (const std::runtime_error& e)
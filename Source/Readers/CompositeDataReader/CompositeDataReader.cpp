@@ -91,7 +91,8 @@ CompositeDataReader::CompositeDataReader(const ConfigParameters& config) :
 
     // By default do not use omp threads for deserialization of sequences.
     // It makes sense to put it to true for cases when deserialization is CPU intensive,
-    // i.e. decompression of images.
+    // i.e. decompression of images. The same flag is used by the bundler to load chunks of
+    // different deserializers concurrently.
     bool multiThreadedDeserialization = config(L"multiThreadedDeserialization", false);
     if (randomize)
     {
@@ -107,9 +108,12 @@ CompositeDataReader::CompositeDataReader(const ConfigParameters& config) :
     }
 
     // In case when there are transforms, applying them to the data.
+    // By default different sequences and streams are transformed concurrently; this can be switched off,
+    // e.g. when transforms are cheap or to compare against the serial path.
+    bool multithreadedTransforms = config(L"multithreadedTransforms", true);
     m_sequenceEnumerator = m_transforms.empty()
         ? m_sequenceEnumerator
-        : std::make_shared<TransformController>(m_transforms, m_sequenceEnumerator);
+        : std::make_shared<TransformController>(m_transforms, m_sequenceEnumerator, multithreadedTransforms);
 
     // TODO: Creating output stream descriptions - this should come from the network so that we can check 
     // that input matches what the network expects (including tensor shape, etc.).
@@ -135,7 +139,9 @@ CompositeDataReader::CompositeDataReader(const ConfigParameters& config) :
     case PackingMode::sequence:
         m_packer = std::make_shared<SequencePacker>(
             m_sequenceEnumerator,
-            m_streams);
+            m_streams,
+            2,
+            config(L"sortParallelSequencesByLength", false));
         break;
     case PackingMode::truncated:
     {
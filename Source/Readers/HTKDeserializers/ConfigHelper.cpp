@@ -196,6 +196,18 @@ size_t ConfigHelper::GetRandomizationWindow()
     return result;
 }
 
+// Read from the feature stream's section for both configuration formats, like the other stream options.
+size_t ConfigHelper::GetChunkReadThreads() const
+{
+    size_t result = m_config(L"chunkReadThreads", (size_t)1);
+    if (result == 0)
+    {
+        InvalidArgument("chunkReadThreads must be at least 1.");
+    }
+
+    return result;
+}
+
 wstring ConfigHelper::GetRandomizer()
 {
     // Check (on the action) if we're writing (inputs only) or training/evaluating (inputs and outputs)
@@ -55,6 +55,9 @@ public:
     // Gets randomization window.
     size_t GetRandomizationWindow();
 
+    // Gets the maximum number of concurrent utterance reads when a chunk is paged in.
+    size_t GetChunkReadThreads() const;
+
     // Gets randomizer type - "auto" or "block"
     std::wstring GetRandomizer();
 
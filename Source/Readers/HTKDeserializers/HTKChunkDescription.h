@@ -11,6 +11,9 @@
 #include "../HTKMLFReader/htkfeatio.h"
 #include "UtteranceDescription.h"
 #include "ssematrix.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -115,10 +118,30 @@ public:
         return msra::dbn::matrixstripe(m_frames, ts, n);
     }
 
+    // Copies all frames of the chunk consecutively, without the column padding of the matrix.
+    std::vector<float> GetFramesWithoutPadding() const
+    {
+        if (!IsInRam())
+        {
+            LogicError("GetFramesWithoutPadding was called when data have not yet been paged in.");
+        }
+
+        const size_t numRows = m_frames.rows();
+        std::vector<float> frames(numRows * m_totalFrames);
+        for (size_t j = 0; j < m_totalFrames; ++j)
+        {
+            for (size_t i = 0; i < numRows; ++i)
+                frames[j * numRows + i] = m_frames(i, j);
+        }
+        return frames;
+    }
+
     // Pages-in the data for this chunk.
     // this function supports retrying since we read from the unreliable network, i.e. do not return in a broken state
     // We pass in the feature info variables to check that that data being read has expected properties.
-    void RequireData(const string& featureKind, size_t featureDimension, unsigned int samplePeriod, int verbosity = 0) const
+    // Up to numReadThreads utterance reads are issued concurrently, so that the load time of a chunk
+    // on network storage is bound by the bandwidth rather than by the latency of each read.
+    void RequireData(const string& featureKind, size_t featureDimension, unsigned int samplePeriod, int verbosity = 0, size_t numReadThreads = 1) const
     {
         if (GetNumberOfUtterances() == 0)
         {
@@ -132,17 +155,51 @@ public:
 
         try
         {
-            // feature reader (we reinstantiate it for each block, i.e. we reopen the file actually)
-            // if this is the first feature read ever, we explicitly open the first file to get the information such as feature dimension
-            msra::asr::htkfeatreader reader;
-
-            // read all utterances; if they are in the same archive, htkfeatreader will be efficient in not closing the file
             m_frames.resize(featureDimension, m_totalFrames);
-            foreach_index(i, m_utterances)
+            if (numReadThreads <= 1 || m_utterances.size() == 1)
             {
-                // read features for this file
-                auto framesWrapper = GetUtteranceFrames(i);
-                reader.read(m_utterances[i].GetPath(), featureKind, samplePeriod, framesWrapper);
+                ReadUtterances(0, m_utterances.size(), featureKind, samplePeriod);
+            }
+            else
+            {
+                // Each group is read by its own reader into a disjoint range of frames.
+                // This runs on plain threads rather than OpenMP: RequireData() is called from within the parallel
+                // chunk loading of the bundler, where a nested OpenMP region would silently run on one thread.
+                // Exceptions cannot leave a thread, so the first one is kept and rethrown afterwards.
+                const auto groups = GetReadGroupBoundaries(numReadThreads);
+                const size_t numGroups = groups.size() - 1;
+                std::atomic<size_t> nextGroup(0);
+                std::exception_ptr readError;
+                std::mutex readErrorLock;
+                auto readGroups = [&]()
+                {
+                    for (size_t g = nextGroup++; g < numGroups; g = nextGroup++)
+                    {
+                        try
+                        {
+                            ReadUtterances(groups[g], groups[g + 1], featureKind, samplePeriod);
+                        }
+                        catch (...)
+                        {
+                            std::lock_guard<std::mutex> lock(readErrorLock);
+                            if (!readError)
+                                readError = std::current_exception();
+                        }
+                    }
+                };
+
+                // the calling thread is one of the readers
+                std::vector<std::thread> readers;
+                for (size_t i = 1; i < std::min(numReadThreads, numGroups); ++i)
+                    readers.push_back(std::thread(readGroups));
+                readGroups();
+                for (auto& reader : readers)
+                    reader.join();
+
+                if (readError)
+                {
+                    std::rethrow_exception(readError);
+                }
             }
 
             if (verbosity)
@@ -194,6 +251,41 @@ public:
         {
             return !m_frames.empty();
         }
+
+        // Reads utterances [begin, end) into their frames of the chunk.
+        void ReadUtterances(size_t begin, size_t end, const string& featureKind, unsigned int samplePeriod) const
+        {
+            // feature reader (we reinstantiate it for each block, i.e. we reopen the file actually)
+            msra::asr::htkfeatreader reader;
+
+            // if utterances are in the same archive, htkfeatreader will be efficient in not closing the file
+            for (size_t i = begin; i < end; ++i)
+            {
+                // read features for this file
+                auto framesWrapper = GetUtteranceFrames(i);
+                reader.read(m_utterances[i].GetPath(), featureKind, samplePeriod, framesWrapper);
+            }
+        }
+
+        // Splits the utterances into groups of consecutive utterances from the same physical file.
+        // The group size is limited, so that a chunk stored in a single archive is still read by all readers.
+        // Returns group boundaries, i.e. group g consists of utterances [result[g], result[g + 1]).
+        std::vector<size_t> GetReadGroupBoundaries(size_t numReadThreads) const
+        {
+            const size_t maxGroupSize = (m_utterances.size() + numReadThreads - 1) / numReadThreads;
+            std::vector<size_t> boundaries(1, 0);
+            for (size_t i = 1; i < m_utterances.size(); ++i)
+            {
+                if (i - boundaries.back() >= maxGroupSize ||
+                    m_utterances[i].GetPath().physicallocation() != m_utterances[i - 1].GetPath().physicallocation())
+                {
+                    boundaries.push_back(i);
+                }
+            }
+
+            boundaries.push_back(m_utterances.size());
+            return boundaries;
+        }
 };
 
 }}}
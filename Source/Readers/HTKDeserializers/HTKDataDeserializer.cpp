@@ -58,9 +58,16 @@ HTKDataDeserializer::HTKDataDeserializer(
     ConfigHelper config(streamConfig);
     auto context = config.GetContextWindow();
 
+    m_chunkReadThreads = config.GetChunkReadThreads();
+
+    m_deferContextExpansion = streamConfig(L"deferContextExpansion", false);
+
     m_elementType = AreEqualIgnoreCase(precision,  L"float") ? ElementType::tfloat : ElementType::tdouble;
     m_dimension = config.GetFeatureDimension();
-    m_dimension = m_dimension * (1 + context.first + context.second);
+    if (!m_deferContextExpansion)
+        m_dimension = m_dimension * (1 + context.first + context.second);
+    else if (m_frameMode)
+        m_dimension = FrameLocation::dim; // see InitializeAugmentationWindow()
 
     InitializeChunkDescriptions(config);
     InitializeStreams(inputName);
@@ -89,8 +96,14 @@ HTKDataDeserializer::HTKDataDeserializer(
     auto context = config.GetContextWindow();
     m_elementType = config.GetElementType();
 
+    m_deferContextExpansion = feature(L"deferContextExpansion", false);
+    m_chunkReadThreads = config.GetChunkReadThreads();
+
     m_dimension = config.GetFeatureDimension();
-    m_dimension = m_dimension * (1 + context.first + context.second);
+    if (!m_deferContextExpansion)
+        m_dimension = m_dimension * (1 + context.first + context.second);
+    else if (m_frameMode)
+        m_dimension = FrameLocation::dim; // see InitializeAugmentationWindow()
 
     m_expandToPrimary = feature(L"expandToUtterance", false);
     if (m_expandToPrimary && m_primary)
@@ -108,6 +121,38 @@ void HTKDataDeserializer::InitializeAugmentationWindow(ConfigHelper& config)
 {
     m_augmentationWindow = config.GetContextWindow();
 
+    // The frames are delivered as they are, the network expands them (ContextWindow node) on the compute device.
+    // In sequence mode, the neighbors of a frame are part of the same minibatch, and the MBLayout tells where.
+    // In frame mode, every frame of the minibatch is randomized on its own, and its neighbors are not delivered.
+    // Delivering them along with each frame would mean transferring the expanded frames again. Instead, each
+    // frame is delivered as its location (see FrameLocation), and the frames of each loaded chunk are published
+    // once in a FrameStore, from which the ContextWindow node gathers the frame and its neighbors.
+    if (m_deferContextExpansion)
+    {
+        if (m_frameMode)
+        {
+            m_frameStore = FrameStore::Create();
+            fprintf(stderr, "HTKDataDeserializer::HTKDataDeserializer: frame mode with deferred context expansion, "
+                            "frames are delivered as %d-dimensional locations, "
+                            "please use ContextWindow(features, %d, %d, frameDim=%d) in the network\n",
+                    (int)FrameLocation::dim, (int)m_augmentationWindow.first, (int)m_augmentationWindow.second,
+                    (int)m_ioFeatureDimension);
+            m_augmentationWindow = make_pair(0, 0);
+            return;
+        }
+
+        if (m_augmentationWindow.first != 0 || m_augmentationWindow.second != 0)
+        {
+            fprintf(stderr, "HTKDataDeserializer::HTKDataDeserializer: context expansion (%d, %d) is deferred, "
+                            "please use ContextWindow(features, %d, %d) in the network\n",
+                    (int)m_augmentationWindow.first, (int)m_augmentationWindow.second,
+                    (int)m_augmentationWindow.first, (int)m_augmentationWindow.second);
+        }
+
+        m_augmentationWindow = make_pair(0, 0);
+        return;
+    }
+
     // If not given explicitly, we need to identify the required augmentation range from the expected dimension
     // and the number of dimensions in the file.
     if (m_augmentationWindow.first == 0 && m_augmentationWindow.second == 0)
@@ -339,8 +384,18 @@ public:
         // making several attempts
         msra::util::attempt(5, [&]()
         {
-            chunkDescription.RequireData(m_parent->m_featureKind, m_parent->m_ioFeatureDimension, m_parent->m_samplePeriod, m_parent->m_verbosity);
+            chunkDescription.RequireData(m_parent->m_featureKind, m_parent->m_ioFeatureDimension, m_parent->m_samplePeriod, m_parent->m_verbosity, m_parent->m_chunkReadThreads);
         });
+
+        // frames are gathered by the network, see InitializeAugmentationWindow()
+        if (m_parent->m_frameStore)
+        {
+            auto frames = make_shared<FrameStoreChunk>();
+            frames->frameDim = m_parent->m_ioFeatureDimension;
+            frames->numFrames = chunkDescription.GetTotalFrames();
+            frames->frames = chunkDescription.GetFramesWithoutPadding();
+            m_parent->m_frameStore->AddChunk(m_chunkId, frames);
+        }
     }
 
     // Gets data for the sequence.
@@ -352,6 +407,9 @@ public:
     // Unloads the data from memory.
     ~HTKChunk()
     {
+        if (m_parent->m_frameStore)
+            m_parent->m_frameStore->RemoveChunk(m_chunkId);
+
         auto& chunkDescription = m_parent->m_chunks[m_chunkId];
         chunkDescription.ReleaseData(m_parent->m_verbosity);
     }
@@ -494,6 +552,23 @@ void HTKDataDeserializer::GetSequenceById(ChunkIdType chunkId, size_t id, vector
     const auto& chunkDescription = m_chunks[chunkId];
     size_t utteranceIndex = m_frameMode ? chunkDescription.GetUtteranceForChunkFrameIndex(id) : id;
     const UtteranceDescription* utterance = chunkDescription.GetUtterance(utteranceIndex);
+
+    if (m_frameStore) // deliver the location of the frame only, the network gathers it with its neighbors
+    {
+        FeatureMatrix location(FrameLocation::dim, 1);
+        auto fillIn = location.col(0);
+        size_t firstFrame = chunkDescription.GetStartFrameIndexInsideChunk(utteranceIndex);
+        fillIn[FrameLocation::storeId] = (float)m_frameStore->GetId();
+        fillIn[FrameLocation::chunkId] = (float)chunkId;
+        fillIn[FrameLocation::frame] = (float)id;
+        fillIn[FrameLocation::utteranceBegin] = (float)firstFrame;
+        fillIn[FrameLocation::utteranceEnd] = (float)(firstFrame + utterance->GetNumberOfFrames());
+        if (m_elementType == ElementType::tdouble)
+            r.push_back(make_shared<HTKDoubleSequenceData>(location));
+        else
+            r.push_back(make_shared<HTKFloatSequenceData>(std::move(location)));
+        return;
+    }
     auto utteranceFrames = chunkDescription.GetUtteranceFrames(utteranceIndex);
 
     // wrapper that allows m[j].size() and m[j][i] as required by augmentneighbors()
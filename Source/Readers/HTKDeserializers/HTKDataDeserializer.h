@@ -11,6 +11,7 @@
 #include "UtteranceDescription.h"
 #include "HTKChunkDescription.h"
 #include "ConfigHelper.h"
+#include "FrameStore.h"
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -88,6 +89,17 @@ private:
     // A flag that indicates whether the utterance should be extended to match the lenght of the utterance from the primary deserializer.
     // TODO: This should be moved to the packers when deserializers work in sequence mode only.
     bool m_expandToPrimary;
+
+    // Maximum number of concurrent utterance reads when a chunk is paged in.
+    size_t m_chunkReadThreads;
+
+    // A flag that indicates whether the context expansion is left to the network (ContextWindow node).
+    // In this case raw frames are delivered, which reduces reader memory and transfer by the context width.
+    bool m_deferContextExpansion;
+
+    // With deferred context expansion in frame mode, the frames of the loaded chunks, from which the network
+    // gathers the frames at the delivered locations. Not used otherwise.
+    std::shared_ptr<FrameStore> m_frameStore;
 };
 
 typedef std::shared_ptr<HTKDataDeserializer> HTKDataDeserializerPtr;
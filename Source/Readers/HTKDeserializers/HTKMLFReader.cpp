@@ -154,7 +154,7 @@ HTKMLFReader::HTKMLFReader(const ConfigParameters& readerConfig)
         m_packer = std::make_shared<FramePacker>(m_sequenceEnumerator, m_streams);
         break;
     case PackingMode::sequence:
-        m_packer = std::make_shared<SequencePacker>(m_sequenceEnumerator, m_streams);
+        m_packer = std::make_shared<SequencePacker>(m_sequenceEnumerator, m_streams, 2, readerConfig(L"sortParallelSequencesByLength", false));
         break;
     case PackingMode::truncated:
         m_packer = std::make_shared<TruncatedBPTTPacker>(m_sequenceEnumerator, m_streams);
@@ -14,6 +14,8 @@
 #include "../HTKMLFReader/msra_mgram.h"
 #include "latticearchive.h"
 #include "StringUtil.h"
+#include <atomic>
+#include <sys/stat.h>
 
 
 #undef max // max is defined in minwindef.h
@@ -25,8 +27,8 @@ using namespace std;
 static float s_oneFloat = 1.0;
 static double s_oneDouble = 1.0;
 
-// Currently we only have a single mlf chunk that contains a vector of all labels.
-// TODO: In the future MLF should be converted to a more compact format that is amenable to chunking.
+// Currently we only have a single mlf chunk that contains run-length encoded labels of all utterances.
+// TODO: In the future MLF labels should be chunked.
 class MLFDataDeserializer::MLFChunk : public Chunk
 {
     MLFDataDeserializer* m_parent;
@@ -75,7 +77,8 @@ MLFDataDeserializer::MLFDataDeserializer(CorpusDescriptorPtr corpus, const Confi
     size_t dimension = config.GetLabelDimension();
 
     wstring labelMappingFile = streamConfig(L"labelMappingFile", L"");
-    InitializeChunkDescriptions(corpus, config, labelMappingFile, dimension);
+    wstring cacheFile = streamConfig(L"mlfCacheFile", L"");
+    InitializeChunkDescriptions(corpus, config, labelMappingFile, dimension, cacheFile);
     InitializeStream(inputName, dimension);
 }
 
@@ -101,20 +104,113 @@ MLFDataDeserializer::MLFDataDeserializer(CorpusDescriptorPtr corpus, const Confi
     m_elementType = AreEqualIgnoreCase(precision, L"float") ? ElementType::tfloat : ElementType::tdouble;
 
     wstring labelMappingFile = labelConfig(L"labelMappingFile", L"");
-    InitializeChunkDescriptions(corpus, config, labelMappingFile, dimension);
+    wstring cacheFile = labelConfig(L"mlfCacheFile", L"");
+    InitializeChunkDescriptions(corpus, config, labelMappingFile, dimension, cacheFile);
     InitializeStream(name, dimension);
 }
 
 // Currently we create a single chunk only.
-void MLFDataDeserializer::InitializeChunkDescriptions(CorpusDescriptorPtr corpus, const ConfigHelper& config, const wstring& stateListPath, size_t dimension)
+void MLFDataDeserializer::InitializeChunkDescriptions(CorpusDescriptorPtr corpus, const ConfigHelper& config, const wstring& stateListPath, size_t dimension, const wstring& cachePath)
 {
     // TODO: Similarly to the old reader, currently we assume all Mlfs will have same root name (key)
     // restrict MLF reader to these files--will make stuff much faster without having to use shortened input files
+    vector<wstring> mlfPaths = config.GetMlfPaths();
+    const auto& stringRegistry = corpus->GetStringRegistry();
+
+    // TODO resize m_keyToSequence with number of IDs from string registry
+    m_utteranceIndex.push_back(0);
+    m_utteranceSpanIndex.push_back(0);
+
+    if (cachePath.empty() || !ReadCache(mlfPaths, stateListPath, dimension, cachePath, stringRegistry))
+    {
+        ParseMlf(mlfPaths, stateListPath, dimension, cachePath, stringRegistry);
+    }
+
+    m_totalNumberOfFrames = m_utteranceIndex[m_utteranceIndex.size() - 1];
+
+    fprintf(stderr, "MLFDataDeserializer::MLFDataDeserializer: %" PRIu64 " utterances with %" PRIu64 " frames in %" PRIu64 " classes (%" PRIu64 " label spans)\n",
+            m_numberOfSequences,
+            m_totalNumberOfFrames,
+            m_numberOfClasses,
+            m_spans.size());
+
+    // Initializing array of labels.
+    m_categories.reserve(dimension);
+    m_categoryIndices.reserve(dimension);
+    for (size_t i = 0; i < dimension; ++i)
+    {
+        auto category = make_shared<CategorySequenceData>();
+        m_categoryIndices.push_back(static_cast<IndexType>(i));
+        category->m_indices = &(m_categoryIndices[i]);
+        category->m_nnzCounts.resize(1);
+        category->m_nnzCounts[0] = 1;
+        category->m_totalNnzCount = 1;
+        category->m_numberOfSamples = 1;
+        if (m_elementType == ElementType::tfloat)
+        {
+            category->m_data = &s_oneFloat;
+        }
+        else
+        {
+            assert(m_elementType == ElementType::tdouble);
+            category->m_data = &s_oneDouble;
+        }
+        m_categories.push_back(category);
+    }
+}
+
+// Binary label cache layout:
+//   "MLFC" tag, version, label dimension, number of source files,
+//   per source file: path, size and modification time (so that a changed source invalidates the cache),
+//   then per utterance: key, number of frames, number of spans, spans;
+//   the utterances are terminated by an empty key, followed by the "EMLF" tag and the file offset of that tag.
+// The trailing offset lets a reader detect a truncated cache before parsing it.
+static const int s_mlfCacheVersion = 2;
+
+// Size and modification time of a file, or (0, 0) if there is no such file.
+static pair<int64_t, int64_t> GetFileStamp(const wstring& path)
+{
+    if (path.empty())
+        return make_pair(0, 0);
+#ifdef _WIN32
+    struct _stat64 info;
+    if (_wstat64(path.c_str(), &info) != 0)
+        return make_pair(0, 0);
+#else
+    struct stat info;
+    if (stat(wtocharpath(path).c_str(), &info) != 0)
+        return make_pair(0, 0);
+#endif
+    return make_pair((int64_t)info.st_size, (int64_t)info.st_mtime);
+}
+
+// Each writer gets its own temporary file, so that processes that share a cache file do not overwrite each other's partial output.
+static wstring GetTemporaryCachePath(const wstring& cachePath)
+{
+    static atomic<size_t> s_counter(0);
+    return cachePath + L"." + to_wstring(GetCurrentProcessId()) + L"." + to_wstring(s_counter++) + L".tmp";
+}
 
+static void WriteCacheHeader(FILE* cache, const vector<wstring>& sources, size_t dimension)
+{
+    fputTag(cache, "MLFC");
+    fputint(cache, s_mlfCacheVersion);
+    fwriteOrDie(&dimension, sizeof(dimension), 1, cache);
+    fputint(cache, (int)sources.size());
+    for (const auto& source : sources)
+    {
+        auto stamp = GetFileStamp(source);
+        fputstring(cache, source);
+        fwriteOrDie(&stamp.first, sizeof(stamp.first), 1, cache);
+        fwriteOrDie(&stamp.second, sizeof(stamp.second), 1, cache);
+    }
+}
+
+void MLFDataDeserializer::ParseMlf(const vector<wstring>& mlfPaths, const wstring& stateListPath, size_t dimension, const wstring& cachePath, const StringToIdMap& stringRegistry)
+{
     // TODO: currently we do not use symbol and word tables.
     const msra::lm::CSymbolSet* wordTable = nullptr;
     unordered_map<const char*, int>* symbolTable = nullptr;
-    vector<wstring> mlfPaths = config.GetMlfPaths();
 
     // TODO: Currently we still use the old IO module. This will be refactored later.
     const double htkTimeToFrame = 100000.0; // default is 10ms
@@ -127,27 +223,41 @@ void MLFDataDeserializer::InitializeChunkDescriptions(CorpusDescriptorPtr corpus
         msra::lattices::lattice::htkmlfwordsequence >> ::value,
         "Type 'msra::asr::htkmlfreader' should be move constructible!");
 
-    MLFUtterance description;
-    size_t numClasses = 0;
-    size_t totalFrames = 0;
-
-    const auto& stringRegistry = corpus->GetStringRegistry();
+    // The cache is written to a temporary file first, so that an interrupted run does not leave a broken cache behind.
+    // It contains all utterances of the MLF, not only those of the current corpus, so that it can be shared across configurations.
+    // The cache is an optimization only: if it cannot be written, we warn and go on without it.
+    const wstring temporaryCachePath = cachePath.empty() ? wstring() : GetTemporaryCachePath(cachePath);
+    // Closing the file is not checked here: failures of the final close are reported explicitly below, all others abandon the cache anyway.
+    struct FileCloser { void operator()(FILE* f) const { ::fclose(f); } };
+    unique_ptr<FILE, FileCloser> cache;
+    auto abandonCache = [&](const exception& e)
+    {
+        fprintf(stderr, "WARNING: MLFDataDeserializer: cannot write label cache '%ls', continuing without it: %s\n", cachePath.c_str(), e.what());
+        cache.reset();
+        _wunlink(temporaryCachePath.c_str());
+    };
 
-    // TODO resize m_keyToSequence with number of IDs from string registry
+    if (!cachePath.empty())
+    {
+        try
+        {
+            vector<wstring> sources(mlfPaths);
+            sources.push_back(stateListPath);
+            cache.reset(fopenOrDie(temporaryCachePath, L"wb"));
+            WriteCacheHeader(cache.get(), sources, dimension);
+        }
+        catch (const exception& e)
+        {
+            abandonCache(e);
+        }
+    }
 
+    vector<MLFSpan> spans;
     for (const auto& l : labels)
     {
-        // Currently the string registry contains only utterances described in scp.
-        // So here we skip all others.
-        size_t id = 0;
-        if (!stringRegistry.TryGet(msra::strfun::utf8(l.first), id))
-            continue;
-
-        description.m_key.m_sequence = id;
-
         const auto& utterance = l.second;
-        description.m_sequenceStart = m_classIds.size();
-        uint32_t numberOfFrames = 0;
+        spans.clear();
+        size_t numberOfFrames = 0;
 
         foreach_index(i, utterance)
         {
@@ -173,59 +283,179 @@ void MLFDataDeserializer::InitializeChunkDescriptions(CorpusDescriptorPtr corpus
                 RuntimeError("Maximum number of sample per sequence exceeded.");
             }
 
-            numClasses = max(numClasses, (size_t)(1u + timespan.classid));
+            // Neighboring time spans with the same class id are merged into a single span.
+            for (size_t remaining = timespan.numframes; remaining > 0;)
+            {
+                if (spans.empty() || spans.back().m_classId != timespan.classid || spans.back().m_numberOfFrames == numeric_limits<uint16_t>::max())
+                {
+                    spans.push_back(MLFSpan{ static_cast<msra::dbn::CLASSIDTYPE>(timespan.classid), 0 });
+                }
+
+                size_t framesInSpan = min(remaining, (size_t)(numeric_limits<uint16_t>::max() - spans.back().m_numberOfFrames));
+                spans.back().m_numberOfFrames += (uint16_t)framesInSpan;
+                remaining -= framesInSpan;
+            }
+
+            numberOfFrames += timespan.numframes;
+        }
 
-            for (size_t t = timespan.firstframe; t < timespan.firstframe + timespan.numframes; t++)
+        string key = msra::strfun::utf8(l.first);
+        if (cache)
+        {
+            try
+            {
+                fputstring(cache.get(), key);
+                fwriteOrDie(&numberOfFrames, sizeof(numberOfFrames), 1, cache.get());
+                fputint(cache.get(), (int)spans.size());
+                fwriteOrDie(spans, cache.get());
+            }
+            catch (const exception& e)
             {
-                m_classIds.push_back(timespan.classid);
-                numberOfFrames++;
+                abandonCache(e);
             }
         }
 
-        description.m_numberOfSamples = numberOfFrames;
-        m_utteranceIndex.push_back(totalFrames);
-        totalFrames += numberOfFrames;
+        AddUtterance(key, spans, numberOfFrames, stringRegistry);
+    }
 
-        if (m_keyToSequence.size() <= description.m_key.m_sequence)
+    if (cache)
+    {
+        try
         {
-            m_keyToSequence.resize(description.m_key.m_sequence + 1, SIZE_MAX);
+            fputstring(cache.get(), "");
+            uint64_t endTagPosition = fgetpos(cache.get());
+            fputTag(cache.get(), "EMLF");
+            fwriteOrDie(&endTagPosition, sizeof(endTagPosition), 1, cache.get());
+            if (::fclose(cache.release()) != 0)
+            {
+                RuntimeError("error closing '%ls'", temporaryCachePath.c_str());
+            }
+
+            renameOrDie(temporaryCachePath, cachePath);
+            fprintf(stderr, "MLFDataDeserializer::MLFDataDeserializer: wrote label cache '%ls'\n", cachePath.c_str());
+        }
+        catch (const exception& e)
+        {
+            abandonCache(e);
         }
-        assert(m_keyToSequence[description.m_key.m_sequence] == SIZE_MAX);
-        m_keyToSequence[description.m_key.m_sequence] = m_utteranceIndex.size() - 1;
-        m_numberOfSequences++;
     }
-    m_utteranceIndex.push_back(totalFrames);
-
-    m_totalNumberOfFrames = totalFrames;
+}
 
-    fprintf(stderr, "MLFDataDeserializer::MLFDataDeserializer: %" PRIu64 " utterances with %" PRIu64 " frames in %" PRIu64 " classes\n",
-            m_numberOfSequences,
-            m_totalNumberOfFrames,
-            numClasses);
+bool MLFDataDeserializer::ReadCache(const vector<wstring>& mlfPaths, const wstring& stateListPath, size_t dimension, const wstring& cachePath, const StringToIdMap& stringRegistry)
+{
+    if (!fexists(cachePath))
+        return false;
 
-    // Initializing array of labels.
-    m_categories.reserve(dimension);
-    m_categoryIndices.reserve(dimension);
-    for (size_t i = 0; i < dimension; ++i)
+    // Anything unexpected in the cache (truncation, corruption, a different format) makes us parse the MLF instead.
+    try
     {
-        auto category = make_shared<CategorySequenceData>();
-        m_categoryIndices.push_back(static_cast<IndexType>(i));
-        category->m_indices = &(m_categoryIndices[i]);
-        category->m_nnzCounts.resize(1);
-        category->m_nnzCounts[0] = 1;
-        category->m_totalNnzCount = 1;
-        category->m_numberOfSamples = 1;
-        if (m_elementType == ElementType::tfloat)
+        auto_file_ptr cache(fopenOrDie(cachePath, L"rb"));
+
+        // The last bytes are the offset of the end tag; if the file was cut off they do not point to it.
+        uint64_t endTagPosition = 0;
+        const uint64_t fileSize = filesize(cache);
+        const uint64_t trailerSize = 4 + sizeof(endTagPosition);
+        if (fileSize < trailerSize)
+            RuntimeError("the file is truncated");
+        fsetpos(cache, fileSize - sizeof(endTagPosition));
+        freadOrDie(&endTagPosition, sizeof(endTagPosition), 1, cache);
+        if (endTagPosition != fileSize - trailerSize)
+            RuntimeError("the file is truncated");
+        fsetpos(cache, endTagPosition);
+        fcheckTag(cache, "EMLF");
+        fsetpos(cache, (uint64_t)0);
+
+        fcheckTag(cache, "MLFC");
+        if (fgetint(cache) != s_mlfCacheVersion)
+            RuntimeError("the file has an unsupported version");
+
+        // The cache must have been created from the same, unchanged files with the same label dimension.
+        size_t cachedDimension = 0;
+        freadOrDie(&cachedDimension, sizeof(cachedDimension), 1, cache);
+        vector<wstring> expectedSources(mlfPaths);
+        expectedSources.push_back(stateListPath);
+        bool matches = cachedDimension == dimension && (size_t)fgetint(cache) == expectedSources.size();
+        for (size_t i = 0; matches && i < expectedSources.size(); ++i)
         {
-            category->m_data = &s_oneFloat;
+            pair<int64_t, int64_t> stamp;
+            wstring source = fgetwstring(cache);
+            freadOrDie(&stamp.first, sizeof(stamp.first), 1, cache);
+            freadOrDie(&stamp.second, sizeof(stamp.second), 1, cache);
+            matches = source == expectedSources[i] && stamp == GetFileStamp(source);
         }
-        else
+
+        if (!matches)
         {
-            assert(m_elementType == ElementType::tdouble);
-            category->m_data = &s_oneDouble;
+            fprintf(stderr, "MLFDataDeserializer::MLFDataDeserializer: label cache '%ls' is outdated or was created for a different configuration, ignoring it\n", cachePath.c_str());
+            return false;
         }
-        m_categories.push_back(category);
+
+        vector<MLFSpan> spans;
+        for (string key = fgetstring(cache); !key.empty(); key = fgetstring(cache))
+        {
+            size_t numberOfFrames = 0;
+            freadOrDie(&numberOfFrames, sizeof(numberOfFrames), 1, cache);
+            freadOrDie(spans, (size_t)fgetint(cache), cache);
+            AddUtterance(key, spans, numberOfFrames, stringRegistry);
+        }
+
+        if (fgetpos(cache) != endTagPosition)
+            RuntimeError("the utterances do not end at the end tag");
+    }
+    catch (const exception& e)
+    {
+        fprintf(stderr, "WARNING: MLFDataDeserializer: cannot read label cache '%ls', parsing the MLF instead: %s\n", cachePath.c_str(), e.what());
+        ResetLabels();
+        return false;
+    }
+
+    fprintf(stderr, "MLFDataDeserializer::MLFDataDeserializer: read labels from cache '%ls'\n", cachePath.c_str());
+    return true;
+}
+
+// Drops the labels added so far, e.g. from a cache that turned out to be broken.
+void MLFDataDeserializer::ResetLabels()
+{
+    m_spans.resize(0);
+    m_spanBlockFirstFrame.resize(0);
+    m_utteranceSpanIndex.resize(1);
+    m_utteranceIndex.resize(1);
+    m_keyToSequence.clear();
+    m_numberOfSequences = 0;
+    m_numberOfClasses = 0;
+}
+
+void MLFDataDeserializer::AddUtterance(const string& key, const vector<MLFSpan>& spans, size_t numberOfFrames, const StringToIdMap& stringRegistry)
+{
+    // Currently the string registry contains only utterances described in scp.
+    // So here we skip all others.
+    size_t id = 0;
+    if (!stringRegistry.TryGet(key, id))
+        return;
+
+    size_t frame = m_utteranceIndex[m_utteranceIndex.size() - 1];
+    for (const auto& span : spans)
+    {
+        if (m_spans.size() % s_spansPerBlock == 0)
+        {
+            m_spanBlockFirstFrame.push_back(frame);
+        }
+
+        m_spans.push_back(span);
+        frame += span.m_numberOfFrames;
+        m_numberOfClasses = max(m_numberOfClasses, (size_t)(1u + span.m_classId));
+    }
+
+    m_utteranceSpanIndex.push_back(m_spans.size());
+    m_utteranceIndex.push_back(m_utteranceIndex[m_utteranceIndex.size() - 1] + numberOfFrames);
+
+    if (m_keyToSequence.size() <= id)
+    {
+        m_keyToSequence.resize(id + 1, SIZE_MAX);
     }
+    assert(m_keyToSequence[id] == SIZE_MAX);
+    m_keyToSequence[id] = m_numberOfSequences;
+    m_numberOfSequences++;
 }
 
 void MLFDataDeserializer::InitializeStream(const wstring& name, size_t dimension)
@@ -298,11 +528,38 @@ struct MLFSequenceData : SparseSequenceData
     }
 };
 
+// The spans of all utterances cover the frames of the corpus one after the other, so the label of a frame
+// is found by binary search over the first frames of the span blocks and a scan of at most s_spansPerBlock spans.
+msra::dbn::CLASSIDTYPE MLFDataDeserializer::GetLabelForFrame(size_t frameIndex) const
+{
+    assert(frameIndex < m_totalNumberOfFrames);
+    size_t low = 0, high = m_spanBlockFirstFrame.size();
+    while (high - low > 1)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (m_spanBlockFirstFrame[middle] <= frameIndex)
+            low = middle;
+        else
+            high = middle;
+    }
+
+    size_t frame = m_spanBlockFirstFrame[low];
+    size_t end = min((low + 1) * s_spansPerBlock, m_spans.size());
+    for (size_t i = low * s_spansPerBlock; i < end; ++i)
+    {
+        frame += m_spans[i].m_numberOfFrames;
+        if (frameIndex < frame)
+            return m_spans[i].m_classId;
+    }
+
+    LogicError("MLFDataDeserializer: frame %" PRIu64 " is not covered by the labels.", frameIndex);
+}
+
 void MLFDataDeserializer::GetSequenceById(size_t sequenceId, vector<SequenceDataPtr>& result)
 {
     if (m_frameMode)
     {
-        size_t label = m_classIds[sequenceId];
+        size_t label = GetLabelForFrame(sequenceId);
         assert(label < m_categories.size());
         result.push_back(m_categories[label]);
     }
@@ -322,12 +579,17 @@ void MLFDataDeserializer::GetSequenceById(size_t sequenceId, vector<SequenceData
             s = make_shared<MLFSequenceData<double>>(numberOfSamples);
         }
 
-        for (size_t i = 0; i < numberOfSamples; i++)
+        // Expanding the spans of the utterance.
+        size_t i = 0;
+        for (size_t spanIndex = m_utteranceSpanIndex[sequenceId]; spanIndex < m_utteranceSpanIndex[sequenceId + 1]; ++spanIndex)
         {
-            size_t frameIndex = startFrameIndex + i;
-            size_t label = m_classIds[frameIndex];
-            s->m_indices[i] = static_cast<IndexType>(label);
+            const auto& span = m_spans[spanIndex];
+            for (size_t k = 0; k < span.m_numberOfFrames; ++k)
+            {
+                s->m_indices[i++] = static_cast<IndexType>(span.m_classId);
+            }
         }
+        assert(i == numberOfSamples);
         result.push_back(s);
     }
 }
@@ -41,11 +41,33 @@ private:
     class MLFChunk;
     DISABLE_COPY_AND_MOVE(MLFDataDeserializer);
 
-    void InitializeChunkDescriptions(CorpusDescriptorPtr corpus, const ConfigHelper& config, const std::wstring& stateListPath, size_t dimension);
+    // A run of consecutive frames with the same label.
+    // Longer runs are split, so that the number of frames fits into 16 bits.
+    struct MLFSpan
+    {
+        msra::dbn::CLASSIDTYPE m_classId;
+        uint16_t m_numberOfFrames;
+    };
+
+    void InitializeChunkDescriptions(CorpusDescriptorPtr corpus, const ConfigHelper& config, const std::wstring& stateListPath, size_t dimension, const std::wstring& cachePath);
     void InitializeStream(const std::wstring& name, size_t dimension);
 
+    // Parses the MLF files, optionally writing all parsed utterances to the binary cache.
+    void ParseMlf(const std::vector<std::wstring>& mlfPaths, const std::wstring& stateListPath, size_t dimension, const std::wstring& cachePath, const StringToIdMap& stringRegistry);
+
+    // Reads the utterances from the binary cache. Returns false if the cache is missing, outdated, broken or does not match the configuration.
+    bool ReadCache(const std::vector<std::wstring>& mlfPaths, const std::wstring& stateListPath, size_t dimension, const std::wstring& cachePath, const StringToIdMap& stringRegistry);
+
+    void ResetLabels();
+
+    // Adds labels of an utterance if its key is part of the corpus.
+    void AddUtterance(const std::string& key, const std::vector<MLFSpan>& spans, size_t numberOfFrames, const StringToIdMap& stringRegistry);
+
     void GetSequenceById(size_t sequenceId, std::vector<SequenceDataPtr>& result);
 
+    // Gets the label of a frame by its frame index in the corpus, in O(log(number of spans)).
+    msra::dbn::CLASSIDTYPE GetLabelForFrame(size_t frameIndex) const;
+
     // Vector that maps KeyType.m_sequence into an utterance ID (or SIZE_MAX if the key is not assigned).
     // This assumes that IDs introduced by the corpus are dense (which they right now, depending on the number of invalid / filtered sequences).
     // TODO compare perf to map we had before.
@@ -54,12 +76,22 @@ private:
     // Number of sequences
     size_t m_numberOfSequences = 0;
 
-    // Array of all labels.
-    msra::dbn::biggrowablevector<msra::dbn::CLASSIDTYPE> m_classIds;
+    // Run-length encoded labels of all utterances.
+    msra::dbn::biggrowablevector<MLFSpan> m_spans;
+
+    // Index of the first frame of every s_spansPerBlock-th span in m_spans, used by GetLabelForFrame().
+    static const size_t s_spansPerBlock = 16;
+    msra::dbn::biggrowablevector<size_t> m_spanBlockFirstFrame;
 
-    // Index of utterances in the m_classIds.
+    // Index of the first span of each utterance in m_spans (with an additional entry for the end).
+    msra::dbn::biggrowablevector<size_t> m_utteranceSpanIndex;
+
+    // Index of the first frame of each utterance (with an additional entry for the end).
     msra::dbn::biggrowablevector<size_t> m_utteranceIndex;
 
+    // Number of classes seen in the labels.
+    size_t m_numberOfClasses = 0;
+
     // Type of the data this serializer provides.
     ElementType m_elementType;
 
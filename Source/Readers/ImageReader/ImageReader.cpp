@@ -76,7 +76,8 @@ ImageReader::ImageReader(const ConfigParameters& config)
     // It is noop if the matrix element type is already expected by the packer.
     transformations.push_back(Transformation{ std::make_shared<CastTransformer>(featureStream), featureName });
 
-    m_sequenceEnumerator = std::make_shared<TransformController>(transformations, randomizer);
+    bool multithreadedTransforms = config(L"multithreadedTransforms", true);
+    m_sequenceEnumerator = std::make_shared<TransformController>(transformations, randomizer, multithreadedTransforms);
 
     m_packer = std::make_shared<FramePacker>(
         m_sequenceEnumerator,
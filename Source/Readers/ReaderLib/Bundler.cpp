@@ -5,6 +5,7 @@
 #define _CRT_SECURE_NO_WARNINGS
 
 #include "Bundler.h"
+#include "ExceptionCapture.h"
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 #include <set>
@@ -29,6 +30,9 @@ Bundler::Bundler(
 {
     m_verbosity = readerConfig(L"verbosity", 0);
 
+    // When deserialization is multithreaded, chunks of different deserializers are loaded concurrently.
+    m_multithreadedChunkLoading = readerConfig(L"multiThreadedDeserialization", false);
+
     // Combines streams of underlying deserializers.
     for (auto d : deserializers)
     {
@@ -236,25 +240,32 @@ public:
 
         // Creating chunk mapping.
         m_parent->m_driver->GetSequencesForChunk(original->m_id, sequences);
-        ChunkPtr drivingChunk = m_parent->m_driver->GetChunk(original->m_id);
         m_sequenceToSequence.resize(deserializers.size() * sequences.size());
         m_innerChunks.resize(deserializers.size() * sequences.size());
-        for (size_t sequenceIndex = 0; sequenceIndex < sequences.size(); ++sequenceIndex)
+
+        // Each deserializer only touches its own slots of the mapping and its own weak chunk table,
+        // so chunks of different deserializers can be loaded in parallel.
+        auto mapDeserializer = [&](int deserializerIndex)
         {
-            if (chunk->m_invalid.find(sequenceIndex) != chunk->m_invalid.end())
+            if (deserializerIndex == 0)
             {
-                continue;
+                ChunkPtr drivingChunk = m_parent->m_driver->GetChunk(original->m_id);
+                for (size_t sequenceIndex = 0; sequenceIndex < sequences.size(); ++sequenceIndex)
+                {
+                    if (chunk->m_invalid.find(sequenceIndex) != chunk->m_invalid.end())
+                    {
+                        continue;
+                    }
+
+                    size_t currentIndex = sequenceIndex * deserializers.size();
+                    m_sequenceToSequence[currentIndex] = sequences[sequenceIndex].m_id;
+                    m_innerChunks[currentIndex] = drivingChunk;
+                }
+                return;
             }
 
-            size_t currentIndex = sequenceIndex * deserializers.size();
-            m_sequenceToSequence[currentIndex] = sequences[sequenceIndex].m_id;
-            m_innerChunks[currentIndex] = drivingChunk;
-        }
-
-        // Creating sequence mapping and requiring underlying chunks.
-        SequenceDescription s;
-        for (size_t deserializerIndex = 1; deserializerIndex < deserializers.size(); ++deserializerIndex)
-        {
+            // Creating sequence mapping and requiring underlying chunks.
+            SequenceDescription s;
             auto& chunkTable = m_parent->m_weakChunkTable[deserializerIndex];
             for (size_t sequenceIndex = 0; sequenceIndex < sequences.size(); ++sequenceIndex)
             {
@@ -276,6 +287,20 @@ public:
 
                 m_innerChunks[currentIndex] = secondaryChunk;
             }
+        };
+
+        if (m_parent->m_multithreadedChunkLoading && deserializers.size() > 1)
+        {
+            ExceptionCapture capture;
+#pragma omp parallel for schedule(dynamic)
+            for (int i = 0; i < (int)deserializers.size(); ++i)
+                capture.SafeRun(mapDeserializer, i);
+            capture.RethrowIfHappened();
+        }
+        else
+        {
+            for (int i = 0; i < (int)deserializers.size(); ++i)
+                mapDeserializer(i);
         }
     }
 
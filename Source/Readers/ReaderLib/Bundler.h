@@ -63,6 +63,9 @@ private:
     // Inner vector is the table of chunk id into weak pointer, the outer vector has an element per deserializer.
     std::vector<std::vector<std::weak_ptr<Chunk>>> m_weakChunkTable;
 
+    // If set, chunks of the underlying deserializers are loaded concurrently using OpenMP.
+    bool m_multithreadedChunkLoading;
+
     // General configuration
     int m_verbosity;
 };
@@ -12,6 +12,7 @@
 #endif
 
 #include <sstream>
+#include <chrono>
 #include "Basics.h"
 
 #define DATAREADER_EXPORTS // creating the exports here
@@ -23,13 +24,15 @@ namespace Microsoft { namespace MSR { namespace CNTK {
 
 template <class ElemType>
 ReaderShim<ElemType>::ReaderShim(ReaderFactory factory)
-    : m_factory(factory), m_deviceId(CPUDEVICE), m_dataTransferers(2, DataTransfererPtr()), m_currentDataTransferIndex(0), m_endOfEpoch(false)
+    : m_factory(factory), m_deviceId(CPUDEVICE), m_prefetchDepth(1), m_dataTransferers(2, DataTransfererPtr()), m_currentDataTransferIndex(0), m_endOfEpoch(false),
+    m_numMinibatchesConsumed(0), m_numReadyMinibatches(0), m_readerWaitSeconds(0), m_verbosity(0)
 {
 }
 
 template <class ElemType>
 ReaderShim<ElemType>::ReaderShim(ReaderPtr reader)
-    : m_deviceId(CPUDEVICE), m_dataTransferers(2, DataTransfererPtr()), m_currentDataTransferIndex(0), m_reader(reader), m_factory(nullptr), m_endOfEpoch(false)
+    : m_deviceId(CPUDEVICE), m_prefetchDepth(1), m_dataTransferers(2, DataTransfererPtr()), m_currentDataTransferIndex(0), m_reader(reader), m_factory(nullptr), m_endOfEpoch(false),
+    m_numMinibatchesConsumed(0), m_numReadyMinibatches(0), m_readerWaitSeconds(0), m_verbosity(0)
 {
 }
 
@@ -44,6 +47,16 @@ void ReaderShim<ElemType>::Init(const ConfigParameters& config)
     // otherwise deferring - synchronous execution during .get() call
     m_launchType = prefetch ? launch::async : launch::deferred;
 
+    // Number of minibatches read ahead of the network. Deeper prefetch absorbs latency spikes
+    // of the reader (i.e. slow chunk loads) at the cost of an additional set of input matrices per slot.
+    m_prefetchDepth = prefetch ? config(L"prefetchDepth", (size_t)1) : 1;
+    if (m_prefetchDepth == 0)
+    {
+        InvalidArgument("ReaderShim: prefetchDepth must be at least 1.");
+    }
+
+    m_verbosity = config(L"verbosity", 0);
+
     m_numParallelSequences = numberOfuttsPerMinibatchForAllEpochs[0];
 
     if (!m_reader)
@@ -84,16 +97,8 @@ void ReaderShim<ElemType>::StartDistributedMinibatchLoop(
 template <class ElemType>
 void ReaderShim<ElemType>::StartEpoch(const EpochConfiguration& config, const std::unordered_set<InputStreamDescription>& inputs)
 {
-    // For adaptive minibatch, make sure there are no outstanding reads.
-    if (m_prefetchTask.valid())
-    {
-        m_prefetchTask.wait();
-    }
-
-    // Let's check that there is no outstanding copies.
-    // Wait on all events if there are any pending copy operations in flight.
-    if (m_dataTransferers[m_currentDataTransferIndex])
-        m_dataTransferers[m_currentDataTransferIndex]->WaitForCopyCPUToGPU();
+    // For adaptive minibatch, make sure there are no outstanding reads and copies.
+    WaitForPrefetches();
 
     // Now we can be sure, no prefetch thread is running and there are no outstanding memcopies.
     // Let's check that requested devices are ok and see whether we need to change our data transferers.
@@ -109,42 +114,93 @@ void ReaderShim<ElemType>::StartEpoch(const EpochConfiguration& config, const st
         LogicError("Readers do not support running on several GPUs in the same process, at least two devices found '%d', '%d'", deviceId, secondDevice->GetDeviceId());
     }
 
-    if (m_deviceId != deviceId)
+    if (m_deviceId != deviceId || m_dataTransferers.size() != m_prefetchDepth + 1)
     {
         // Device changed. Let's change the data transferers.
         m_deviceId = deviceId;
         m_dataTransferers.clear();
-        // We need two in order to support two operations in flight.
-        m_dataTransferers.push_back(m_deviceId == CPUDEVICE ? nullptr : CreatePrefetchDataTransferer(m_deviceId));
-        m_dataTransferers.push_back(m_deviceId == CPUDEVICE ? nullptr : CreatePrefetchDataTransferer(m_deviceId));
+        // We need one per prefetch in flight plus the one the main thread waits on.
+        for (size_t i = 0; i < m_prefetchDepth + 1; ++i)
+            m_dataTransferers.push_back(m_deviceId == CPUDEVICE ? nullptr : CreatePrefetchDataTransferer(m_deviceId));
+        m_currentDataTransferIndex = 0;
     }
 
-    // Let's create the buffers for the prefetch thread.
+    // Let's create the buffers for the prefetch threads.
     std::map<std::wstring, int> inputDescriptions;
+    m_prefetchBuffers.resize(m_prefetchDepth);
+    for (auto& slot : m_prefetchBuffers)
+        slot.clear();
+
     for (const auto& i : inputs)
     {
         inputDescriptions[i.GetStreamName()] = i.GetDeviceId();
         // Creating buffers with the same properties the network expects.
-        m_prefetchBuffers[i.GetStreamName()] = StreamPrefetchBuffer
+        for (auto& slot : m_prefetchBuffers)
         {
-            std::make_shared<Matrix<ElemType>>(0, 0, i.GetDeviceId(), i.GetMatrixType(), i.GetMatrixFormat()),
-            std::make_shared<MBLayout>()
-        };
+            slot[i.GetStreamName()] = StreamPrefetchBuffer
+            {
+                std::make_shared<Matrix<ElemType>>(0, 0, i.GetDeviceId(), i.GetMatrixType(), i.GetMatrixFormat()),
+                std::make_shared<MBLayout>()
+            };
+        }
     }
 
     m_endOfEpoch = false;
+    m_numMinibatchesConsumed = 0;
+    m_numReadyMinibatches = 0;
+    m_readerWaitSeconds = 0;
     m_reader->StartEpoch(config, inputDescriptions);
     m_currentSamplePosition = m_reader->GetCurrentSamplePosition();
 
-    auto localCurrentDataTransferIndex = m_currentDataTransferIndex;
-    // Starting the prefetch task. There is always a single async read in flight.
-    // When the network requests a new minibatch, we wait for the current async to finish, swap the buffers
-    // and kick off the new prefetch.
-    m_prefetchTask = std::async(m_launchType,
-    [this, localCurrentDataTransferIndex]()
+    // Starting the prefetch tasks. There are always m_prefetchDepth reads in flight.
+    // When the network requests a new minibatch, we wait for the oldest one to finish, swap the buffers
+    // and kick off the new prefetch into the slot that has just been freed.
+    for (size_t slot = 0; slot < m_prefetchDepth; ++slot)
     {
-        return PrefetchMinibatch(localCurrentDataTransferIndex);
+        m_currentDataTransferIndex = (m_currentDataTransferIndex + 1) % m_dataTransferers.size();
+        StartPrefetch(slot, m_currentDataTransferIndex);
+    }
+}
+
+template <class ElemType>
+void ReaderShim<ElemType>::StartPrefetch(size_t slot, size_t dataTransferIndex)
+{
+    std::shared_future<PrefetchResult> previous;
+    if (!m_prefetchTasks.empty())
+        previous = m_prefetchTasks.back().m_result;
+
+    auto task = std::async(m_launchType,
+    [this, previous, slot, dataTransferIndex]()
+    {
+        // Reads have to happen in order, so wait for the previous prefetch
+        // and do not read past the end of the epoch.
+        if (previous.valid())
+        {
+            PrefetchResult result = previous.get();
+            if (result.m_isEndOfEpoch)
+                return PrefetchResult{ true, false, result.m_samplePosition };
+        }
+
+        return PrefetchMinibatch(slot, dataTransferIndex);
     });
+
+    m_prefetchTasks.push_back(PrefetchTask{ slot, dataTransferIndex, task.share() });
+}
+
+template <class ElemType>
+void ReaderShim<ElemType>::WaitForPrefetches()
+{
+    for (const auto& task : m_prefetchTasks)
+        task.m_result.wait();
+    m_prefetchTasks.clear();
+
+    // Let's check that there is no outstanding copies.
+    // Wait on all events if there are any pending copy operations in flight.
+    for (const auto& transferer : m_dataTransferers)
+    {
+        if (transferer)
+            transferer->WaitForCopyCPUToGPU();
+    }
 }
 
 string EnumerateInputs(const unordered_map<wstring, size_t>& nameToStreamId)
@@ -194,27 +250,47 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
         }
     }
 
-    // Make sure the prefetch has finished.
-    assert(m_prefetchTask.valid());
-    auto result = m_prefetchTask.get();
+    // Make sure the oldest prefetch has finished.
+    assert(!m_prefetchTasks.empty());
+    PrefetchTask task = m_prefetchTasks.front();
+    m_prefetchTasks.pop_front();
+
+    // Collect statistics: how many minibatches were already waiting and how long we block on the reader.
+    if (task.m_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        m_numReadyMinibatches++;
+        for (const auto& t : m_prefetchTasks)
+        {
+            if (t.m_result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                break;
+            m_numReadyMinibatches++;
+        }
+    }
+
+    auto waitStart = std::chrono::steady_clock::now();
+    auto result = task.m_result.get();
+    m_readerWaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
 
     // Ok, prefetch is done.
 
     // Let's update our sample position.
-    m_currentSamplePosition = m_reader->GetCurrentSamplePosition();
+    m_currentSamplePosition = result.m_samplePosition;
 
     m_endOfEpoch = result.m_isEndOfEpoch;
+    if (m_endOfEpoch)
+        ReportPrefetchStatistics();
+
     if (m_endOfEpoch && !result.m_isDataAvailable)
     {
         // No data and end of epoch, simply return.
         return false;
     }
 
-    // Remember current data transfer, async memcpy for it already started on the prefetch thread.
-    auto currentDataTransferIndex = m_currentDataTransferIndex;
+    m_numMinibatchesConsumed++;
 
     // Let's update the current data transferer.
-    m_currentDataTransferIndex = (m_currentDataTransferIndex + 1) % 2;
+    // The ring has one more transferer than there are prefetches in flight, so the next one is free.
+    m_currentDataTransferIndex = (m_currentDataTransferIndex + 1) % m_dataTransferers.size();
 
     // Record an event that prefetch can wait on to ensure that prior compute has finished.
     if (m_dataTransferers[m_currentDataTransferIndex])
@@ -222,9 +298,10 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
 
     // We have some data - let's swap the matrices.
     // We cannot simply change pointers because it seems they are remembered deeper in the network.
+    auto& prefetchBuffers = m_prefetchBuffers[task.m_slot];
     for (auto i = matrices.begin(); i != matrices.end(); ++i)
     {
-        std::swap(i->second.GetMatrix<ElemType>(), *m_prefetchBuffers[i->first].m_matrix);
+        std::swap(i->second.GetMatrix<ElemType>(), *prefetchBuffers[i->first].m_matrix);
 
         // Resetting layouts.
         i->second.pMBLayout->Init(1, 0);
@@ -236,7 +313,7 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
     // Let's now check the layouts and throw if the same layout is being assigned twice.
     for (auto i = matrices.begin(); i != matrices.end(); ++i)
     {
-        auto streamLayout = m_prefetchBuffers[i->first].m_mbLayout;
+        auto streamLayout = prefetchBuffers[i->first].m_mbLayout;
         auto& layout = i->second.pMBLayout;
         if (layout->GetNumCols() == 0) // just initialized, let's take the layout of the reader.
         {
@@ -257,35 +334,44 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
     // So pick up the first one.
     m_numParallelSequences = matrices.begin()->second.pMBLayout->GetNumParallelSequences();
 
-    // It is time to issue the next prefetch.
+    // It is time to issue the next prefetch into the slot we have just freed.
     if (!m_endOfEpoch)
-    {
-        // Starting the prefetch task. There is always a single async read in flight.
-        // When the network requests a new minibatch, we wait for the current async to finish, swap the buffers
-        // and kick off the new prefetch.
-        auto localCurrentDataTransferIndex = m_currentDataTransferIndex;
-        m_prefetchTask = std::async(m_launchType, [this, localCurrentDataTransferIndex]() { return PrefetchMinibatch(localCurrentDataTransferIndex); });
-    }
+        StartPrefetch(task.m_slot, m_currentDataTransferIndex);
 
     // Let's wait till the previous memcopy has finished.
-    if (m_dataTransferers[currentDataTransferIndex])
-        m_dataTransferers[currentDataTransferIndex]->WaitForCopyCPUToGPU();
+    if (m_dataTransferers[task.m_dataTransferIndex])
+        m_dataTransferers[task.m_dataTransferIndex]->WaitForCopyCPUToGPU();
 
     return result.m_isDataAvailable;
 }
 
 template <class ElemType>
-typename ReaderShim<ElemType>::PrefetchResult ReaderShim<ElemType>::PrefetchMinibatch(size_t currentDataTransferIndex)
+void ReaderShim<ElemType>::ReportPrefetchStatistics()
 {
+    if (m_prefetchDepth == 1 && m_verbosity == 0)
+        return;
+
+    fprintf(stderr, "ReaderShim::GetMinibatch: prefetch depth %d, %d minibatches, average ready queue occupancy %.2f, reader wait time %.3fs\n",
+            (int)m_prefetchDepth, (int)m_numMinibatchesConsumed,
+            m_numMinibatchesConsumed > 0 ? (double)m_numReadyMinibatches / m_numMinibatchesConsumed : 0.0,
+            m_readerWaitSeconds);
+}
+
+template <class ElemType>
+typename ReaderShim<ElemType>::PrefetchResult ReaderShim<ElemType>::PrefetchMinibatch(size_t slot, size_t currentDataTransferIndex)
+{
+    auto& prefetchBuffers = m_prefetchBuffers[slot];
+
     // Resetting layouts.
-    for (auto& mx : m_prefetchBuffers)
+    for (auto& mx : prefetchBuffers)
         mx.second.m_mbLayout = std::make_shared<MBLayout>();
 
     Minibatch minibatch = m_reader->ReadMinibatch();
+    size_t samplePosition = m_reader->GetCurrentSamplePosition();
 
     // If there is no data we can simply return.
     if (minibatch.m_data.empty())
-        return PrefetchResult{ minibatch.m_endOfEpoch, false };
+        return PrefetchResult{ minibatch.m_endOfEpoch, false, samplePosition };
 
     // Ok we have some data. Let's load it to GPU.
     // But before we need to make sure that corresponding compute has already finished from the last iteration.
@@ -294,7 +380,7 @@ typename ReaderShim<ElemType>::PrefetchResult ReaderShim<ElemType>::PrefetchMini
     if (m_dataTransferers[currentDataTransferIndex])
         m_dataTransferers[currentDataTransferIndex]->WaitForSyncPointOnAssignStreamAsync();
 
-    for (auto& mx : m_prefetchBuffers)
+    for (auto& mx : prefetchBuffers)
     {
         size_t streamId = m_nameToStreamId[mx.first];
         const auto& stream = minibatch.m_data[streamId];
@@ -306,9 +392,16 @@ typename ReaderShim<ElemType>::PrefetchResult ReaderShim<ElemType>::PrefetchMini
 
     // Let's record that we started the copy, so that the main thread can wait afterwards.
     if (m_dataTransferers[currentDataTransferIndex])
+    {
         m_dataTransferers[currentDataTransferIndex]->RecordCPUToGPUCopy();
 
-    return PrefetchResult{ minibatch.m_endOfEpoch, true };
+        // The packer only double-buffers its pinned memory, so with a deeper ring the copy has to
+        // finish before the following reads can overwrite the source of this one.
+        if (m_prefetchDepth > 1)
+            m_dataTransferers[currentDataTransferIndex]->WaitForCopyCPUToGPU();
+    }
+
+    return PrefetchResult{ minibatch.m_endOfEpoch, true, samplePosition };
 }
 
 
@@ -11,6 +11,7 @@
 #include <unordered_map>
 #include <string>
 #include <future>
+#include <deque>
 #include "DataReader.h"
 #include "Reader.h"
 
@@ -44,10 +45,11 @@ public:
         // Make sure there are no outstanding reads.
         // Future destructor does not wait as of 2013 so probably it is not in VS2013:
         // More info can be found here http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2013/n3679.html.
-        if (m_prefetchTask.valid())
+        for (const auto& task : m_prefetchTasks)
         {
             // If there are some, give them time to finish.
-            m_prefetchTask.wait_for(std::chrono::seconds(5));
+            if (task.m_result.valid())
+                task.m_result.wait_for(std::chrono::seconds(5));
         }
 
         delete this;
@@ -108,11 +110,36 @@ private:
     {
         bool m_isEndOfEpoch;
         bool m_isDataAvailable;
+        // Sample position of the reader right after this minibatch has been read.
+        size_t m_samplePosition;
     };
 
-    PrefetchResult PrefetchMinibatch(size_t currentDataTransferIndex);
+    // A prefetch in flight: the ring slot it fills, the data transfer it uses and its future.
+    struct PrefetchTask
+    {
+        size_t m_slot;
+        size_t m_dataTransferIndex;
+        std::shared_future<PrefetchResult> m_result;
+    };
+
+    PrefetchResult PrefetchMinibatch(size_t slot, size_t currentDataTransferIndex);
+
+    // Queues the prefetch of the next minibatch into the given slot.
+    // Reads are chained, so that the reader is only ever accessed by one prefetch at a time.
+    void StartPrefetch(size_t slot, size_t dataTransferIndex);
+
+    // Waits for all outstanding prefetches and copies.
+    void WaitForPrefetches();
+
+    // Prints queue occupancy and reader wait time of the finished epoch.
+    void ReportPrefetchStatistics();
+
+    // Outstanding prefetches in the order the minibatches will be consumed.
+    std::deque<PrefetchTask> m_prefetchTasks;
+
+    // Number of minibatches that are prefetched ahead of the network.
+    size_t m_prefetchDepth;
 
-    std::future<PrefetchResult> m_prefetchTask;
     ReaderPtr m_reader;
     ReaderFactory m_factory;
     bool m_endOfEpoch;
@@ -130,20 +157,25 @@ private:
         MBLayoutPtr m_mbLayout;
     };
 
-    // Intermediate buffer where the prefetch thread puts its data to.
-    // When the main thread enters GetMinibatch it swaps the matrices from this buffer,
-    // triggers the next prefetch and waits if memCpy is still in progress.
-    std::unordered_map<std::wstring, StreamPrefetchBuffer> m_prefetchBuffers;
+    // Intermediate buffers where the prefetch threads put their data to, one per slot of the prefetch ring.
+    // When the main thread enters GetMinibatch it swaps the matrices from the oldest slot,
+    // triggers the next prefetch into this slot and waits if memCpy is still in progress.
+    std::vector<std::unordered_map<std::wstring, StreamPrefetchBuffer>> m_prefetchBuffers;
 
-    // Alternating data transfer operations. In the current version these are only two - 
-    // currently waiting on the main thread and the one that can be started by the prefetch thread 
-    // in the meantime.
+    // Alternating data transfer operations. There is one per prefetch in flight plus the one
+    // currently waited on by the main thread.
     std::vector<DataTransfererPtr> m_dataTransferers;
 
-    // Current data transfer. Flips 0 and 1.
-    // Can be changed only from the main thread with no ongoing prefetch.
+    // Data transfer used by the most recently started prefetch. Cycles through m_dataTransferers.
+    // Can be changed only from the main thread.
     size_t m_currentDataTransferIndex; 
 
+    // Per-epoch prefetch statistics, reported at the end of the epoch.
+    size_t m_numMinibatchesConsumed;
+    size_t m_numReadyMinibatches;   // sum of the number of ready prefetches observed by GetMinibatch
+    double m_readerWaitSeconds;     // time the main thread was blocked waiting for the reader
+    int m_verbosity;
+
     // Device id.
     int m_deviceId;
 
@@ -11,14 +11,18 @@ namespace Microsoft { namespace MSR { namespace CNTK {
 
 // This packer generates minibatches containing full sequences packed for 
 // efficient (concurrent) consumption on a GPU.
+// If 'sortParallelSequencesByLength' is set, the parallel sequences of the layout are ordered by decreasing length,
+// so that recurrent loops can skip the ones that have ended (see MBLayout::GetNumActiveParallelSequences()).
 class SequencePacker : public PackerBase
 {
 public:
     SequencePacker(
         SequenceEnumeratorPtr sequenceEnumerator,
         const std::vector<StreamDescriptionPtr>& streams,
-        size_t numberOfBuffers = 2) :
-        PackerBase(sequenceEnumerator, streams, numberOfBuffers)
+        size_t numberOfBuffers = 2,
+        bool sortParallelSequencesByLength = false) :
+        PackerBase(sequenceEnumerator, streams, numberOfBuffers),
+        m_sortParallelSequencesByLength(sortParallelSequencesByLength)
     {}
 
     virtual Minibatch ReadMinibatch() override;
@@ -34,6 +38,8 @@ protected:
 
     // Helper function to check the sample shape of input samples.
     void CheckSampleShape(const std::vector<SequenceDataPtr>& minibatch, StreamDescriptionPtr outputStream);
+
+    bool m_sortParallelSequencesByLength;
 };
 
 typedef std::shared_ptr<SequencePacker> SequencePackerPtr;
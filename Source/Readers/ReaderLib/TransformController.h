@@ -6,6 +6,7 @@
 #pragma once
 
 #include <set>
+#include <algorithm>
 
 #include "Transformer.h"
 #include "SequenceEnumerator.h"
@@ -26,8 +27,8 @@ struct Transformation
 class TransformController : public SequenceEnumerator
 {
 public:
-    TransformController(const std::vector<Transformation>& transformations, SequenceEnumeratorPtr sequenceProvider)
-        : m_sequenceProvider(sequenceProvider)
+    TransformController(const std::vector<Transformation>& transformations, SequenceEnumeratorPtr sequenceProvider, bool multithreadedTransforms = true)
+        : m_sequenceProvider(sequenceProvider), m_multithreadedTransforms(multithreadedTransforms)
     {
         // Applying transformations to stream descriptions,
         // i.e. a transformation can change a stream from dense to sparse.
@@ -37,6 +38,11 @@ public:
             size_t streamId = GetStreamId(t.m_streamName, transformedStreams);
             m_transformations.push_back(std::make_pair(t, streamId));
             transformedStreams[streamId] = std::make_shared<StreamDescription>(t.m_transformer->Transform(*transformedStreams[streamId]));
+
+            if (std::find(m_transformedStreamIds.begin(), m_transformedStreamIds.end(), streamId) == m_transformedStreamIds.end())
+            {
+                m_transformedStreamIds.push_back(streamId);
+            }
         }
         m_outputStreams = transformedStreams;
     }
@@ -73,29 +79,47 @@ public:
 
     // Gets next sequences up to a maximum count of samples,
     // applying transformers to particular streams.
+    // Each (sequence, stream) pair is an independent work item: transformations of one stream
+    // are applied in their declared order, while different sequences and streams are processed
+    // concurrently. Results are written in place, so the output order does not depend on scheduling.
     virtual Sequences GetNextSequences(size_t sampleCount) override
     {
         assert(m_sequenceProvider != nullptr);
         Sequences sequences = m_sequenceProvider->GetNextSequences(sampleCount);
-        if (sequences.m_data.empty())
+        if (sequences.m_data.empty() || m_transformedStreamIds.empty())
         {
             return sequences;
         }
 
-        ExceptionCapture capture;
-#pragma omp parallel for schedule(dynamic)
-        for (int j = 0; j < sequences.m_data.front().size(); ++j)
+        const int numberOfStreams = (int)m_transformedStreamIds.size();
+        const int numberOfItems = (int)sequences.m_data.front().size() * numberOfStreams;
+        auto process = [this, &sequences, numberOfStreams](int item)
         {
-            capture.SafeRun([this, &sequences](int sequenceId)
+            int sequenceId = item / numberOfStreams;
+            size_t streamId = m_transformedStreamIds[item % numberOfStreams];
+            for (auto& t : m_transformations)
             {
-                for (auto& t : m_transformations)
+                if (t.second == streamId)
                 {
-                    sequences.m_data[t.second][sequenceId] = t.first.m_transformer->Transform(sequences.m_data[t.second][sequenceId]);
+                    sequences.m_data[streamId][sequenceId] = t.first.m_transformer->Transform(sequences.m_data[streamId][sequenceId]);
                 }
-            }, j);
+            }
+        };
+
+        if (m_multithreadedTransforms)
+        {
+            ExceptionCapture capture;
+#pragma omp parallel for schedule(dynamic)
+            for (int j = 0; j < numberOfItems; ++j)
+                capture.SafeRun(process, j);
+            capture.RethrowIfHappened();
+        }
+        else
+        {
+            for (int j = 0; j < numberOfItems; ++j)
+                process(j);
         }
 
-        capture.RethrowIfHappened();
         return sequences;
     }
 
@@ -122,6 +146,12 @@ private:
     SequenceEnumeratorPtr m_sequenceProvider;
     std::vector<StreamDescriptionPtr> m_outputStreams;
     std::vector<std::pair<Transformation, size_t>> m_transformations;
+
+    // Ids of the streams that have at least one transformation, in the order of first appearance.
+    std::vector<size_t> m_transformedStreamIds;
+
+    // Whether transformations are applied on the OpenMP pool.
+    bool m_multithreadedTransforms;
 };
 
 }}}
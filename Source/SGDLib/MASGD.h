@@ -398,6 +398,7 @@ namespace Microsoft { namespace MSR { namespace CNTK {
                 secondsOnCommunication += (float)commTimer.ElapsedSeconds();
                 // 2.1.5. set value 
                 pNode->Value().SetValue(mat.GetNumRows(), mat.GetNumCols(), mat.GetDeviceId(), px.get());
+                pNode->BumpEvalTimeStamp();
                 // 2.1.6. clean up 
                 //delete[]px;
             }
@@ -628,6 +628,7 @@ void SGD<ElemType>::TrainOrAdaptModel(int startEpoch, ComputationNetworkPtr net,
                     // roll back
                     auto bestModelPath = GetModelNameForEpoch(i - m_learnRateAdjustInterval);
                     LOGPRINTF(stderr, "Loading (rolling back to) previous model with best training-criterion value: %ls.\n", bestModelPath.c_str());
+                    WaitForCheckpoint();
                     net->RereadPersistableParameters<ElemType>(bestModelPath);
                     LoadCheckPointInfo(i - m_learnRateAdjustInterval,
                                        /*out*/ totalTrainingSamplesSeen,
@@ -723,16 +724,16 @@ void SGD<ElemType>::TrainOrAdaptModel(int startEpoch, ComputationNetworkPtr net,
 
                 // Set i back to the loaded model
                 i -= m_learnRateAdjustInterval;
+                m_lastCheckpointEpoch = -1; // next checkpoint starts a new delta chain
                 LOGPRINTF(stderr, "SGD: revoke back to and update checkpoint file for epoch %d\n", i+1); // report 1 based epoch number
                 SaveCheckPointInfo(i, totalTrainingSamplesSeen, learnRatePerSample, smoothedGradients, smoothedCounts, prevCriterion, chosenMinibatchSize);
             }
             else
             {
-                SaveCheckPointInfo(i, totalTrainingSamplesSeen, learnRatePerSample, smoothedGradients, smoothedCounts, prevCriterion, chosenMinibatchSize);
                 auto modelName = GetModelNameForEpoch(i);
                 if (m_traceLevel > 0)
                     LOGPRINTF(stderr, "SGD: Saving checkpoint model '%ls'\n", modelName.c_str());
-                net->Save(modelName);
+                SaveCheckPoint(net, modelName, i, totalTrainingSamplesSeen, learnRatePerSample, smoothedGradients, smoothedCounts, prevCriterion, chosenMinibatchSize);
                 if (!m_keepCheckPointFiles)
                 {
                     // delete previous checkpoint file to save space
@@ -740,16 +741,16 @@ void SGD<ElemType>::TrainOrAdaptModel(int startEpoch, ComputationNetworkPtr net,
                     {
                         if (epochsSinceLastLearnRateAdjust != 1)
                         {
-                            _wunlink(GetCheckPointFileNameForEpoch(i - 1).c_str());
+                            DeleteCheckPointFile(i - 1);
                         }
                         if (epochsSinceLastLearnRateAdjust == m_learnRateAdjustInterval)
                         {
-                            _wunlink(GetCheckPointFileNameForEpoch(i - m_learnRateAdjustInterval).c_str());
+                            DeleteCheckPointFile(i - m_learnRateAdjustInterval);
                         }
                     }
                     else
                     {
-                        _wunlink(GetCheckPointFileNameForEpoch(i - 1).c_str());
+                        DeleteCheckPointFile(i - 1);
                     }
                 }
             }
@@ -761,6 +762,8 @@ void SGD<ElemType>::TrainOrAdaptModel(int startEpoch, ComputationNetworkPtr net,
                 // Set i back to the loaded model
                 i -= m_learnRateAdjustInterval;
             }
+            else
+                NoteCheckpointWritten(); // (the main node is writing it; see WaitForCheckpoint())
         }
 
         if (learnRatePerSample < 1e-12)
@@ -771,6 +774,8 @@ void SGD<ElemType>::TrainOrAdaptModel(int startEpoch, ComputationNetworkPtr net,
     }
     // --- END OF MAIN EPOCH LOOP
 
+    WaitForCheckpoint();
+
     // Synchronize all ranks before proceeding to ensure that
     // rank 0 has finished writing the model file
     if (m_mpi != nullptr)
@@ -852,6 +857,13 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
     // resetting this, so profiling is performed for one epoch only
     m_numMBsToCUDAProfile = 0;
 
+    // per-node profile of this epoch, reported at its end (on the main node only)
+    NodeProfilerPtr nodeProfiler;
+    if (m_profileNodes && ((m_mpi == nullptr) || m_mpi->IsMainNode()))
+        nodeProfiler = make_shared<NodeProfiler>();
+    net->Environment().nodeProfiler = nodeProfiler;
+    auto removeNodeProfiler = MakeScopeExit([&net]() { net->Environment().nodeProfiler = nullptr; });
+
     bool useDistributedMBReading = useParallelTrain &&
                                    m_enableDistributedMBReading &&
                                    trainSetDataReader->SupportsDistributedMBRead();
@@ -1328,6 +1340,15 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
 
     // --- END MAIN MINIBATCH LOOP
 
+    if (nodeProfiler)
+    {
+        net->Environment().nodeProfiler = nullptr;
+        nodeProfiler->PrintTable(stderr, msra::strfun::strprintf("Node profile of epoch %d", (int)epochNumber + 1));
+        wstring traceFileName = GetModelNameForEpoch(epochNumber) + L".trace.json";
+        nodeProfiler->WriteChromeTrace(traceFileName);
+        fprintf(stderr, "Node profile trace written to %ls\n", traceFileName.c_str());
+    }
+
     if (useModelAggregation )
     {
         m_pMASGDHelper->OnEpochEnd(learnableNodes, smoothedGradients, nSamplesSinceLastModelSync);
@@ -1515,6 +1536,7 @@ double SGD<ElemType>::SearchForBestLearnRate(ComputationNetworkPtr net,
     }
 
     int baseModelEpoch = epochNumber - 1;
+    WaitForCheckpoint();
     net->RereadPersistableParameters<ElemType>(GetModelNameForEpoch(baseModelEpoch));
 
     double learnRate = learnRatePerSample;
@@ -1885,6 +1907,7 @@ void SGD<ElemType>::TrainOneMiniEpochAndReloadModel(ComputationNetworkPtr net,
     int baseModelEpoch = epochNumber - 1;
     let path = GetModelNameForEpoch(baseModelEpoch);
     //fprintf(stderr, "Reverting parameters back to %ls\n", path.c_str());
+    WaitForCheckpoint();
     net->RereadPersistableParameters<ElemType>(path);
 
     double dummyLearnRate;
@@ -1975,6 +1998,13 @@ void SGD<ElemType>::InitModelAggregationHandler(int traceLevel, DEVICEID_TYPE de
                                                                  m_modelAggregationBlockSize);
 #endif 
     }
+
+    // the model-aggregation state is saved with the checkpoint, and there is no snapshot of it
+    if (m_pMASGDHelper && m_asyncCheckpointing)
+    {
+        LOGPRINTF(stderr, "asyncCheckpointing is not supported with model averaging or block momentum; checkpoints will be written synchronously.\n");
+        m_asyncCheckpointing = false;
+    }
 }
 
 // public:
@@ -2104,7 +2134,8 @@ void SGD<ElemType>::SaveCheckPointInfo(const size_t epoch, const size_t totalSam
                                        const std::list<Matrix<ElemType>>& smoothedGradients,
                                        const std::vector<double>& smoothedCounts,
                                        const double prevCriterion,
-                                       const size_t minibatchSize)
+                                       const size_t minibatchSize,
+                                       bool flushToDisk)
 {
     // In case of parallel training only the main node should we saving the checkpoint to prevent
     // the parallel training nodes from colliding to write the same file
@@ -2116,7 +2147,7 @@ void SGD<ElemType>::SaveCheckPointInfo(const size_t epoch, const size_t totalSam
         wstring tempFileName = checkPointFileName + L".tmp";
 
         {
-            File fstream(tempFileName, FileOptions::fileOptionsBinary | FileOptions::fileOptionsWrite);
+            File fstream(tempFileName, FileOptions::fileOptionsBinary | FileOptions::fileOptionsWrite | FileOptions::fileOptionsSequential);
             fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BVersion"); 
             fstream << (size_t)CURRENT_CNTK_CHECKPOINT_VERSION; 
             fstream.PutMarker(FileMarker::fileMarkerEndSection, L"EVersion");
@@ -2151,7 +2182,10 @@ void SGD<ElemType>::SaveCheckPointInfo(const size_t epoch, const size_t totalSam
             if (m_pMASGDHelper)
                 m_pMASGDHelper->SaveToCheckPoint(fstream);
             // Ensuring that data is written
-            fstream.Flush();
+            if (flushToDisk)
+                fstream.FlushToDisk();
+            else
+                fstream.Flush();
         }
 
         _wunlink(checkPointFileName.c_str());
@@ -2159,6 +2193,144 @@ void SGD<ElemType>::SaveCheckPointInfo(const size_t epoch, const size_t totalSam
     }
 }
 
+// save model and checkpoint info for an epoch, with the model as a delta against the previous checkpoint if so configured
+// Deltas are written synchronously, since finding the changed columns needs the values in CPU memory anyway, and the
+// result is small. Every m_fullCheckpointInterval-th checkpoint, and the final model, are written in full (possibly in
+// the background); they become the base of the next chain.
+// The checkpoint info always holds the smoothed gradients in full: with momentum, they change in every column with
+// every minibatch, so a delta would not be smaller. Hence a checkpoint info file never depends on an older one.
+template <class ElemType>
+void SGD<ElemType>::SaveCheckPoint(const ComputationNetworkPtr& net, const wstring& modelName,
+                                   const size_t epoch, const size_t totalSamplesSeen,
+                                   const double learnRatePerSample,
+                                   const std::list<Matrix<ElemType>>& smoothedGradients,
+                                   const std::vector<double>& smoothedCounts,
+                                   const double prevCriterion,
+                                   const size_t minibatchSize)
+{
+    bool writeDelta = m_deltaCheckpoints && m_lastCheckpointEpoch >= 0 &&
+                      m_numDeltaCheckpoints + 1 < m_fullCheckpointInterval &&
+                      epoch + 1 < m_maxEpochs; // the final model must be self-contained
+
+    if (writeDelta)
+    {
+        // a delta is only of use once its base model file is complete
+        CompletePendingCheckpoint();
+        SaveCheckPointInfo(epoch, totalSamplesSeen, learnRatePerSample, smoothedGradients, smoothedCounts, prevCriterion, minibatchSize);
+        net->SaveDelta<ElemType>(modelName, GetModelNameForEpoch(m_lastCheckpointEpoch), m_deltaColumnHashes);
+        m_numDeltaCheckpoints++;
+    }
+    else
+    {
+        if (m_asyncCheckpointing)
+            SaveCheckPointAsync(net, modelName, epoch, totalSamplesSeen, learnRatePerSample, smoothedGradients, smoothedCounts, prevCriterion, minibatchSize);
+        else
+        {
+            SaveCheckPointInfo(epoch, totalSamplesSeen, learnRatePerSample, smoothedGradients, smoothedCounts, prevCriterion, minibatchSize);
+            net->Save(modelName);
+        }
+        if (m_deltaCheckpoints)
+            net->SetDeltaReference<ElemType>(m_deltaColumnHashes);
+        m_numDeltaCheckpoints = 0;
+    }
+    m_lastCheckpointEpoch = (int)epoch;
+    NoteCheckpointWritten();
+}
+
+// save model and checkpoint info like above, but in a background task
+// The training loop only waits for copying the model and the smoothed gradients into CPU memory. The files are
+// written with the same temp-file-and-rename scheme, and are flushed to disk before they get their final names.
+// A still pending previous write is completed first, so that at most one write is in flight.
+template <class ElemType>
+void SGD<ElemType>::SaveCheckPointAsync(const ComputationNetworkPtr& net, const wstring& modelName,
+                                        const size_t epoch, const size_t totalSamplesSeen,
+                                        const double learnRatePerSample,
+                                        const std::list<Matrix<ElemType>>& smoothedGradients,
+                                        const std::vector<double>& smoothedCounts,
+                                        const double prevCriterion,
+                                        const size_t minibatchSize)
+{
+    CompletePendingCheckpoint();
+
+    // snapshot
+    auto netSnapshot = net->CloneToHost();
+    auto smoothedGradientsSnapshot = make_shared<std::list<Matrix<ElemType>>>();
+    for (const auto& smoothedGradient : smoothedGradients)
+    {
+        smoothedGradientsSnapshot->emplace_back(CPUDEVICE);
+        if (smoothedGradient.GetMatrixType() == MatrixType::DENSE)
+            smoothedGradientsSnapshot->back().AssignValuesOf(smoothedGradient);
+        else
+        {
+            smoothedGradientsSnapshot->back().SetValue(smoothedGradient);
+            smoothedGradientsSnapshot->back().TransferToDeviceIfNotThere(CPUDEVICE, /*isBeingMoved=*/true);
+        }
+    }
+
+    m_pendingCheckpoint = std::async(std::launch::async, [=]()
+    {
+        SaveCheckPointInfo(epoch, totalSamplesSeen, learnRatePerSample, *smoothedGradientsSnapshot, smoothedCounts, prevCriterion, minibatchSize, /*flushToDisk=*/true);
+        netSnapshot->Save(modelName, FileOptions::fileOptionsBinary, /*flushToDisk=*/true);
+    });
+}
+
+// record that the checkpoint of an epoch has been started, on every rank by the same rule
+// With asynchronous checkpointing, the next WaitForCheckpoint() must then wait for it, and meet the other ranks in a barrier.
+// This does not depend on whether the main node wrote a delta synchronously or a full checkpoint in the background, which
+// the other ranks do not know; otherwise the ranks would disagree about entering the barrier.
+template <class ElemType>
+void SGD<ElemType>::NoteCheckpointWritten()
+{
+    if (m_asyncCheckpointing)
+        m_checkpointPending = true;
+}
+
+// complete a background checkpoint write before model or checkpoint files are read again
+// This must be called by all ranks, since the other ranks must not read the files before the main node has written them.
+template <class ElemType>
+void SGD<ElemType>::WaitForCheckpoint()
+{
+    if (!m_checkpointPending)
+        return;
+    m_checkpointPending = false;
+    CompletePendingCheckpoint();
+    if (m_mpi != nullptr)
+        m_mpi->WaitAll();
+}
+
+// finish the background write, then delete the checkpoint files it supersedes (main node only)
+template <class ElemType>
+void SGD<ElemType>::CompletePendingCheckpoint()
+{
+    if (!m_pendingCheckpoint.valid())
+        return;
+    try
+    {
+        m_pendingCheckpoint.get(); // (rethrows if the write failed)
+    }
+    catch (...)
+    {
+        m_checkPointFilesToDelete.clear(); // the write failed, so the older files are still needed
+        throw;
+    }
+    for (const auto& fileName : m_checkPointFilesToDelete)
+        _wunlink(fileName.c_str());
+    m_checkPointFilesToDelete.clear();
+}
+
+// delete the checkpoint file of an epoch once a newer checkpoint has superseded it
+// If the newer checkpoint is still being written in the background, the file is only deleted after that write
+// has completed and the new file got its final name, so that a complete checkpoint exists at any time.
+template <class ElemType>
+void SGD<ElemType>::DeleteCheckPointFile(const int epoch)
+{
+    wstring fileName = GetCheckPointFileNameForEpoch(epoch);
+    if (m_pendingCheckpoint.valid())
+        m_checkPointFilesToDelete.push_back(fileName);
+    else
+        _wunlink(fileName.c_str());
+}
+
 template <class ElemType>
 bool SGD<ElemType>::TryLoadCheckPointInfo(const size_t epochNumber,
                                           /*out*/ size_t& totalSamplesSeen,
@@ -2200,7 +2372,7 @@ void SGD<ElemType>::LoadCheckPointInfo(const size_t epochNumber,
     let checkPointFileName = GetCheckPointFileNameForEpoch(int(epochNumber));
     //fprintf(stderr, "Loading checkpoint info from %ls\n", checkPointFileName.c_str());
     File fstream(checkPointFileName,
-                 FileOptions::fileOptionsBinary | FileOptions::fileOptionsRead);
+                 FileOptions::fileOptionsBinary | FileOptions::fileOptionsRead | FileOptions::fileOptionsSequential);
 
     // version info 
     size_t ckpVersion = CNTK_CHECKPOINT_VERSION_1; // if no version info is found -> version 1
@@ -2534,6 +2706,7 @@ SGDParams::SGDParams(const ConfigRecordType& configSGD, size_t sizeofElemType)
     m_numMBsToShowResult = configSGD(L"numMBsToShowResult", (size_t)10);
     m_firstMBsToShowResult = configSGD(L"firstMBsToShowResult", (size_t)0);
     m_numMBsToCUDAProfile = configSGD(L"numMBsToCUDAProfile", (size_t)0);
+    m_profileNodes = configSGD(L"profileNodes", false);
 
     m_gradientClippingWithTruncation = configSGD(L"gradientClippingWithTruncation", true);
     m_clippingThresholdPerSample = configSGD(L"clippingThresholdPerSample", numeric_limits<double>::infinity());
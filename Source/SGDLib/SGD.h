@@ -17,7 +17,9 @@
 #include "Config.h"
 #include <chrono>
 #include <random>
+#include <future>
 #include "Profiler.h"
+#include "NodeProfiler.h"
 #include "MASGD.h"
 
 using namespace std; // ugh! TODO: get rid of this from .h files!!!
@@ -240,6 +242,7 @@ protected:
     size_t m_numMBsToShowResult = 0;
     size_t m_firstMBsToShowResult = 0;
     int m_numMBsToCUDAProfile;
+    bool m_profileNodes; // time each node and write a table and a Chrome trace per epoch (see NodeProfiler.h)
 
     bool m_doGradientCheck;
     double m_gradientCheckSigDigit;
@@ -323,6 +326,12 @@ public:
           // TODO: The next few do not belong into SGD any more than the network or reader we operate on. Either move network and reader in here, or move these out.
           m_modelPath((const wstring&) configSGD(L"modelPath")),
           m_keepCheckPointFiles(configSGD(L"keepCheckPointFiles", false)),
+          m_asyncCheckpointing(configSGD(L"asyncCheckpointing", false)),
+          m_checkpointPending(false),
+          m_deltaCheckpoints(configSGD(L"deltaCheckpoints", false)),
+          m_fullCheckpointInterval(configSGD(L"fullCheckpointInterval", (size_t)10)),
+          m_lastCheckpointEpoch(-1),
+          m_numDeltaCheckpoints(0),
           m_trainCriterionNodeName((const wstring&) configSGD(L"trainCriterionNodeName", L"")),
           m_evalCriterionNodeName ((const wstring&) configSGD(L"evalCriterionNodeName", L"")),
           m_traceNodeNamesReal    (configSGD(L"traceNodeNamesReal",     ConfigRecordType::Array(stringargvector()))),
@@ -343,6 +352,13 @@ public:
     {
     }
 
+    ~SGD()
+    {
+        // training normally waits for the last checkpoint; this only happens when it was aborted
+        if (m_pendingCheckpoint.valid())
+            m_pendingCheckpoint.wait();
+    }
+
     void InitMPI(const MPIWrapperPtr& mpi)
     {
         m_mpi = mpi;
@@ -501,7 +517,26 @@ protected:
                             const std::list<Matrix<ElemType>>& smoothedGradients,
                             const std::vector<double>& smoothedCounts,
                             const double prevCriterion,
-                            const size_t minibatchSize);
+                            const size_t minibatchSize,
+                            bool flushToDisk = false);
+    void SaveCheckPoint(const ComputationNetworkPtr& net, const std::wstring& modelName,
+                        const size_t epoch, const size_t totalSamplesSeen,
+                        const double learnRatePerSample,
+                        const std::list<Matrix<ElemType>>& smoothedGradients,
+                        const std::vector<double>& smoothedCounts,
+                        const double prevCriterion,
+                        const size_t minibatchSize);
+    void SaveCheckPointAsync(const ComputationNetworkPtr& net, const std::wstring& modelName,
+                             const size_t epoch, const size_t totalSamplesSeen,
+                             const double learnRatePerSample,
+                             const std::list<Matrix<ElemType>>& smoothedGradients,
+                             const std::vector<double>& smoothedCounts,
+                             const double prevCriterion,
+                             const size_t minibatchSize);
+    void NoteCheckpointWritten();
+    void WaitForCheckpoint();
+    void CompletePendingCheckpoint();
+    void DeleteCheckPointFile(const int epoch);
 
     bool TryLoadCheckPointInfo(const size_t epochNumber,
                                /*out*/ size_t& totalSamplesSeen,
@@ -541,6 +576,21 @@ protected:
     std::wstring m_modelPath;
     bool m_keepCheckPointFiles;
 
+    // asynchronous checkpointing: the model and checkpoint info are snapshotted into CPU memory and written
+    // by a background task while training continues; at most one such write is in flight
+    bool m_asyncCheckpointing;
+    bool m_checkpointPending;             // a background write was started and not yet waited for (tracked on all ranks)
+    std::future<void> m_pendingCheckpoint; // the background write (main node only)
+    std::vector<std::wstring> m_checkPointFilesToDelete; // superseded by the pending write, deleted when it has completed
+
+    // delta checkpointing: between full checkpoints, only the parameter columns that changed since the previous
+    // checkpoint are written to the model file, relative to that checkpoint (main node only)
+    bool m_deltaCheckpoints;
+    size_t m_fullCheckpointInterval;  // every this many checkpoints, a full one is written, which bounds the chain length
+    int m_lastCheckpointEpoch;        // base of the next delta; -1 if the next checkpoint must be a full one
+    size_t m_numDeltaCheckpoints;     // since the last full checkpoint
+    std::map<std::wstring, std::vector<uint64_t>> m_deltaColumnHashes; // of the parameter values as last written
+
     std::wstring m_trainCriterionNodeName;
     std::wstring m_evalCriterionNodeName;
 
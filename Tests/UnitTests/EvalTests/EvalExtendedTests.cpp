@@ -7,6 +7,7 @@
 #include "EvalTestHelper.h"
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
+#include <thread>
 
 using namespace Microsoft::MSR::CNTK;
 
@@ -219,6 +220,283 @@ BOOST_AUTO_TEST_CASE(EvalDenseTimesTest)
     eval->Destroy();
 }
 
+BOOST_AUTO_TEST_CASE(EvalValueRefsTest)
+{
+    // Two outputs, one of which is an input to the other.
+    std::string modelDefinition =
+        "deviceId = -1 \n"
+        "precision = \"float\" \n"
+        "traceLevel = 1 \n"
+        "run=NDLNetworkBuilder \n"
+        "NDLNetworkBuilder=[ \n"
+        "i1 = Input(2) \n"
+        "h1 = Times(Constant(2, rows=3, cols=2), i1, tag=\"output\") \n"
+        "o1 = Plus(h1, Constant(1, rows=3, cols=1), tag=\"output\") \n"
+        "FeatureNodes = (i1) \n"
+        "] \n";
+
+    // ValueRefs outputs are computed right into the caller's buffer only where that is safe; the results must be
+    // the same with and without matrix sharing.
+    for (auto shareNodeValueMatrices : { true, false })
+    {
+        IEvaluateModelExtended<float> *eval;
+        GetEvalExtendedF(&eval);
+        eval->Init(std::string("shareNodeValueMatrices=") + (shareNodeValueMatrices ? "true" : "false"));
+        eval->CreateNetwork(modelDefinition);
+        eval->StartForwardEvaluation({ L"h1", L"o1" });
+        VariableSchema outputLayouts = eval->GetOutputSchema();
+        BOOST_REQUIRE_EQUAL(outputLayouts.size(), 2);
+
+        // Two samples per call, each call with buffers of its own.
+        std::vector<std::vector<float>> inputs{ { 1, 2, 3, 4 }, { 0, 1, -1, -1 } };
+        std::vector<std::vector<float>> expectedH{ { 6, 6, 6, 14, 14, 14 }, { 2, 2, 2, -4, -4, -4 } };
+        std::vector<std::vector<float>> expectedO{ { 7, 7, 7, 15, 15, 15 }, { 3, 3, 3, -3, -3, -3 } };
+        std::vector<std::vector<std::vector<float>>> outputs(inputs.size(), std::vector<std::vector<float>>(2, std::vector<float>(6)));
+        for (size_t call = 0; call < inputs.size(); ++call)
+        {
+            ValueRefs<float> inputRefs(1);
+            inputRefs[0].m_buffer.InitFrom(inputs[call]);
+            ValueRefs<float> outputRefs(2);
+            for (size_t k = 0; k < outputLayouts.size(); ++k)
+            {
+                auto& output = outputs[call][outputLayouts[k].m_name == L"h1" ? 0 : 1];
+                outputRefs[k].m_buffer.InitFrom(output);
+            }
+            eval->ForwardPass(inputRefs, outputRefs);
+
+            BOOST_CHECK_EQUAL_COLLECTIONS(outputs[call][0].begin(), outputs[call][0].end(), expectedH[call].begin(), expectedH[call].end());
+            BOOST_CHECK_EQUAL_COLLECTIONS(outputs[call][1].begin(), outputs[call][1].end(), expectedO[call].begin(), expectedO[call].end());
+        }
+
+        // The buffers of the first call are not touched by the second one.
+        BOOST_CHECK_EQUAL_COLLECTIONS(outputs[0][0].begin(), outputs[0][0].end(), expectedH[0].begin(), expectedH[0].end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(outputs[0][1].begin(), outputs[0][1].end(), expectedO[0].begin(), expectedO[0].end());
+        BOOST_CHECK(inputs[0] == std::vector<float>({ 1, 2, 3, 4 }));
+
+        eval->Destroy();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(EvalBatchedDenseTimesTest)
+{
+    std::string modelDefinition =
+        "deviceId = -1 \n"
+        "precision = \"float\" \n"
+        "traceLevel = 1 \n"
+        "run=NDLNetworkBuilder \n"
+        "NDLNetworkBuilder=[ \n"
+        "i1 = Input(2) \n"
+        "o1 = Times(Constant(2, rows=1, cols=2), i1, tag=\"output\") \n"
+        "FeatureNodes = (i1) \n"
+        "] \n";
+
+    VariableSchema inputLayouts;
+    VariableSchema outputLayouts;
+    IEvaluateModelExtended<float> *eval;
+    eval = SetupNetworkAndGetLayouts(modelDefinition, inputLayouts, outputLayouts);
+
+    // Three sequences of different length in one batch.
+    std::vector<Values<float>> inputBuffers(3, Values<float>(1));
+    inputBuffers[0][0].m_buffer = { 1, 2, 3, 4 };
+    inputBuffers[1][0].m_buffer = { 5, 6 };
+    inputBuffers[2][0].m_buffer = { 1, 1, 2, 2, 3, 3 };
+
+    std::vector<Values<float>> outputBuffers(3, outputLayouts.CreateBuffers<float>({ 3 }));
+    std::vector<bool> reset(3, true);
+
+    // Reset flags must be given for every sequence.
+    std::vector<bool> tooFewFlags(2, true);
+    BOOST_REQUIRE_THROW(eval->ForwardPass(inputBuffers, outputBuffers, tooFewFlags), std::exception);
+
+    eval->ForwardPass(inputBuffers, outputBuffers, reset);
+
+    std::vector<std::vector<float>> expected{ { 6, 14 }, { 22 }, { 4, 8, 12 } };
+    for (size_t s = 0; s < expected.size(); ++s)
+    {
+        auto buf = outputBuffers[s][0].m_buffer;
+        BOOST_CHECK_EQUAL_COLLECTIONS(buf.begin(), buf.end(), expected[s].begin(), expected[s].end());
+    }
+
+    eval->Destroy();
+}
+
+BOOST_AUTO_TEST_CASE(EvalBatchingConcurrentRequestsTest)
+{
+    std::string modelDefinition =
+        "deviceId = -1 \n"
+        "precision = \"float\" \n"
+        "traceLevel = 1 \n"
+        "run=NDLNetworkBuilder \n"
+        "NDLNetworkBuilder=[ \n"
+        "i1 = Input(1) \n"
+        "o1 = Times(Constant(3), i1, tag=\"output\") \n"
+        "FeatureNodes = (i1) \n"
+        "] \n";
+
+    IEvaluateModelExtended<float> *eval;
+    GetEvalExtendedBatchingF(&eval);
+    eval->Init("maxBatchSize=4 maxBatchDelay=5");
+    eval->CreateNetwork(modelDefinition);
+    VariableSchema outputLayouts = eval->GetOutputSchema();
+    eval->StartForwardEvaluation({ outputLayouts[0].m_name });
+    outputLayouts = eval->GetOutputSchema();
+
+    // Every thread sends its own single-sample request and must get its own result back.
+    const size_t numThreads = 8;
+    std::vector<Values<float>> outputBuffers(numThreads, outputLayouts.CreateBuffers<float>({ 1 }));
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; ++t)
+    {
+        threads.push_back(std::thread([eval, t, &outputBuffers]()
+        {
+            Values<float> inputBuffer(1);
+            inputBuffer[0].m_buffer = { (float)t };
+            eval->ForwardPass(inputBuffer, outputBuffers[t]);
+        }));
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    for (size_t t = 0; t < numThreads; ++t)
+    {
+        std::vector<float> expected{ 3.0f * t };
+        auto buf = outputBuffers[t][0].m_buffer;
+        BOOST_CHECK_EQUAL_COLLECTIONS(buf.begin(), buf.end(), expected.begin(), expected.end());
+    }
+
+    // Requests cannot continue an RNN state.
+    Values<float> inputBuffer(1);
+    inputBuffer[0].m_buffer = { 1 };
+    BOOST_REQUIRE_THROW(eval->ForwardPass(inputBuffer, outputBuffers[0], false), std::exception);
+
+    eval->Destroy();
+}
+
+BOOST_AUTO_TEST_CASE(EvalBatchingRejectsBadRequestAloneTest)
+{
+    std::string modelDefinition =
+        "deviceId = -1 \n"
+        "precision = \"float\" \n"
+        "traceLevel = 1 \n"
+        "run=NDLNetworkBuilder \n"
+        "NDLNetworkBuilder=[ \n"
+        "i1 = Input(2) \n"
+        "o1 = Times(Constant(3, rows=1, cols=2), i1, tag=\"output\") \n"
+        "FeatureNodes = (i1) \n"
+        "] \n";
+
+    IEvaluateModelExtended<float> *eval;
+    GetEvalExtendedBatchingF(&eval);
+    eval->Init("maxBatchSize=8 maxBatchDelay=20");
+    eval->CreateNetwork(modelDefinition);
+    VariableSchema outputLayouts = eval->GetOutputSchema();
+    eval->StartForwardEvaluation({ outputLayouts[0].m_name });
+    outputLayouts = eval->GetOutputSchema();
+
+    // Bad requests are sent along with good ones; each must fail alone.
+    const size_t numThreads = 4;
+    std::vector<Values<float>> outputBuffers(numThreads, outputLayouts.CreateBuffers<float>({ 1 }));
+    std::vector<char> failed(numThreads, false); // (not vector<bool>, which the threads could not write concurrently)
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; ++t)
+    {
+        threads.push_back(std::thread([eval, t, &outputBuffers, &failed]()
+        {
+            Values<float> inputBuffer(t == 3 ? 2 : 1); // thread 3 passes too many inputs
+            inputBuffer[0].m_buffer = { (float)t, 1 };
+            if (t == 1)
+                inputBuffer[0].m_buffer.push_back(2); // not a multiple of the input dimension
+            try
+            {
+                eval->ForwardPass(inputBuffer, outputBuffers[t]);
+            }
+            catch (const std::exception&)
+            {
+                failed[t] = true;
+            }
+        }));
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    BOOST_CHECK(!failed[0] && failed[1] && !failed[2] && failed[3]);
+    for (size_t t : { 0, 2 })
+    {
+        std::vector<float> expected{ 3.0f * (t + 1) };
+        auto buf = outputBuffers[t][0].m_buffer;
+        BOOST_CHECK_EQUAL_COLLECTIONS(buf.begin(), buf.end(), expected.begin(), expected.end());
+    }
+
+    eval->Destroy();
+}
+
+BOOST_AUTO_TEST_CASE(EvalCloneSharingParametersTest)
+{
+    std::string modelDefinition =
+        "deviceId = -1 \n"
+        "precision = \"float\" \n"
+        "traceLevel = 1 \n"
+        "run=NDLNetworkBuilder \n"
+        "NDLNetworkBuilder=[ \n"
+        "i1 = Input(4) \n"
+        "w = Parameter(2, 4, init = \"uniform\", initValueScale = 1) \n"
+        "o1 = Times(w, i1, tag=\"output\") \n"
+        "FeatureNodes = (i1) \n"
+        "] \n";
+
+    IEvaluateModelExtended<float> *eval;
+    GetEvalExtendedF(&eval);
+    eval->CreateNetwork(modelDefinition);
+
+    // Clones are created before starting the evaluation and are evaluated concurrently.
+    const size_t numInstances = 4;
+    std::vector<IEvaluateModelExtended<float>*> instances{ eval };
+    for (size_t i = 1; i < numInstances; ++i)
+        instances.push_back(eval->CloneSharingParameters());
+
+    VariableSchema outputLayouts = eval->GetOutputSchema();
+    for (auto instance : instances)
+        instance->StartForwardEvaluation({ outputLayouts[0].m_name });
+
+    std::vector<Values<float>> outputBuffers(numInstances, outputLayouts.CreateBuffers<float>({ 1 }));
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < numInstances; ++i)
+    {
+        threads.push_back(std::thread([&instances, &outputBuffers, i]()
+        {
+            Values<float> inputBuffer(1);
+            inputBuffer[0].m_buffer = { 1, 2, 3, 4 };
+            for (size_t k = 0; k < 10; ++k)
+                instances[i]->ForwardPass(inputBuffer, outputBuffers[i]);
+        }));
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    // All instances use the same parameters.
+    auto expected = outputBuffers[0][0].m_buffer;
+    BOOST_REQUIRE_EQUAL(expected.size(), 2);
+    for (size_t i = 1; i < numInstances; ++i)
+    {
+        auto buf = outputBuffers[i][0].m_buffer;
+        BOOST_CHECK_EQUAL_COLLECTIONS(buf.begin(), buf.end(), expected.begin(), expected.end());
+    }
+
+    // Clones stay valid after the original is gone.
+    eval->Destroy();
+    Values<float> inputBuffer(1);
+    inputBuffer[0].m_buffer = { 1, 2, 3, 4 };
+    instances[1]->ForwardPass(inputBuffer, outputBuffers[1]);
+    auto buf = outputBuffers[1][0].m_buffer;
+    BOOST_CHECK_EQUAL_COLLECTIONS(buf.begin(), buf.end(), expected.begin(), expected.end());
+
+    for (size_t i = 1; i < numInstances; ++i)
+        instances[i]->Destroy();
+}
+
 BOOST_AUTO_TEST_CASE(EvalSparseTimesTest)
 {
     std::string modelDefinition =
@@ -11,6 +11,8 @@
 #include "FileTest.h"
 #include "File.h"
 #include "Matrix.h"
+#include <chrono>
+#include <random>
 
 using namespace Microsoft::MSR::CNTK;
 
@@ -28,6 +30,57 @@ void MatrixFileWriteAndRead()
         fprintf(stderr, "matrix read/write doesn't pass");
 }
 
+// measure write/read throughput for a large array of floats:
+// element by element vs. WriteArray()/ReadArray(), each with and without fileOptionsSequential
+// Note that the read numbers mostly reflect the OS file cache, unless the file lives on a network share.
+void FileThroughputBenchmark(const wchar_t* filename)
+{
+    std::vector<float> data(16 * 1024 * 1024); // 64 MB
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for (auto& v : data)
+        v = dist(rng);
+    std::vector<float> dataRead(data.size());
+
+    for (int sequential = 0; sequential < 2; sequential++)
+    {
+        for (int bulk = 0; bulk < 2; bulk++)
+        {
+            const int options = fileOptionsBinary | (sequential ? fileOptionsSequential : 0);
+            auto start = std::chrono::steady_clock::now();
+            {
+                File file(filename, options | fileOptionsWrite);
+                if (bulk)
+                    file.WriteArray(data.data(), data.size());
+                else
+                {
+                    for (size_t i = 0; i < data.size(); i++)
+                        file << data[i];
+                }
+            }
+            auto mid = std::chrono::steady_clock::now();
+            {
+                File file(filename, options | fileOptionsRead);
+                if (bulk)
+                    file.ReadArray(dataRead.data(), dataRead.size());
+                else
+                {
+                    for (size_t i = 0; i < dataRead.size(); i++)
+                        file >> dataRead[i];
+                }
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            const double megaBytes = data.size() * sizeof(float) / (1024.0 * 1024.0);
+            const double writeSeconds = std::chrono::duration<double>(mid - start).count();
+            const double readSeconds = std::chrono::duration<double>(end - mid).count();
+            fprintf(stderr, "%-13s %-10s write %8.1f MB/s, read %8.1f MB/s%s\n",
+                    bulk ? "bulk" : "per-element", sequential ? "sequential" : "default",
+                    megaBytes / writeSeconds, megaBytes / readSeconds, dataRead == data ? "" : " (MISMATCH)");
+        }
+    }
+}
+
 // Test the File API
 // filename - file to open and read
 void TestFileAPI(const TCHAR* filename, int options)
@@ -65,6 +118,7 @@ int _tmain(int argc, _TCHAR* argv[])
 {
     msra::util::command_line args(argc, argv);
     int options = fileOptionsNull;
+    bool benchmark = false;
     while (args.has(1) && args[0][0] == '-')
     {
         const wchar_t* arg = args.shift();
@@ -105,8 +159,12 @@ int _tmain(int argc, _TCHAR* argv[])
         case L'W':
             options |= fileOptionsWrite;
             break;
+        case L'p':
+        case L'P':
+            benchmark = true;
+            break;
         default:
-            fprintf(stderr, "invalid option, valid options are:\nFile Type:\n-text > text file (UTF-8)\n-unicode > unicode text file\n-binary > binary file\nOperation:\n-read > read file passed\n-write > write the file given (overwrite if it exists)\n");
+            fprintf(stderr, "invalid option, valid options are:\nFile Type:\n-text > text file (UTF-8)\n-unicode > unicode text file\n-binary > binary file\nOperation:\n-read > read file passed\n-write > write the file given (overwrite if it exists)\n-perf > measure write/read throughput using the file given (overwrite if it exists)\n");
             goto exit;
             break;
         }
@@ -131,7 +189,10 @@ int _tmain(int argc, _TCHAR* argv[])
         fprintf(stderr, "filename expected after options\n");
         goto exit;
     }
-    TestFileAPI(filename, options);
+    if (benchmark)
+        FileThroughputBenchmark(filename);
+    else
+        TestFileAPI(filename, options);
 exit:
     return 0;
 }
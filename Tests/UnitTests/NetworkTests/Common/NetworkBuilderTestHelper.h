@@ -0,0 +1,168 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Helpers for tests that build small networks in code and run them the way SGD and the evaluator do.
+// They are mostly used to check that an optimized evaluation path gives the same values and gradients as the plain one.
+//
+#pragma once
+
+#include "ComputationNetwork.h"
+#include "ComputationNetworkBuilder.h"
+#include "InputAndParamNodes.h"
+#include <boost/test/unit_test.hpp>
+#include <functional>
+#include <map>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft {
+namespace MSR {
+namespace CNTK {
+namespace Test {
+
+// Adds the nodes of a network to 'builder'. Criterion and output nodes are to be tagged through net.AddToNodeGroup().
+template <class ElemType>
+using NetworkDefinition = std::function<void(ComputationNetworkBuilder<ElemType>& builder, ComputationNetwork& net)>;
+
+// Creates a network on the CPU and initializes its parameters from fixed seeds,
+// so that two networks created from the same definition start out identical.
+template <class ElemType>
+ComputationNetworkPtr CreateTestNetwork(const NetworkDefinition<ElemType>& define)
+{
+    auto net = make_shared<ComputationNetwork>(CPUDEVICE);
+    ComputationNetworkBuilder<ElemType> builder(*net);
+    define(builder, *net);
+    net->CompileNetwork();
+
+    unsigned long randomSeed = 1;
+    for (const auto& node : net->GetNodesWithType(OperationNameOf(LearnableParameter)))
+        net->RandomInitLearnableParameters(node, /*uniformInit=*/true, randomSeed++, /*initValueScale=*/1.0, /*initOnCPUOnly=*/true);
+    return net;
+}
+
+// Allocates the matrices for training the network's first criterion while also keeping the values of its output nodes.
+// Options that take effect when matrices are allocated (e.g. ComputationNetwork::SetFuseElementwiseOps()) must be set before.
+inline void PrepareForTraining(const ComputationNetworkPtr& net)
+{
+    auto criterion = net->FinalCriterionNodes()[0];
+    net->AllocateAllMatrices({}, net->OutputNodes(), criterion);
+    net->StartEvaluateMinibatchLoop(criterion);
+    net->StartEvaluateMinibatchLoop(net->OutputNodes());
+}
+
+inline void PrepareForEvaluation(const ComputationNetworkPtr& net)
+{
+    net->AllocateAllMatrices({}, net->OutputNodes(), nullptr);
+    net->StartEvaluateMinibatchLoop(net->OutputNodes());
+}
+
+// Sets the value of an input node to a minibatch of parallel sequences, like a reader does.
+// sequences[s] holds the samples of sequence s one after the other. Shorter sequences are padded with gaps.
+template <class ElemType>
+void SetInputSequences(const ComputationNodeBasePtr& inputNode, const std::vector<std::vector<ElemType>>& sequences)
+{
+    auto node = dynamic_pointer_cast<ComputationNode<ElemType>>(inputNode);
+    size_t dim = node->GetSampleLayout().GetNumElements();
+    size_t numSequences = sequences.size();
+
+    size_t maxLength = 0;
+    for (const auto& sequence : sequences)
+        maxLength = max(maxLength, sequence.size() / dim);
+
+    auto& layout = node->GetMBLayout();
+    layout->Init(numSequences, maxLength);
+    std::vector<ElemType> packed(dim * numSequences * maxLength, 0);
+    for (size_t s = 0; s < numSequences; s++)
+    {
+        size_t length = sequences[s].size() / dim;
+        layout->AddSequence(s, s, 0, length);
+        if (length < maxLength)
+            layout->AddGap(s, length, maxLength);
+        for (size_t t = 0; t < length; t++)
+            memcpy(&packed[(t * numSequences + s) * dim], &sequences[s][t * dim], dim * sizeof(ElemType));
+    }
+
+    node->Value().SetValue(dim, numSequences * maxLength, node->GetDeviceId(), packed.data());
+    ComputationNetwork::BumpEvalTimeStamp({ inputNode });
+}
+
+template <class ElemType>
+std::vector<ElemType> CopyToVector(const Matrix<ElemType>& matrix)
+{
+    std::vector<ElemType> result(matrix.GetNumElements());
+    ElemType* data = result.data();
+    size_t size = result.size();
+    matrix.CopyToArray(data, size);
+    return result;
+}
+
+template <class ElemType>
+std::vector<ElemType> GetValue(const ComputationNodeBasePtr& node)
+{
+    return CopyToVector(dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Value());
+}
+
+// Runs forward prop of all output nodes and returns their values, in the order of net->OutputNodes().
+template <class ElemType>
+std::vector<std::vector<ElemType>> Evaluate(const ComputationNetworkPtr& net)
+{
+    std::vector<std::vector<ElemType>> values;
+    for (const auto& node : net->OutputNodes())
+    {
+        net->ForwardProp(node);
+        values.push_back(GetValue<ElemType>(node));
+    }
+    return values;
+}
+
+// Runs forward and backward prop of the first criterion like one SGD step (without the update)
+// and returns the gradients of all parameters by parameter name.
+template <class ElemType>
+std::map<std::wstring, std::vector<ElemType>> ComputeGradients(const ComputationNetworkPtr& net)
+{
+    auto criterion = net->FinalCriterionNodes()[0];
+    ScopedNetworkOperationMode modeGuard(net, NetworkOperationMode::training);
+    net->ForwardProp(criterion);
+    net->Backprop(criterion);
+
+    std::map<std::wstring, std::vector<ElemType>> gradients;
+    for (const auto& node : net->LearnableParameterNodes(criterion))
+        gradients[node->NodeName()] = CopyToVector(dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Gradient());
+    return gradients;
+}
+
+template <class ElemType>
+void CheckClose(const std::vector<ElemType>& actual, const std::vector<ElemType>& expected, double tolerance = 1e-5)
+{
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); i++)
+        BOOST_CHECK_SMALL((double)actual[i] - (double)expected[i], tolerance * max(1.0, fabs((double)expected[i])));
+}
+
+// for the results of Evaluate()
+template <class ElemType>
+void CheckClose(const std::vector<std::vector<ElemType>>& actual, const std::vector<std::vector<ElemType>>& expected, double tolerance = 1e-5)
+{
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (size_t k = 0; k < actual.size(); k++)
+        CheckClose(actual[k], expected[k], tolerance);
+}
+
+template <class ElemType>
+void CheckClose(const std::map<std::wstring, std::vector<ElemType>>& actual, const std::map<std::wstring, std::vector<ElemType>>& expected, double tolerance = 1e-5)
+{
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (const auto& entry : expected)
+    {
+        BOOST_TEST_MESSAGE("Comparing " + string(entry.first.begin(), entry.first.end()));
+        BOOST_REQUIRE(actual.find(entry.first) != actual.end());
+        CheckClose(actual.at(entry.first), entry.second, tolerance);
+    }
+}
+
+}
+}
+}
+}
@@ -0,0 +1,192 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "Common/NetworkBuilderTestHelper.h"
+#include <boost/filesystem.hpp>
+#include <thread>
+
+using namespace Microsoft::MSR::CNTK;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+BOOST_AUTO_TEST_SUITE(ComputationNetworkTestSuite)
+
+BOOST_AUTO_TEST_CASE(CloneSharingParameters)
+{
+    const size_t inputDim = 3, hiddenDim = 4;
+    auto net = CreateTestNetwork<float>([=](ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+    {
+        auto x = builder.CreateInputNode(L"x", inputDim);
+        auto w = builder.CreateLearnableParameter(L"W", hiddenDim, inputDim);
+        auto b = builder.CreateLearnableParameter(L"b", hiddenDim, 1);
+        auto o = builder.Tanh(builder.Plus(builder.Times(w, x), b), L"o");
+        net.AddToNodeGroup(L"feature", x);
+        net.AddToNodeGroup(L"output", o);
+    });
+
+    const size_t numClones = 4;
+    std::vector<ComputationNetworkPtr> clones;
+    for (size_t i = 0; i < numClones; i++)
+        clones.push_back(net->CloneSharingParameters());
+
+    // parameters share their storage with the original, everything else is private to the clone
+    for (const auto& clone : clones)
+    {
+        for (const auto& name : { L"W", L"b" })
+        {
+            auto original = dynamic_pointer_cast<ComputationNode<float>>(net->GetNodeFromName(name));
+            auto copy = dynamic_pointer_cast<ComputationNode<float>>(clone->GetNodeFromName(name));
+            BOOST_CHECK(copy != original);
+            BOOST_CHECK_EQUAL(copy->Value().Data(), original->Value().Data());
+        }
+        BOOST_CHECK(clone->GetNodeFromName(L"x") != net->GetNodeFromName(L"x"));
+    }
+
+    std::vector<std::vector<float>> sequences{ { 1, 2, 3, -1, -2, -3 }, { 0.5f, 0, -0.5f } };
+    PrepareForEvaluation(net);
+    SetInputSequences(net->GetNodeFromName(L"x"), sequences);
+    auto expected = Evaluate<float>(net);
+
+    // the clones are evaluated concurrently, each on its own thread
+    std::vector<std::vector<std::vector<float>>> results(numClones);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < numClones; i++)
+    {
+        threads.push_back(std::thread([&clones, &results, &sequences, i]()
+        {
+            PrepareForEvaluation(clones[i]);
+            for (size_t k = 0; k < 10; k++)
+            {
+                SetInputSequences(clones[i]->GetNodeFromName(L"x"), sequences);
+                results[i] = Evaluate<float>(clones[i]);
+            }
+        }));
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    for (const auto& result : results)
+        CheckClose(result, expected);
+}
+
+// a single layer, enough to check that parameter values survive saving and loading
+static void DefineSingleLayer(ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+{
+    auto x = builder.CreateInputNode(L"x", 3);
+    auto w = builder.CreateLearnableParameter(L"W", 4, 3);
+    auto b = builder.CreateLearnableParameter(L"b", 4, 1);
+    auto o = builder.Sigmoid(builder.Plus(builder.Times(w, x), b), L"o");
+    net.AddToNodeGroup(L"feature", x);
+    net.AddToNodeGroup(L"output", o);
+}
+
+static ComputationNetworkPtr LoadTestNetwork(const std::wstring& fileName)
+{
+    auto net = make_shared<ComputationNetwork>(CPUDEVICE);
+    net->Load<float>(fileName);
+    return net;
+}
+
+static std::vector<std::vector<float>> EvaluateSingleLayer(const ComputationNetworkPtr& net)
+{
+    std::vector<std::vector<float>> sequences{ { 1, 2, 3, -1, -2, -3 }, { 0.5f, 0, -0.5f } };
+    PrepareForEvaluation(net);
+    SetInputSequences(net->GetNodeFromName(L"x"), sequences);
+    return Evaluate<float>(net);
+}
+
+BOOST_AUTO_TEST_CASE(MappableModelRoundTrip)
+{
+    auto net = CreateTestNetwork<float>(DefineSingleLayer);
+    const auto path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).wstring();
+    const std::wstring modelFile = path + L".dnn", mappableFile = path + L".mappable.dnn";
+    net->Save(modelFile);
+    net->SaveMappable(mappableFile);
+
+    auto expected = EvaluateSingleLayer(LoadTestNetwork(modelFile));
+    {
+        auto mapped = LoadTestNetwork(mappableFile);
+        CheckClose(EvaluateSingleLayer(mapped), expected);
+
+        // the parameters of a clone point into the mapping, which must outlive the network that loaded it
+        auto clone = mapped->CloneSharingParameters();
+        mapped.reset();
+        CheckClose(EvaluateSingleLayer(clone), expected);
+    }
+    {
+        // going back to a mappable model, like SGD does after a bad epoch
+        auto reread = LoadTestNetwork(modelFile);
+        reread->RandomInitLearnableParameters(reread->GetNodeFromName(L"W"), /*uniformInit=*/true, /*randomSeed=*/99, /*initValueScale=*/1.0, /*initOnCPUOnly=*/true);
+        reread->RereadPersistableParameters<float>(mappableFile);
+        CheckClose(EvaluateSingleLayer(reread), expected);
+    }
+
+    boost::filesystem::remove(modelFile);
+    boost::filesystem::remove(mappableFile);
+}
+
+// all LearnableParameter values of a network, by node name
+static std::map<std::wstring, std::vector<float>> GetParameterValues(const ComputationNetworkPtr& net)
+{
+    std::map<std::wstring, std::vector<float>> values;
+    for (const auto& node : net->GetNodesWithType(OperationNameOf(LearnableParameter)))
+        values[node->NodeName()] = GetValue<float>(node);
+    return values;
+}
+
+BOOST_AUTO_TEST_CASE(ParallelAndSerialLoadsMatch)
+{
+    // more parameters than load workers, of different sizes
+    const size_t numLayers = 12;
+    auto net = CreateTestNetwork<float>([=](ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+    {
+        shared_ptr<ComputationNode<float>> h = builder.CreateInputNode(L"x", 3);
+        size_t dim = 3;
+        for (size_t i = 0; i < numLayers; i++)
+        {
+            const size_t outDim = 2 + (i * 7) % 11;
+            auto w = builder.CreateLearnableParameter(L"W" + std::to_wstring(i), outDim, dim);
+            auto b = builder.CreateLearnableParameter(L"b" + std::to_wstring(i), outDim, 1);
+            h = builder.Tanh(builder.Plus(builder.Times(w, h), b), L"h" + std::to_wstring(i));
+            dim = outDim;
+        }
+        net.AddToNodeGroup(L"feature", net.GetNodeFromName(L"x"));
+        net.AddToNodeGroup(L"output", h);
+    });
+    const auto fileName = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).wstring() + L".dnn";
+    net->Save(fileName);
+
+    const bool wasParallel = ComputationNetwork::GetParallelParameterLoading();
+    ComputationNetwork::SetParallelParameterLoading(false);
+    auto serial = LoadTestNetwork(fileName);
+    ComputationNetwork::SetParallelParameterLoading(true);
+    auto parallel = LoadTestNetwork(fileName);
+    ComputationNetwork::SetParallelParameterLoading(wasParallel);
+
+    const auto expected = GetParameterValues(net);
+    BOOST_CHECK_EQUAL(expected.size(), 2 * numLayers);
+    // both paths read the same bytes, so the values must be identical
+    BOOST_CHECK(GetParameterValues(serial) == expected);
+    BOOST_CHECK(GetParameterValues(parallel) == expected);
+    BOOST_CHECK_EQUAL(parallel->GetTotalNumberOfNodes(), serial->GetTotalNumberOfNodes());
+    for (const auto& node : serial->GetAllNodes())
+    {
+        auto other = parallel->GetNodeFromName(node->NodeName());
+        BOOST_CHECK(other->OperationName() == node->OperationName());
+        BOOST_CHECK(other->GetSampleLayout() == node->GetSampleLayout());
+    }
+
+    // reloading into an existing network goes through the same code
+    parallel->RandomInitLearnableParameters(parallel->GetNodeFromName(L"W0"), /*uniformInit=*/true, /*randomSeed=*/99, /*initValueScale=*/1.0, /*initOnCPUOnly=*/true);
+    parallel->RereadPersistableParameters<float>(fileName);
+    BOOST_CHECK(GetParameterValues(parallel) == expected);
+
+    boost::filesystem::remove(fileName);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}}}
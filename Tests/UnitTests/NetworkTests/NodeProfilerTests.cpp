@@ -0,0 +1,116 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "Common/NetworkBuilderTestHelper.h"
+#include "NodeProfiler.h"
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+using namespace Microsoft::MSR::CNTK;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+BOOST_AUTO_TEST_SUITE(NodeProfilerTestSuite)
+
+// one line of NodeProfiler::PrintTable()
+struct ProfileTableRow
+{
+    double percentOfTime;
+    int forwardCalls;
+    int backwardCalls;
+};
+
+static std::map<std::string, ProfileTableRow> ReadProfileTable(const NodeProfiler& profiler, std::vector<double>& percentsInOrder)
+{
+    FILE* f = tmpfile();
+    BOOST_REQUIRE(f != nullptr);
+    profiler.PrintTable(f, "test");
+    rewind(f);
+
+    std::map<std::string, ProfileTableRow> rows;
+    char line[1000];
+    while (fgets(line, sizeof(line), f))
+    {
+        ProfileTableRow row;
+        double forwardMs, backwardMs;
+        int nameOffset = 0;
+        if (sscanf(line, "%lf %lf %lf %d %d %*f %*f %*f %n", &row.percentOfTime, &forwardMs, &backwardMs, &row.forwardCalls, &row.backwardCalls, &nameOffset) < 5 || nameOffset == 0)
+            continue; // (title and column headers)
+        std::string node(line + nameOffset);
+        node = node.substr(0, node.find(' ')); // "name (operation)"
+        rows[node] = row;
+        percentsInOrder.push_back(row.percentOfTime);
+    }
+    fclose(f);
+    return rows;
+}
+
+BOOST_AUTO_TEST_CASE(ProfileOneMinibatch)
+{
+    const size_t inputDim = 3, hiddenDim = 4;
+    auto net = CreateTestNetwork<float>([=](ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+    {
+        auto x = builder.CreateInputNode(L"x", inputDim);
+        auto w = builder.CreateLearnableParameter(L"W", hiddenDim, inputDim);
+        auto z = builder.Times(w, x, 1, L"z");
+        auto h = builder.Sigmoid(z, L"h");
+        auto criterion = builder.Sum(h, L"criterion");
+        net.AddToNodeGroup(L"feature", x);
+        net.AddToNodeGroup(L"criterion", criterion);
+    });
+    PrepareForTraining(net);
+
+    std::vector<std::vector<float>> sequences{ { 1, 2, 3, 4, 5, 6 }, { -1, 0.5f, 2 } };
+    SetInputSequences(net->GetNodeFromName(L"x"), sequences);
+    auto profiler = make_shared<NodeProfiler>();
+    net->Environment().nodeProfiler = profiler;
+    ComputeGradients<float>(net);
+    net->Environment().nodeProfiler = nullptr;
+
+    // Times: 2 * (output elements) * (inner dimension), backward computes the gradients of both inputs
+    const size_t numCols = 2 * 2; // 2 parallel sequences of up to 2 frames
+    auto z = net->GetNodeFromName(L"z");
+    BOOST_CHECK_EQUAL(NodeProfiler::EstimateFlops(z, NodeProfiler::Pass::forward), 2.0 * hiddenDim * numCols * inputDim);
+    BOOST_CHECK_EQUAL(NodeProfiler::EstimateFlops(z, NodeProfiler::Pass::backward), 4.0 * hiddenDim * numCols * inputDim);
+    // everything else: one operation per output element and input
+    BOOST_CHECK_EQUAL(NodeProfiler::EstimateFlops(net->GetNodeFromName(L"h"), NodeProfiler::Pass::forward), 1.0 * hiddenDim * numCols);
+
+    // the table has each computing node, called once per pass, slowest first
+    std::vector<double> percentsInOrder;
+    auto rows = ReadProfileTable(*profiler, percentsInOrder);
+    for (const auto& name : { "z", "h", "criterion" })
+    {
+        BOOST_REQUIRE_MESSAGE(rows.find(name) != rows.end(), name);
+        BOOST_CHECK_EQUAL(rows[name].forwardCalls, 1);
+        BOOST_CHECK_EQUAL(rows[name].backwardCalls, 1);
+    }
+    for (size_t i = 1; i < percentsInOrder.size(); i++)
+        BOOST_CHECK_GE(percentsInOrder[i - 1], percentsInOrder[i]);
+
+    // the trace is well-formed JSON with one event per node and pass
+    const auto fileName = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).wstring() + L".json";
+    profiler->WriteChromeTrace(fileName);
+    boost::property_tree::ptree trace;
+    boost::property_tree::read_json(boost::filesystem::path(fileName).string(), trace); // throws if malformed
+    boost::filesystem::remove(fileName);
+
+    std::map<std::pair<std::string, std::string>, size_t> numEvents; // (name, pass) -> count
+    for (const auto& event : trace.get_child("traceEvents"))
+    {
+        BOOST_CHECK_EQUAL(event.second.get<std::string>("ph"), "X");
+        BOOST_CHECK_GE(event.second.get<double>("dur"), 0);
+        numEvents[make_pair(event.second.get<std::string>("name"), event.second.get<std::string>("cat"))]++;
+    }
+    for (const auto& events : numEvents)
+        BOOST_CHECK_EQUAL(events.second, 1);
+    BOOST_CHECK_EQUAL(numEvents.count(make_pair(std::string("z (Times)"), std::string("forward"))), 1);
+    BOOST_CHECK_EQUAL(numEvents.count(make_pair(std::string("z (Times)"), std::string("backward"))), 1);
+    BOOST_CHECK_EQUAL(numEvents.count(make_pair(std::string("criterion (SumElements)"), std::string("backward"))), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}}}
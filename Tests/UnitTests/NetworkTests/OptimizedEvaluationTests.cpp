@@ -0,0 +1,597 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// Each of the optional evaluation paths of ComputationNetwork must give the same values and gradients as the plain one.
+//
+#include "stdafx.h"
+#include "Common/NetworkBuilderTestHelper.h"
+#include "TrainingNodes.h"
+#include <boost/filesystem.hpp>
+
+using namespace Microsoft::MSR::CNTK;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// the outputs and the parameter gradients of a network for a series of minibatches
+struct MinibatchResults
+{
+    std::vector<std::vector<std::vector<float>>> outputs;
+    std::vector<std::map<std::wstring, std::vector<float>>> gradients;
+};
+
+// Evaluate(), but with the gaps of the outputs set to zero, since only the valid frames have defined values
+static std::vector<std::vector<float>> EvaluateValidFrames(const ComputationNetworkPtr& net)
+{
+    std::vector<std::vector<float>> values;
+    for (const auto& nodep : net->OutputNodes())
+    {
+        net->ForwardProp(nodep);
+        auto node = dynamic_pointer_cast<ComputationNode<float>>(nodep);
+        auto value = node->Value().DeepClone();
+        if (node->HasMBLayout())
+            ComputationNode<float>::MaskMissingColumnsToZero(value, node->GetMBLayout(), FrameRange(node->GetMBLayout()));
+        values.push_back(CopyToVector(value));
+    }
+    return values;
+}
+
+// Creates the network, with the options that the caller set, and runs 'numMinibatches' minibatches through it, which 'setInput'
+// sets into the input node L"x", either like SGD (forward and backward prop) or like the evaluator (forward prop of the outputs only).
+// 'check', if given, is called on the network after each minibatch.
+static MinibatchResults RunMinibatches(const NetworkDefinition<float>& define, size_t numMinibatches, const std::function<void(const ComputationNodeBasePtr&, size_t)>& setInput,
+                                       bool training, const std::function<void(const ComputationNetworkPtr&)>& check = nullptr)
+{
+    auto net = CreateTestNetwork<float>(define);
+    if (training)
+        PrepareForTraining(net);
+    else
+        PrepareForEvaluation(net);
+
+    MinibatchResults results;
+    for (size_t m = 0; m < numMinibatches; m++)
+    {
+        setInput(net->GetNodeFromName(L"x"), m);
+        if (training)
+            results.gradients.push_back(ComputeGradients<float>(net));
+        results.outputs.push_back(EvaluateValidFrames(net));
+        if (check)
+            check(net);
+    }
+    return results;
+}
+
+// RunMinibatches() for minibatches of input sequences that each start at the first frame (see SetInputSequences())
+static MinibatchResults RunMinibatches(const NetworkDefinition<float>& define, const std::vector<std::vector<std::vector<float>>>& minibatches, bool training,
+                                       const std::function<void(const ComputationNetworkPtr&)>& check = nullptr)
+{
+    return RunMinibatches(define, minibatches.size(), [&](const ComputationNodeBasePtr& input, size_t m) { SetInputSequences(input, minibatches[m]); }, training, check);
+}
+
+// RunMinibatches() for minibatches of the given layouts, e.g. from MBLayout::InitAsPackedSequences() or with sequences that began
+// in the previous minibatch, whose frames are filled with values that only depend on their position
+static MinibatchResults RunMinibatches(const NetworkDefinition<float>& define, const std::vector<MBLayoutPtr>& layouts, bool training,
+                                       const std::function<void(const ComputationNetworkPtr&)>& check = nullptr)
+{
+    return RunMinibatches(define, layouts.size(), [&](const ComputationNodeBasePtr& inputNode, size_t m)
+    {
+        auto input = dynamic_pointer_cast<ComputationNode<float>>(inputNode);
+        const auto& layout = layouts[m];
+        input->GetMBLayout()->CopyFrom(layout);
+        size_t dim = input->GetSampleLayout().GetNumElements();
+        size_t numSequences = layout->GetNumParallelSequences();
+        std::vector<float> packed(dim * layout->GetNumCols(), 0);
+        for (const auto& sequence : layout->GetAllSequences())
+        {
+            if (sequence.seqId == GAP_SEQUENCE_ID)
+                continue;
+            size_t tEnd = min(sequence.tEnd, layout->GetNumTimeSteps());
+            for (size_t t = (size_t)max(sequence.tBegin, (ptrdiff_t)0); t < tEnd; t++)
+                for (size_t i = 0; i < dim; i++)
+                    packed[(t * numSequences + sequence.s) * dim + i] = (float)sin(1.0 + 0.7 * i + 1.3 * t + 0.9 * sequence.s + 2.1 * m);
+        }
+        input->Value().SetValue(dim, layout->GetNumCols(), input->GetDeviceId(), packed.data());
+        ComputationNetwork::BumpEvalTimeStamp({ inputNode });
+    }, training, check);
+}
+
+static void CheckClose(const MinibatchResults& actual, const MinibatchResults& expected, double tolerance = 1e-5)
+{
+    BOOST_REQUIRE_EQUAL(actual.outputs.size(), expected.outputs.size());
+    for (size_t i = 0; i < expected.outputs.size(); i++)
+        CheckClose(actual.outputs[i], expected.outputs[i], tolerance);
+    BOOST_REQUIRE_EQUAL(actual.gradients.size(), expected.gradients.size());
+    for (size_t i = 0; i < expected.gradients.size(); i++)
+        CheckClose(actual.gradients[i], expected.gradients[i], tolerance);
+}
+
+// three minibatches of sequences of 'dim'-dimensional samples, of different lengths
+static std::vector<std::vector<std::vector<float>>> CreateMinibatches(size_t dim)
+{
+    std::vector<std::vector<std::vector<float>>> minibatches;
+    const std::vector<std::vector<size_t>> lengths{ { 5, 3, 1 }, { 2, 6 }, { 4, 4, 2, 7 } };
+    for (size_t m = 0; m < lengths.size(); m++)
+    {
+        std::vector<std::vector<float>> sequences;
+        for (size_t s = 0; s < lengths[m].size(); s++)
+        {
+            std::vector<float> sequence(lengths[m][s] * dim);
+            for (size_t i = 0; i < sequence.size(); i++)
+                sequence[i] = (float)sin(1.0 + 0.7 * i + 1.3 * s + 2.1 * m);
+            sequences.push_back(sequence);
+        }
+        minibatches.push_back(sequences);
+    }
+    return minibatches;
+}
+
+// restores the global options that the tests set, also when a test fails
+struct EvaluationOptionsFixture
+{
+    EvaluationOptionsFixture()
+        : m_numInterOpThreads(ComputationNetwork::GetNumInterOpThreads()),
+          m_shrinkRecurrentLoops(ComputationNetwork::GetShrinkRecurrentLoops()),
+          m_captureRecurrentSteps(ComputationNetwork::GetCaptureRecurrentSteps()),
+          m_maxCapturedGeometries(ComputationNetwork::GetMaxCapturedGeometries()),
+          m_recomputeValues(ComputationNetwork::GetRecomputeValues()),
+          m_recomputeSegmentLength(ComputationNetwork::GetRecomputeSegmentLength()),
+          m_compressActivationStash(ComputationNodeBase::GetCompressActivationStash()),
+          m_fuseElementwiseOps(ComputationNetwork::GetFuseElementwiseOps()),
+          m_cacheStaticSubgraphs(ComputationNetwork::GetCacheStaticSubgraphs()),
+          m_shareNodeValueMatrices(g_shareNodeValueMatrices)
+    {
+    }
+
+    ~EvaluationOptionsFixture()
+    {
+        ComputationNetwork::SetNumInterOpThreads(m_numInterOpThreads);
+        ComputationNetwork::SetShrinkRecurrentLoops(m_shrinkRecurrentLoops);
+        ComputationNetwork::SetCaptureRecurrentSteps(m_captureRecurrentSteps, m_maxCapturedGeometries);
+        ComputationNetwork::SetRecomputeValues(m_recomputeValues, m_recomputeSegmentLength);
+        ComputationNodeBase::SetCompressActivationStash(m_compressActivationStash);
+        ComputationNetwork::SetFuseElementwiseOps(m_fuseElementwiseOps);
+        ComputationNetwork::SetCacheStaticSubgraphs(m_cacheStaticSubgraphs);
+        g_shareNodeValueMatrices = m_shareNodeValueMatrices;
+    }
+
+    size_t m_numInterOpThreads;
+    bool m_shrinkRecurrentLoops;
+    bool m_captureRecurrentSteps;
+    size_t m_maxCapturedGeometries;
+    bool m_recomputeValues;
+    size_t m_recomputeSegmentLength;
+    bool m_compressActivationStash;
+    bool m_fuseElementwiseOps;
+    bool m_cacheStaticSubgraphs;
+    bool m_shareNodeValueMatrices;
+};
+
+BOOST_FIXTURE_TEST_SUITE(OptimizedEvaluationTestSuite, EvaluationOptionsFixture)
+
+// independent branches that share their input and a parameter, whose gradient they both accumulate into
+static void DefineBranches(ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+{
+    auto x = builder.CreateInputNode(L"x", 3);
+    auto w = builder.CreateLearnableParameter(L"W", 5, 3);
+    auto b = builder.CreateLearnableParameter(L"b", 5, 1);
+    auto u = builder.CreateLearnableParameter(L"U", 5, 3);
+    auto h1 = builder.Tanh(builder.Plus(builder.Times(w, x), b), L"h1");
+    auto h2 = builder.Sigmoid(builder.Times(u, x), L"h2");
+    auto h3 = builder.RectifiedLinear(builder.Times(w, builder.Tanh(x)), L"h3");
+    auto o = builder.Plus(builder.Plus(builder.ElementTimes(h1, h2), h3), b, L"o");
+    auto criterion = builder.Sum(builder.ElementTimes(o, o), L"criterion");
+    net.AddToNodeGroup(L"feature", x);
+    net.AddToNodeGroup(L"output", o);
+    net.AddToNodeGroup(L"output", h2);
+    net.AddToNodeGroup(L"criterion", criterion);
+}
+
+BOOST_AUTO_TEST_CASE(InterOpThreadsMatchSequential)
+{
+    const auto minibatches = CreateMinibatches(3);
+
+    ComputationNetwork::SetNumInterOpThreads(1);
+    const auto expected = RunMinibatches(DefineBranches, minibatches, /*training=*/true);
+    const auto expectedEvaluation = RunMinibatches(DefineBranches, minibatches, /*training=*/false);
+    ComputationNetwork::SetNumInterOpThreads(4);
+    auto checkConcurrent = [](const ComputationNetworkPtr& net) { BOOST_CHECK_EQUAL(net->GetNumInterOpThreadsUsed(), 4); };
+    const auto actual = RunMinibatches(DefineBranches, minibatches, /*training=*/true, checkConcurrent);
+    const auto actualEvaluation = RunMinibatches(DefineBranches, minibatches, /*training=*/false, checkConcurrent);
+
+    CheckClose(actual, expected);
+    CheckClose(actualEvaluation, expectedEvaluation);
+}
+
+// reductions over frames that can run concurrently: 's1' and 's2' mask the gaps of the same input, 's3' masks another
+// input with the same layout
+static void DefineSharedReductions(ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+{
+    auto x = builder.CreateInputNode(L"x", 3);
+    auto w = builder.CreateLearnableParameter(L"W", 5, 3);
+    auto u = builder.CreateLearnableParameter(L"U", 5, 3);
+    auto h = builder.Tanh(builder.Times(w, x), L"h");
+    auto s1 = builder.Sum(h, L"s1");
+    auto s2 = builder.Sum(h, L"s2");
+    auto s3 = builder.Sum(builder.Sigmoid(builder.Times(u, x)), L"s3");
+    auto criterion = builder.Plus(builder.Plus(s1, builder.ElementTimes(s2, s2)), s3, L"criterion");
+    net.AddToNodeGroup(L"feature", x);
+    net.AddToNodeGroup(L"output", s1);
+    net.AddToNodeGroup(L"output", s2);
+    net.AddToNodeGroup(L"output", s3);
+    net.AddToNodeGroup(L"criterion", criterion);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentReductionsOfGappedInputMatchSequential)
+{
+    // all minibatches have gaps; repeated, so that a race would have several chances
+    std::vector<std::vector<std::vector<float>>> minibatches;
+    for (size_t i = 0; i < 5; i++)
+    {
+        for (const auto& minibatch : CreateMinibatches(3))
+            minibatches.push_back(minibatch);
+    }
+
+    ComputationNetwork::SetNumInterOpThreads(1);
+    const auto expected = RunMinibatches(DefineSharedReductions, minibatches, /*training=*/true);
+    const auto expectedEvaluation = RunMinibatches(DefineSharedReductions, minibatches, /*training=*/false);
+    ComputationNetwork::SetNumInterOpThreads(4);
+    auto checkConcurrent = [](const ComputationNetworkPtr& net) { BOOST_CHECK_EQUAL(net->GetNumInterOpThreadsUsed(), 4); };
+    const auto actual = RunMinibatches(DefineSharedReductions, minibatches, /*training=*/true, checkConcurrent);
+    const auto actualEvaluation = RunMinibatches(DefineSharedReductions, minibatches, /*training=*/false, checkConcurrent);
+
+    CheckClose(actual, expected);
+    CheckClose(actualEvaluation, expectedEvaluation);
+}
+
+BOOST_AUTO_TEST_CASE(InterOpThreadsRefuseMemorySavingOptions)
+{
+    // with inter-op threads, matrices are not shared, so gradient checkpointing and the compact stash would save nothing
+    ComputationNetwork::SetNumInterOpThreads(4);
+
+    ComputationNetwork::SetRecomputeValues(true);
+    BOOST_CHECK_THROW(PrepareForTraining(CreateTestNetwork<float>(DefineBranches)), std::invalid_argument);
+    ComputationNetwork::SetRecomputeValues(false);
+    ComputationNodeBase::SetCompressActivationStash(true);
+    BOOST_CHECK_THROW(PrepareForTraining(CreateTestNetwork<float>(DefineBranches)), std::invalid_argument);
+    PrepareForEvaluation(CreateTestNetwork<float>(DefineBranches)); // (there is nothing to stash without backprop)
+
+}
+
+// a simple recurrent layer, h(t) = tanh(W x(t) + R h(t-1) + b)
+static void DefineRecurrence(ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+{
+    auto x = builder.CreateInputNode(L"x", 3);
+    auto w = builder.CreateLearnableParameter(L"W", 4, 3);
+    auto r = builder.CreateLearnableParameter(L"R", 4, 4);
+    auto b = builder.CreateLearnableParameter(L"b", 4, 1);
+    auto prev = builder.PastValue(nullptr, 0.1f, 4, 1, L"prev"); // (its input, h, is attached below)
+    auto h = builder.Tanh(builder.Plus(builder.Plus(builder.Times(w, x), builder.Times(r, prev)), b), L"h");
+    prev->AttachInputs({ h });
+    auto criterion = builder.Sum(builder.ElementTimes(h, h), L"criterion");
+    net.AddToNodeGroup(L"feature", x);
+    net.AddToNodeGroup(L"output", h);
+    net.AddToNodeGroup(L"criterion", criterion);
+}
+
+// minibatches as a reader creates them when it sorts the parallel sequences by length (see MBLayout::InitAsPackedSequences()),
+// with one in between that continues a sequence of the previous one, like truncated BPTT does
+static std::vector<MBLayoutPtr> CreateSortedLayouts()
+{
+    auto packed = [](const std::vector<size_t>& lengths)
+    {
+        std::vector<MBLayout::SequenceInfo> sequences;
+        for (size_t i = 0; i < lengths.size(); i++)
+            sequences.push_back(MBLayout::SequenceInfo{ i, 0, 0, lengths[i] });
+        std::vector<std::pair<size_t, size_t>> placement;
+        auto layout = make_shared<MBLayout>();
+        layout->InitAsPackedSequences(sequences, placement, std::vector<size_t>(), /*sortRowsByLength=*/true);
+        return layout;
+    };
+
+    // rows: sequences 0 and 2, sequence 1, sequence 3 and gaps
+    auto first = packed({ 3, 5, 2, 1 });
+    // rows: the last sequence of the first row continued, one that ends early, and one that starts late, so that the only
+    // carried-over frame is computed in a time step that skips the last row
+    auto truncated = make_shared<MBLayout>(3, 4, L"");
+    truncated->AddSequence(2, 0, -2, 4);
+    truncated->AddSequence(10, 1, 0, 3);
+    truncated->AddGap(1, 3, 4);
+    truncated->AddGap(2, 0, 1);
+    truncated->AddSequence(11, 2, 1, 3);
+    truncated->AddGap(2, 3, 4);
+    return { first, truncated, packed({ 4, 4, 2, 7 }) };
+}
+
+BOOST_AUTO_TEST_CASE(ShrunkRecurrentLoopsMatchSequential)
+{
+    // the minibatches have sequences that end early, also above longer ones
+    const auto minibatches = CreateMinibatches(3);
+    const auto sortedLayouts = CreateSortedLayouts();
+
+    ComputationNetwork::SetShrinkRecurrentLoops(false);
+    const auto expected = RunMinibatches(DefineRecurrence, minibatches, /*training=*/true);
+    const auto expectedEvaluation = RunMinibatches(DefineRecurrence, minibatches, /*training=*/false);
+    const auto expectedSorted = RunMinibatches(DefineRecurrence, sortedLayouts, /*training=*/true);
+    const auto expectedSortedEvaluation = RunMinibatches(DefineRecurrence, sortedLayouts, /*training=*/false);
+    ComputationNetwork::SetShrinkRecurrentLoops(true);
+    const auto actual = RunMinibatches(DefineRecurrence, minibatches, /*training=*/true);
+    const auto actualEvaluation = RunMinibatches(DefineRecurrence, minibatches, /*training=*/false);
+    // the (sequence, time step) pairs that the sorted minibatches skip, including the one next to the carried-over frame
+    const std::vector<size_t> numSkipped{ 4, 3, 4 };
+    size_t m = 0;
+    auto checkSkipped = [&](const ComputationNetworkPtr& net) { BOOST_CHECK_EQUAL(net->GetNumSkippedSequenceSteps(), numSkipped[m++ % numSkipped.size()]); };
+    const auto actualSorted = RunMinibatches(DefineRecurrence, sortedLayouts, /*training=*/true, checkSkipped);
+    const auto actualSortedEvaluation = RunMinibatches(DefineRecurrence, sortedLayouts, /*training=*/false, checkSkipped);
+
+    CheckClose(actual, expected);
+    CheckClose(actualEvaluation, expectedEvaluation);
+    CheckClose(actualSorted, expectedSorted);
+    CheckClose(actualSortedEvaluation, expectedSortedEvaluation);
+}
+
+BOOST_AUTO_TEST_CASE(CapturedRecurrentStepsMatchSequential)
+{
+    const auto minibatches = CreateMinibatches(3);
+
+    ComputationNetwork::SetCaptureRecurrentSteps(false);
+    const auto expected = RunMinibatches(DefineRecurrence, minibatches, /*training=*/true);
+    const auto expectedEvaluation = RunMinibatches(DefineRecurrence, minibatches, /*training=*/false);
+    ComputationNetwork::SetCaptureRecurrentSteps(true);
+    auto checkCaptured = [](const ComputationNetworkPtr& net) { BOOST_CHECK_GT(net->GetNumCapturedNodes(), 0); };
+    const auto actual = RunMinibatches(DefineRecurrence, minibatches, /*training=*/true, checkCaptured);
+    const auto actualEvaluation = RunMinibatches(DefineRecurrence, minibatches, /*training=*/false, checkCaptured);
+
+    CheckClose(actual, expected);
+    CheckClose(actualEvaluation, expectedEvaluation);
+}
+
+BOOST_AUTO_TEST_CASE(CapturedRecurrentStepsFollowChangingGeometry)
+{
+    // the geometries of the three minibatches, in an order that drops each of them from a cache of two and brings it back,
+    // followed by a geometry that none of them has
+    const auto created = CreateMinibatches(3);
+    std::vector<std::vector<std::vector<float>>> minibatches;
+    for (size_t m : { 0, 1, 2, 0, 2, 1, 1, 0 })
+        minibatches.push_back(created[m]);
+    minibatches.push_back({ created[1][1] });
+
+    ComputationNetwork::SetCaptureRecurrentSteps(false);
+    const auto expected = RunMinibatches(DefineRecurrence, minibatches, /*training=*/true);
+    const auto expectedEvaluation = RunMinibatches(DefineRecurrence, minibatches, /*training=*/false);
+    ComputationNetwork::SetCaptureRecurrentSteps(true, /*maxNumGeometries=*/2);
+    size_t maxNumCaptured = 0;
+    auto checkCaptured = [&](const ComputationNetworkPtr& net)
+    {
+        BOOST_CHECK_LE(net->GetNumCapturedGeometries(), 2); // (the network has a single loop)
+        maxNumCaptured = std::max(maxNumCaptured, net->GetNumCapturedGeometries());
+    };
+    const auto actual = RunMinibatches(DefineRecurrence, minibatches, /*training=*/true, checkCaptured);
+    const auto actualEvaluation = RunMinibatches(DefineRecurrence, minibatches, /*training=*/false, checkCaptured);
+
+    BOOST_CHECK_EQUAL(maxNumCaptured, 2);
+    CheckClose(actual, expected);
+    CheckClose(actualEvaluation, expectedEvaluation);
+}
+
+// a stack of layers, long enough to be split into several segments for gradient checkpointing
+static void DefineLayerStack(ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+{
+    shared_ptr<ComputationNode<float>> h = builder.CreateInputNode(L"x", 3);
+    size_t dim = 3;
+    for (size_t i = 0; i < 6; i++)
+    {
+        auto w = builder.CreateLearnableParameter(L"W" + std::to_wstring(i), 5, dim);
+        auto b = builder.CreateLearnableParameter(L"b" + std::to_wstring(i), 5, 1);
+        auto z = builder.Plus(builder.Times(w, h), b);
+        h = i % 2 ? builder.Sigmoid(z) : builder.Tanh(z);
+        dim = 5;
+    }
+    auto criterion = builder.Sum(builder.ElementTimes(h, h), L"criterion");
+    net.AddToNodeGroup(L"feature", net.GetNodeFromName(L"x"));
+    net.AddToNodeGroup(L"output", h);
+    net.AddToNodeGroup(L"criterion", criterion);
+}
+
+BOOST_AUTO_TEST_CASE(RecomputedValuesMatchKeptValues)
+{
+    // values are only released after forward prop, and hence recomputed, if matrices are shared
+    const auto minibatches = CreateMinibatches(3);
+    g_shareNodeValueMatrices = true;
+
+    ComputationNetwork::SetRecomputeValues(false);
+    const auto expected = RunMinibatches(DefineLayerStack, minibatches, /*training=*/true);
+    std::vector<MinibatchResults> actual;
+    for (size_t segmentLength : { 0, 2, 3 }) // (0 = default)
+    {
+        ComputationNetwork::SetRecomputeValues(true, segmentLength);
+        actual.push_back(RunMinibatches(DefineLayerStack, minibatches, /*training=*/true,
+                                        [](const ComputationNetworkPtr& net) { BOOST_CHECK_GT(net->GetNumRecomputeSegments(), 0); }));
+    }
+
+    for (const auto& results : actual)
+        CheckClose(results, expected);
+}
+
+// ReLU, max pooling and dropout, each of which can keep a compact stash for backprop, on 4 x 4 x 2 images
+static void DefineStashedActivations(ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+{
+    auto x = builder.CreateInputNode(L"x", TensorShape(4, 4, 2));
+    auto bias = builder.CreateLearnableParameter(L"bias", TensorShape(4, 4, 2));
+    auto w = builder.CreateLearnableParameter(L"W", TensorShape(5, 2, 2, 2));
+    auto b = builder.CreateLearnableParameter(L"b", 5, 1);
+    auto r = builder.RectifiedLinear(builder.Plus(x, bias), L"r");
+    auto p = builder.Pooling(r, PoolKind::Max, TensorShape(2, 2, 1), TensorShape(2, 2, 1), { false }, TensorShape(0), TensorShape(0), ImageLayoutKind::CHW, L"p");
+    auto d = builder.Dropout(p, L"d");
+    dynamic_pointer_cast<DropoutNode<float>>(d)->SetDropoutRate(0.5);
+    dynamic_pointer_cast<DropoutNode<float>>(d)->SetRandomSeed(7); // the same masks in each network
+    auto o = builder.Tanh(builder.Plus(builder.Times(w, d), b), L"o");
+    auto criterion = builder.Sum(builder.ElementTimes(o, o), L"criterion");
+    net.AddToNodeGroup(L"feature", x);
+    net.AddToNodeGroup(L"output", o);
+    net.AddToNodeGroup(L"criterion", criterion);
+}
+
+BOOST_AUTO_TEST_CASE(CompressedActivationStashMatchesFullValues)
+{
+    // the full-precision matrices are only released after forward prop if matrices are shared
+    const auto minibatches = CreateMinibatches(4 * 4 * 2);
+    g_shareNodeValueMatrices = true;
+
+    ComputationNodeBase::SetCompressActivationStash(false);
+    const auto expected = RunMinibatches(DefineStashedActivations, minibatches, /*training=*/true);
+    ComputationNodeBase::SetCompressActivationStash(true);
+    // the ReLU keeps only the signs of its value, and the pooling does not read it, so backprop does not need the value
+    const auto actual = RunMinibatches(DefineStashedActivations, minibatches, /*training=*/true,
+                                       [](const ComputationNetworkPtr& net) { BOOST_CHECK(!net->GetNodeFromName(L"r")->IsOutputNeededDuringBackprop()); });
+
+    // the stash keeps exactly the information that backprop uses, so the results must be identical
+    BOOST_CHECK(actual.outputs == expected.outputs);
+    BOOST_CHECK(actual.gradients == expected.gradients);
+}
+
+// two recurrent layers over the same input in opposite directions, like a bidirectional LSTM
+static void DefineBidirectionalRecurrence(ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+{
+    auto x = builder.CreateInputNode(L"x", 3);
+    auto layer = [&](const std::wstring& name, bool forward)
+    {
+        auto w = builder.CreateLearnableParameter(L"W" + name, 4, 3);
+        auto r = builder.CreateLearnableParameter(L"R" + name, 4, 4);
+        auto prev = forward ? builder.PastValue(nullptr, 0.1f, 4, 1, L"prev" + name) : builder.FutureValue(nullptr, 0.1f, 4, 1, L"prev" + name);
+        auto h = builder.Tanh(builder.Plus(builder.Times(w, x), builder.Times(r, prev)), L"h" + name);
+        prev->AttachInputs({ h });
+        return h;
+    };
+    auto hf = layer(L"f", /*forward=*/true);
+    auto hb = layer(L"b", /*forward=*/false);
+    auto o = builder.Plus(builder.ElementTimes(hf, hf), hb, L"o");
+    auto criterion = builder.Sum(builder.ElementTimes(o, o), L"criterion");
+    net.AddToNodeGroup(L"feature", x);
+    net.AddToNodeGroup(L"output", o);
+    net.AddToNodeGroup(L"criterion", criterion);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentLoopsMatchSequential)
+{
+    const auto minibatches = CreateMinibatches(3);
+
+    ComputationNetwork::SetNumInterOpThreads(1);
+    const auto expected = RunMinibatches(DefineBidirectionalRecurrence, minibatches, /*training=*/true);
+    const auto expectedEvaluation = RunMinibatches(DefineBidirectionalRecurrence, minibatches, /*training=*/false);
+    ComputationNetwork::SetNumInterOpThreads(2);
+    auto checkConcurrent = [](const ComputationNetworkPtr& net) { BOOST_CHECK_EQUAL(net->GetNumInterOpThreadsUsed(), 2); };
+    const auto actual = RunMinibatches(DefineBidirectionalRecurrence, minibatches, /*training=*/true, checkConcurrent);
+    const auto actualEvaluation = RunMinibatches(DefineBidirectionalRecurrence, minibatches, /*training=*/false, checkConcurrent);
+
+    CheckClose(actual, expected);
+    CheckClose(actualEvaluation, expectedEvaluation);
+}
+
+// a gate of elementwise nodes like in an LSTM, with broadcast biases, each of which can be fused
+static void DefineElementwiseGate(ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+{
+    auto x = builder.CreateInputNode(L"x", 3);
+    std::vector<shared_ptr<ComputationNode<float>>> z, b;
+    for (size_t i = 0; i < 3; i++)
+    {
+        z.push_back(builder.Times(builder.CreateLearnableParameter(L"W" + std::to_wstring(i), 4, 3), x));
+        b.push_back(builder.CreateLearnableParameter(L"b" + std::to_wstring(i), 4, 1));
+    }
+    auto gate = builder.Sigmoid(builder.Plus(z[0], b[0]));
+    auto cell = builder.Tanh(builder.Minus(z[1], b[1]));
+    auto o = builder.Plus(builder.ElementTimes(gate, cell), builder.RectifiedLinear(builder.Exp(builder.Plus(z[2], b[2]))), L"o");
+    auto criterion = builder.Sum(builder.ElementTimes(o, o), L"criterion");
+    net.AddToNodeGroup(L"feature", x);
+    net.AddToNodeGroup(L"output", o);
+    net.AddToNodeGroup(L"criterion", criterion);
+}
+
+BOOST_AUTO_TEST_CASE(FusedElementwiseOpsMatchSeparateNodes)
+{
+    // also inside of a recurrent loop
+    const auto minibatches = CreateMinibatches(3);
+    std::vector<MinibatchResults> expected, actual;
+    auto checkFused = [](const ComputationNetworkPtr& net)
+    {
+        auto nodes = net->GetAllNodes();
+        BOOST_CHECK_GT(count_if(nodes.begin(), nodes.end(), [](const ComputationNodeBasePtr& node) { return node->IsFusedIntoConsumer(); }), 0);
+    };
+    for (auto define : { DefineElementwiseGate, DefineRecurrence })
+    {
+        for (bool training : { true, false })
+        {
+            ComputationNetwork::SetFuseElementwiseOps(false);
+            expected.push_back(RunMinibatches(define, minibatches, training));
+            ComputationNetwork::SetFuseElementwiseOps(true);
+            actual.push_back(RunMinibatches(define, minibatches, training, checkFused));
+        }
+    }
+
+    for (size_t i = 0; i < expected.size(); i++)
+        CheckClose(actual[i], expected[i]);
+}
+
+// a layer whose weights are computed from a parameter only, i.e. a static subgraph
+static void DefineStaticSubgraph(ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+{
+    auto x = builder.CreateInputNode(L"x", 3);
+    auto w = builder.CreateLearnableParameter(L"W", 4, 3);
+    auto b = builder.CreateLearnableParameter(L"b", 4, 1);
+    auto s = builder.Tanh(w, L"s");
+    auto o = builder.Plus(builder.Times(s, x), b, L"o");
+    net.AddToNodeGroup(L"feature", x);
+    net.AddToNodeGroup(L"output", o);
+}
+
+BOOST_AUTO_TEST_CASE(CachedStaticSubgraphFollowsParameterChanges)
+{
+    const auto minibatches = CreateMinibatches(3);
+    const auto fileName = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).wstring() + L".dnn";
+
+    // 'cached' keeps the value of s between calls, 'plain' computes everything in every call
+    auto cached = CreateTestNetwork<float>(DefineStaticSubgraph);
+    auto plain = CreateTestNetwork<float>(DefineStaticSubgraph);
+    cached->Save(fileName);
+    PrepareForEvaluation(cached);
+    PrepareForEvaluation(plain);
+    auto evaluate = [&](const ComputationNetworkPtr& net, const std::vector<std::vector<float>>& sequences)
+    {
+        ComputationNetwork::SetCacheStaticSubgraphs(net == cached);
+        net->StartEvaluateMinibatchLoop(net->OutputNodes()); // (like every evaluation call)
+        SetInputSequences(net->GetNodeFromName(L"x"), sequences);
+        return EvaluateValidFrames(net);
+    };
+    auto staticNode = cached->GetNodeFromName(L"s");
+    auto plainStaticNode = plain->GetNodeFromName(L"s");
+
+    // unchanged parameters: s is computed once, while without the cache, it is computed in every call
+    CheckClose(evaluate(cached, minibatches[0]), evaluate(plain, minibatches[0]));
+    const auto timeStamp = staticNode->GetEvalTimeStamp();
+    const auto plainTimeStamp = plainStaticNode->GetEvalTimeStamp();
+    CheckClose(evaluate(cached, minibatches[1]), evaluate(plain, minibatches[1]));
+    BOOST_CHECK_EQUAL(staticNode->GetEvalTimeStamp(), timeStamp);
+    BOOST_CHECK_NE(plainStaticNode->GetEvalTimeStamp(), plainTimeStamp);
+
+    // an update like SGD's, which bumps the parameter's time stamp
+    for (const auto& net : { cached, plain })
+    {
+        auto w = dynamic_pointer_cast<ComputationNode<float>>(net->GetNodeFromName(L"W"));
+        Matrix<float>::Scale(-0.5f, w->Value());
+        w->BumpEvalTimeStamp();
+    }
+    CheckClose(evaluate(cached, minibatches[2]), evaluate(plain, minibatches[2]));
+    const auto updatedTimeStamp = staticNode->GetEvalTimeStamp();
+    BOOST_CHECK_NE(updatedTimeStamp, timeStamp);
+
+    // going back to the saved parameters
+    for (const auto& net : { cached, plain })
+        net->RereadPersistableParameters<float>(fileName);
+    CheckClose(evaluate(cached, minibatches[1]), evaluate(plain, minibatches[1]));
+    BOOST_CHECK_NE(staticNode->GetEvalTimeStamp(), updatedTimeStamp);
+
+    boost::filesystem::remove(fileName);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}}}
@@ -0,0 +1,145 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "Common/NetworkBuilderTestHelper.h"
+#include "ParameterCompression.h"
+#include <boost/filesystem.hpp>
+#include <limits>
+
+using namespace Microsoft::MSR::CNTK;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+BOOST_AUTO_TEST_SUITE(ParameterCompressionTestSuite)
+
+BOOST_AUTO_TEST_CASE(HalfConversion)
+{
+    // normal numbers, signed zero, and the ends of the range
+    BOOST_CHECK_EQUAL(FloatToHalf(1.0f), 0x3c00);
+    BOOST_CHECK_EQUAL(FloatToHalf(-2.0f), 0xc000);
+    BOOST_CHECK_EQUAL(FloatToHalf(0.0f), 0x0000);
+    BOOST_CHECK_EQUAL(FloatToHalf(-0.0f), 0x8000);
+    BOOST_CHECK_EQUAL(FloatToHalf(65504.0f), 0x7bff);   // largest half
+    BOOST_CHECK_EQUAL(FloatToHalf(ldexpf(1, -14)), 0x0400); // smallest normal half
+
+    // subnormals
+    BOOST_CHECK_EQUAL(FloatToHalf(ldexpf(1, -24)), 0x0001);    // smallest subnormal
+    BOOST_CHECK_EQUAL(FloatToHalf(ldexpf(1023, -24)), 0x03ff); // largest subnormal
+    BOOST_CHECK_EQUAL(FloatToHalf(-ldexpf(5, -24)), 0x8005);
+    BOOST_CHECK_EQUAL(FloatToHalf(ldexpf(1, -26)), 0x0000);    // underflow
+    BOOST_CHECK_EQUAL(HalfToFloat(0x0001), ldexpf(1, -24));
+    BOOST_CHECK_EQUAL(HalfToFloat(0x03ff), ldexpf(1023, -24));
+    BOOST_CHECK_EQUAL(HalfToFloat(0x8005), -ldexpf(5, -24));
+
+    // ties round to even, in the normal and the subnormal range, and into Inf
+    BOOST_CHECK_EQUAL(FloatToHalf(1.0f + ldexpf(1, -11)), 0x3c00);
+    BOOST_CHECK_EQUAL(FloatToHalf(1.0f + ldexpf(3, -11)), 0x3c02);
+    BOOST_CHECK_EQUAL(FloatToHalf(1.0f + ldexpf(1, -11) + ldexpf(1, -20)), 0x3c01); // just above the tie
+    BOOST_CHECK_EQUAL(FloatToHalf(ldexpf(1, -25)), 0x0000);
+    BOOST_CHECK_EQUAL(FloatToHalf(ldexpf(3, -25)), 0x0002);
+    BOOST_CHECK_EQUAL(FloatToHalf(ldexpf(2047, -25)), 0x0400); // largest subnormal rounds up to smallest normal
+    BOOST_CHECK_EQUAL(FloatToHalf(65519.0f), 0x7bff);
+    BOOST_CHECK_EQUAL(FloatToHalf(65520.0f), 0x7c00);
+
+    // Inf and NaN
+    const float inf = std::numeric_limits<float>::infinity();
+    BOOST_CHECK_EQUAL(FloatToHalf(inf), 0x7c00);
+    BOOST_CHECK_EQUAL(FloatToHalf(-inf), 0xfc00);
+    BOOST_CHECK_EQUAL(FloatToHalf(1e10f), 0x7c00);
+    BOOST_CHECK_EQUAL(HalfToFloat(0x7c00), inf);
+    BOOST_CHECK_EQUAL(HalfToFloat(0xfc00), -inf);
+    const unsigned short nan = FloatToHalf(std::numeric_limits<float>::quiet_NaN());
+    BOOST_CHECK_EQUAL(nan & 0x7c00, 0x7c00);
+    BOOST_CHECK_NE(nan & 0x03ff, 0);
+    BOOST_CHECK(std::isnan(HalfToFloat(nan)));
+
+    // every half value survives the round trip through float
+    for (unsigned int h = 0; h < 0x10000; h++)
+    {
+        const float f = HalfToFloat((unsigned short)h);
+        if ((h & 0x7c00) == 0x7c00 && (h & 0x03ff) != 0)
+            BOOST_CHECK(std::isnan(f));
+        else if (FloatToHalf(f) != h)
+            BOOST_ERROR("half value " << h << " changed in the round trip");
+    }
+}
+
+static void DefineCompressionNetwork(ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+{
+    auto x = builder.CreateInputNode(L"x", 6);
+    auto w = builder.CreateLearnableParameter(L"W", 20, 6);
+    auto b = builder.CreateLearnableParameter(L"b", 20, 1);
+    auto o = builder.Sigmoid(builder.Plus(builder.Times(w, x), b), L"o");
+    net.AddToNodeGroup(L"feature", x);
+    net.AddToNodeGroup(L"output", o);
+}
+
+static Matrix<float>& ParameterValue(const ComputationNetworkPtr& net, const std::wstring& name)
+{
+    return dynamic_pointer_cast<ComputationNode<float>>(net->GetNodeFromName(name))->Value();
+}
+
+static ComputationNetworkPtr SaveAndLoadCompressed(const ComputationNetworkPtr& net, ParameterCompression compression)
+{
+    const auto fileName = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).wstring() + L".dnn";
+    net->SaveCompressed(fileName, compression);
+    auto loaded = make_shared<ComputationNetwork>(CPUDEVICE);
+    loaded->Load<float>(fileName);
+
+    // reloading the parameters only gives the same values
+    auto reloaded = make_shared<ComputationNetwork>(CPUDEVICE);
+    reloaded->Load<float>(fileName);
+    reloaded->RandomInitLearnableParameters(reloaded->GetNodeFromName(L"W"), /*uniformInit=*/true, /*randomSeed=*/99, /*initValueScale=*/1.0, /*initOnCPUOnly=*/true);
+    reloaded->RereadPersistableParameters<float>(fileName);
+    BOOST_CHECK(CopyToVector(ParameterValue(reloaded, L"W")) == CopyToVector(ParameterValue(loaded, L"W")));
+    BOOST_CHECK(CopyToVector(ParameterValue(reloaded, L"b")) == CopyToVector(ParameterValue(loaded, L"b")));
+
+    boost::filesystem::remove(fileName);
+    return loaded;
+}
+
+BOOST_AUTO_TEST_CASE(CompressedModelRoundTrip)
+{
+    auto net = CreateTestNetwork<float>(DefineCompressionNetwork);
+
+    // columns with very different ranges, including a constant one
+    auto& w = ParameterValue(net, L"W");
+    std::vector<float> values(w.GetNumElements());
+    const size_t numRows = w.GetNumRows(), numCols = w.GetNumCols();
+    for (size_t j = 0; j < numCols; j++)
+        for (size_t i = 0; i < numRows; i++)
+            values[j * numRows + i] = j == 2 ? 0.25f : (float)(ldexp(1.0, 2 * (int)j - 5) * sin(1.0 + i * (j + 1)));
+    w.SetValue(numRows, numCols, w.GetDeviceId(), values.data());
+    const auto b = CopyToVector(ParameterValue(net, L"b"));
+
+    // int8: the error of each element is bounded by the quantization step of its column
+    {
+        auto loaded = SaveAndLoadCompressed(net, ParameterCompression::int8);
+        const auto actual = CopyToVector(ParameterValue(loaded, L"W"));
+        BOOST_REQUIRE_EQUAL(actual.size(), values.size());
+        for (size_t j = 0; j < numCols; j++)
+        {
+            const float* col = values.data() + j * numRows;
+            const float lower = *std::min_element(col, col + numRows);
+            const float upper = *std::max_element(col, col + numRows);
+            const double maxError = (upper - lower) / 255.0 + 1e-6 * std::max(fabs(lower), fabs(upper));
+            for (size_t i = 0; i < numRows; i++)
+                BOOST_CHECK_SMALL((double)actual[j * numRows + i] - col[i], maxError);
+        }
+        // vectors are stored as fp16 instead
+        CheckClose(CopyToVector(ParameterValue(loaded, L"b")), b, ldexp(1.0, -11));
+    }
+
+    // fp16: the relative error is bounded by half a unit in the last place
+    {
+        auto loaded = SaveAndLoadCompressed(net, ParameterCompression::fp16);
+        CheckClose(CopyToVector(ParameterValue(loaded, L"W")), values, ldexp(1.0, -11));
+        CheckClose(CopyToVector(ParameterValue(loaded, L"b")), b, ldexp(1.0, -11));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}}}
@@ -0,0 +1,165 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "Common/NetworkBuilderTestHelper.h"
+#include "FrameStore.h"
+
+using namespace Microsoft::MSR::CNTK;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+BOOST_AUTO_TEST_SUITE(ReshapingNodeTestSuite)
+
+// Reference for ContextWindowNode: the expansion that HTKDataDeserializer does in the reader (AugmentNeighbors()).
+// Output frame t stacks the input frames t-left..t+right, frames beyond the sequence boundary are replaced by the first/last frame.
+static std::vector<float> ExpandLikeReader(const std::vector<float>& frames, size_t dim, size_t left, size_t right)
+{
+    size_t numFrames = frames.size() / dim;
+    size_t numContextFrames = left + 1 + right;
+    std::vector<float> expanded(numFrames * numContextFrames * dim);
+    for (size_t t = 0; t < numFrames; t++)
+    {
+        for (size_t k = 0; k < numContextFrames; k++)
+        {
+            ptrdiff_t source = min(max((ptrdiff_t)(t + k) - (ptrdiff_t)left, (ptrdiff_t)0), (ptrdiff_t)numFrames - 1);
+            memcpy(&expanded[(t * numContextFrames + k) * dim], &frames[source * dim], dim * sizeof(float));
+        }
+    }
+    return expanded;
+}
+
+BOOST_AUTO_TEST_CASE(ContextWindowMatchesReaderExpansion)
+{
+    const size_t dim = 2, left = 2, right = 1, numContextFrames = left + 1 + right, outputDim = 3;
+
+    // h = P x is there so that the gradient that ContextWindow passes back to its input shows up in a parameter gradient.
+    auto net = CreateTestNetwork<float>([=](ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+    {
+        auto x = builder.CreateInputNode(L"x", dim);
+        auto p = builder.CreateLearnableParameter(L"P", dim, dim);
+        auto w = builder.CreateLearnableParameter(L"W", outputDim, dim * numContextFrames);
+        auto c = builder.ContextWindow(builder.Times(p, x), left, right, /*frameDim=*/0, L"c");
+        auto criterion = builder.Sum(builder.Times(w, c), L"criterion");
+        net.AddToNodeGroup(L"feature", x);
+        net.AddToNodeGroup(L"output", c);
+        net.AddToNodeGroup(L"criterion", criterion);
+    });
+    PrepareForTraining(net);
+
+    // sequences of different lengths, including one that is shorter than the context window
+    std::vector<std::vector<float>> sequences{
+        { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 },
+        { -1, 0.5f, 2, -3, 0.25f, 4 },
+        { 7, -7 } };
+    SetInputSequences(net->GetNodeFromName(L"x"), sequences);
+    auto gradients = ComputeGradients<float>(net);
+
+    auto pValue = GetValue<float>(net->GetNodeFromName(L"P"));
+    auto wValue = GetValue<float>(net->GetNodeFromName(L"W"));
+    auto cValue = GetValue<float>(net->GetNodeFromName(L"c"));
+
+    // forward: each valid column of c must be the reader's expansion of h = P x
+    size_t numSequences = sequences.size();
+    std::vector<float> gradientOfP(dim * dim, 0);
+    for (size_t s = 0; s < numSequences; s++)
+    {
+        size_t numFrames = sequences[s].size() / dim;
+        std::vector<float> h(numFrames * dim, 0);
+        for (size_t t = 0; t < numFrames; t++)
+            for (size_t i = 0; i < dim; i++)
+                for (size_t l = 0; l < dim; l++)
+                    h[t * dim + i] += pValue[l * dim + i] * sequences[s][t * dim + l];
+
+        auto expected = ExpandLikeReader(h, dim, left, right);
+        for (size_t t = 0; t < numFrames; t++)
+        {
+            size_t column = t * numSequences + s;
+            std::vector<float> actual(cValue.begin() + column * dim * numContextFrames, cValue.begin() + (column + 1) * dim * numContextFrames);
+            std::vector<float> reference(expected.begin() + t * dim * numContextFrames, expected.begin() + (t + 1) * dim * numContextFrames);
+            CheckClose(actual, reference);
+        }
+
+        // backward: the gradient of every output frame is W' * 1; each context position adds its part to the frame it was copied from
+        std::vector<float> gradientOfH(numFrames * dim, 0);
+        for (size_t t = 0; t < numFrames; t++)
+        {
+            for (size_t k = 0; k < numContextFrames; k++)
+            {
+                ptrdiff_t source = min(max((ptrdiff_t)(t + k) - (ptrdiff_t)left, (ptrdiff_t)0), (ptrdiff_t)numFrames - 1);
+                for (size_t i = 0; i < dim; i++)
+                    for (size_t r = 0; r < outputDim; r++)
+                        gradientOfH[source * dim + i] += wValue[(k * dim + i) * outputDim + r];
+            }
+        }
+        for (size_t t = 0; t < numFrames; t++)
+            for (size_t i = 0; i < dim; i++)
+                for (size_t l = 0; l < dim; l++)
+                    gradientOfP[l * dim + i] += gradientOfH[t * dim + i] * sequences[s][t * dim + l];
+    }
+    CheckClose(gradients[L"P"], gradientOfP);
+}
+
+// In frame mode, the reader delivers frame locations and publishes the frames of its chunks in a FrameStore.
+BOOST_AUTO_TEST_CASE(ContextWindowGathersFromFrameStore)
+{
+    const size_t dim = 2, left = 2, right = 1, numContextFrames = left + 1 + right;
+
+    auto net = CreateTestNetwork<float>([=](ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+    {
+        auto x = builder.CreateInputNode(L"x", FrameLocation::dim);
+        auto c = builder.ContextWindow(x, left, right, dim, L"c");
+        net.AddToNodeGroup(L"feature", x);
+        net.AddToNodeGroup(L"output", c);
+    });
+    PrepareForEvaluation(net);
+
+    // chunk 3 holds utterances of 4 and 3 frames, chunk 5 one of 5 frames
+    auto store = FrameStore::Create();
+    std::map<size_t, std::vector<size_t>> utteranceLengths{ { 3, { 4, 3 } }, { 5, { 5 } } };
+    for (const auto& lengths : utteranceLengths)
+    {
+        auto chunk = std::make_shared<FrameStoreChunk>();
+        chunk->frameDim = dim;
+        chunk->numFrames = 0;
+        for (auto length : lengths.second)
+            chunk->numFrames += length;
+        for (size_t i = 0; i < chunk->numFrames * dim; i++)
+            chunk->frames.push_back(100.0f * lengths.first + i);
+        store->AddChunk(lengths.first, chunk);
+    }
+
+    // frames in random order, from both chunks, including the first and last frames of the utterances
+    struct Frame { size_t chunkId, frame, utteranceBegin, utteranceEnd; };
+    std::vector<Frame> frames{ { 3, 4, 4, 7 }, { 5, 0, 0, 5 }, { 3, 3, 0, 4 }, { 5, 4, 0, 5 }, { 3, 0, 0, 4 }, { 3, 6, 4, 7 }, { 5, 2, 0, 5 } };
+    auto checkFrames = [&]()
+    {
+        std::vector<std::vector<float>> locations;
+        for (const auto& frame : frames)
+            locations.push_back({ (float)store->GetId(), (float)frame.chunkId, (float)frame.frame, (float)frame.utteranceBegin, (float)frame.utteranceEnd });
+        SetInputSequences(net->GetNodeFromName(L"x"), locations);
+        auto cValue = Evaluate<float>(net)[0];
+
+        for (size_t j = 0; j < frames.size(); j++)
+        {
+            const auto& frame = frames[j];
+            auto chunk = store->GetChunk(frame.chunkId);
+            std::vector<float> utterance(chunk->frames.begin() + frame.utteranceBegin * dim, chunk->frames.begin() + frame.utteranceEnd * dim);
+            auto expected = ExpandLikeReader(utterance, dim, left, right);
+            size_t t = frame.frame - frame.utteranceBegin;
+            std::vector<float> actual(cValue.begin() + j * dim * numContextFrames, cValue.begin() + (j + 1) * dim * numContextFrames);
+            std::vector<float> reference(expected.begin() + t * dim * numContextFrames, expected.begin() + (t + 1) * dim * numContextFrames);
+            CheckClose(actual, reference);
+        }
+    };
+    checkFrames();
+
+    // a chunk that the reader has just released may still be used by minibatches that it has delivered
+    store->RemoveChunk(3);
+    checkFrames();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}}}
@@ -0,0 +1,228 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "Common/NetworkBuilderTestHelper.h"
+#include "SGD.h"
+#include <boost/filesystem.hpp>
+
+using namespace Microsoft::MSR::CNTK;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// gives the tests access to the checkpointing of SGD, without running a training
+class CheckpointTestSGD : public SGD<float>
+{
+public:
+    CheckpointTestSGD(const ConfigParameters& config)
+        : SGD<float>(config)
+    {
+    }
+
+    using SGD<float>::SaveCheckPoint;
+    using SGD<float>::LoadCheckPointInfo;
+    using SGD<float>::WaitForCheckpoint;
+    using SGD<float>::NoteCheckpointWritten;
+    using SGD<float>::m_checkpointPending;
+    using SGD<float>::DeleteCheckPointFile;
+    using SGD<float>::GetCheckPointFileNameForEpoch;
+};
+
+struct CheckpointFixture
+{
+    CheckpointFixture()
+        : m_directory(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+    {
+        boost::filesystem::create_directories(m_directory);
+    }
+
+    ~CheckpointFixture()
+    {
+        boost::filesystem::remove_all(m_directory);
+    }
+
+    ConfigParameters Config(const std::string& options, const std::string& modelName = "model.dnn") const
+    {
+        ConfigParameters config;
+        config.Parse("modelPath=\"" + (m_directory / modelName).string() + "\"\n"
+                     "maxEpochs=10\n"
+                     "learningRatesPerSample=0.01\n"
+                     "minibatchSize=2\n"
+                     "keepCheckPointFiles=false\n" +
+                     options);
+        return config;
+    }
+
+    boost::filesystem::path m_directory;
+};
+
+static void DefineCheckpointNetwork(ComputationNetworkBuilder<float>& builder, ComputationNetwork& net)
+{
+    auto x = builder.CreateInputNode(L"x", 3);
+    auto w = builder.CreateLearnableParameter(L"W", 4, 3);
+    auto b = builder.CreateLearnableParameter(L"b", 4, 1);
+    auto o = builder.Tanh(builder.Plus(builder.Times(w, x), b), L"o");
+    net.AddToNodeGroup(L"feature", x);
+    net.AddToNodeGroup(L"output", o);
+}
+
+// one smoothed gradient per parameter, like SGD keeps them
+static std::list<Matrix<float>> CreateSmoothedGradients(const ComputationNetworkPtr& net)
+{
+    std::list<Matrix<float>> smoothedGradients;
+    for (const auto& name : { L"W", L"b" })
+    {
+        const auto& value = dynamic_pointer_cast<ComputationNode<float>>(net->GetNodeFromName(name))->Value();
+        smoothedGradients.emplace_back(value.GetNumRows(), value.GetNumCols(), CPUDEVICE);
+        smoothedGradients.back().SetValue(0);
+    }
+    return smoothedGradients;
+}
+
+BOOST_FIXTURE_TEST_SUITE(SGDCheckpointTestSuite, CheckpointFixture)
+
+BOOST_AUTO_TEST_CASE(AsyncCheckpointAlwaysLeavesCompleteCheckpoint)
+{
+    CheckpointTestSGD sgd(Config("asyncCheckpointing=true\n"));
+    auto net = CreateTestNetwork<float>(DefineCheckpointNetwork);
+    auto smoothedGradients = CreateSmoothedGradients(net);
+    std::vector<double> smoothedCounts(smoothedGradients.size(), 0);
+
+    const int numEpochs = 4;
+    for (int epoch = 0; epoch < numEpochs; epoch++)
+    {
+        for (auto& smoothedGradient : smoothedGradients)
+            smoothedGradient.SetValue((float)(epoch + 1));
+        sgd.SaveCheckPoint(net, sgd.GetModelNameForEpoch(epoch), epoch, /*totalSamplesSeen=*/(epoch + 1) * 100, /*learnRatePerSample=*/0.01,
+                           smoothedGradients, smoothedCounts, /*prevCriterion=*/1.0, /*minibatchSize=*/2);
+        if (epoch > 0)
+        {
+            // what training does after each epoch; the previous file must stay until the new one is complete
+            sgd.DeleteCheckPointFile(epoch - 1);
+            BOOST_CHECK(boost::filesystem::exists(sgd.GetCheckPointFileNameForEpoch(epoch)) ||
+                        boost::filesystem::exists(sgd.GetCheckPointFileNameForEpoch(epoch - 1)));
+        }
+    }
+    sgd.WaitForCheckpoint();
+
+    for (int epoch = 0; epoch + 1 < numEpochs; epoch++)
+        BOOST_CHECK(!boost::filesystem::exists(sgd.GetCheckPointFileNameForEpoch(epoch)));
+    BOOST_REQUIRE(boost::filesystem::exists(sgd.GetCheckPointFileNameForEpoch(numEpochs - 1)));
+    BOOST_CHECK(!boost::filesystem::exists(sgd.GetCheckPointFileNameForEpoch(numEpochs - 1) + L".tmp"));
+
+    size_t totalSamplesSeen, minibatchSize;
+    double learnRatePerSample, prevCriterion;
+    auto loadedGradients = CreateSmoothedGradients(net);
+    sgd.LoadCheckPointInfo(numEpochs - 1, totalSamplesSeen, learnRatePerSample, loadedGradients, smoothedCounts, prevCriterion, minibatchSize);
+    BOOST_CHECK_EQUAL(totalSamplesSeen, numEpochs * 100);
+    BOOST_CHECK_EQUAL(minibatchSize, 2);
+    for (const auto& loadedGradient : loadedGradients)
+        CheckClose(CopyToVector(loadedGradient), std::vector<float>(loadedGradient.GetNumElements(), (float)numEpochs));
+}
+
+static std::map<std::wstring, std::vector<float>> GetParameterValues(const ComputationNetworkPtr& net)
+{
+    std::map<std::wstring, std::vector<float>> values;
+    for (const auto& name : { L"W", L"b" })
+        values[name] = GetValue<float>(net->GetNodeFromName(name));
+    return values;
+}
+
+BOOST_AUTO_TEST_CASE(DeltaCheckpointChainMatchesFullCheckpoint)
+{
+    // the same epochs are checkpointed twice, as a delta chain and in full
+    CheckpointTestSGD deltaSGD(Config("deltaCheckpoints=true\nasyncCheckpointing=true\nkeepCheckPointFiles=true\n", "delta.dnn"));
+    CheckpointTestSGD fullSGD(Config("keepCheckPointFiles=true\n", "full.dnn"));
+    auto net = CreateTestNetwork<float>(DefineCheckpointNetwork);
+    auto smoothedGradients = CreateSmoothedGradients(net);
+    std::vector<double> smoothedCounts(smoothedGradients.size(), 0);
+
+    auto& w = dynamic_pointer_cast<ComputationNode<float>>(net->GetNodeFromName(L"W"))->Value();
+    auto& b = dynamic_pointer_cast<ComputationNode<float>>(net->GetNodeFromName(L"b"))->Value();
+    const int numEpochs = 4;
+    for (int epoch = 0; epoch < numEpochs; epoch++)
+    {
+        // like an embedding, an epoch only updates some of the columns of W
+        if (epoch > 0)
+            w.ColumnSlice(epoch % w.GetNumCols(), 1).SetValue((float)epoch);
+        b.SetValue((float)-epoch);
+        for (auto& smoothedGradient : smoothedGradients)
+            smoothedGradient.SetValue((float)(epoch + 1));
+        for (auto sgd : { &deltaSGD, &fullSGD })
+        {
+            sgd->SaveCheckPoint(net, sgd->GetModelNameForEpoch(epoch), epoch, /*totalSamplesSeen=*/(epoch + 1) * 100, /*learnRatePerSample=*/0.01,
+                                smoothedGradients, smoothedCounts, /*prevCriterion=*/1.0, /*minibatchSize=*/2);
+        }
+    }
+    deltaSGD.WaitForCheckpoint();
+    const auto expected = GetParameterValues(net);
+
+    const auto deltaModel = deltaSGD.GetModelNameForEpoch(numEpochs - 1);
+    const auto fullModel = fullSGD.GetModelNameForEpoch(numEpochs - 1);
+    BOOST_CHECK_LT(boost::filesystem::file_size(deltaModel), boost::filesystem::file_size(fullModel));
+
+    // Read() replays the chain of base models
+    auto loadedFromDelta = make_shared<ComputationNetwork>(CPUDEVICE);
+    loadedFromDelta->Load<float>(deltaModel);
+    auto loadedFromFull = make_shared<ComputationNetwork>(CPUDEVICE);
+    loadedFromFull->Load<float>(fullModel);
+    CheckClose(GetParameterValues(loadedFromDelta), GetParameterValues(loadedFromFull));
+    CheckClose(GetParameterValues(loadedFromDelta), expected);
+
+    // so does RereadPersistableParameters(), which SGD uses to go back to an earlier model
+    loadedFromFull->RandomInitLearnableParameters(loadedFromFull->GetNodeFromName(L"W"), /*uniformInit=*/true, /*randomSeed=*/99, /*initValueScale=*/1.0, /*initOnCPUOnly=*/true);
+    loadedFromFull->RereadPersistableParameters<float>(deltaModel);
+    CheckClose(GetParameterValues(loadedFromFull), expected);
+
+    // the checkpoint info of a delta checkpoint is complete by itself
+    for (auto sgd : { &deltaSGD, &fullSGD })
+    {
+        size_t totalSamplesSeen, minibatchSize;
+        double learnRatePerSample, prevCriterion;
+        auto loadedGradients = CreateSmoothedGradients(net);
+        sgd->LoadCheckPointInfo(numEpochs - 1, totalSamplesSeen, learnRatePerSample, loadedGradients, smoothedCounts, prevCriterion, minibatchSize);
+        BOOST_CHECK_EQUAL(totalSamplesSeen, numEpochs * 100);
+        auto smoothedGradient = smoothedGradients.begin();
+        for (const auto& loadedGradient : loadedGradients)
+            CheckClose(CopyToVector(loadedGradient), CopyToVector(*smoothedGradient++));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PendingCheckpointAgreesAcrossRanks)
+{
+    // 'mainNode' writes the checkpoints, full and delta ones, and 'otherNode' does what the other ranks do after each epoch;
+    // both must agree on whether WaitForCheckpoint() enters the barrier (there is no MPI here, so it is not entered)
+    const auto options = "deltaCheckpoints=true\nasyncCheckpointing=true\nfullCheckpointInterval=3\nkeepCheckPointFiles=true\n";
+    CheckpointTestSGD mainNode(Config(options));
+    CheckpointTestSGD otherNode(Config(options));
+    auto net = CreateTestNetwork<float>(DefineCheckpointNetwork);
+    auto smoothedGradients = CreateSmoothedGradients(net);
+    std::vector<double> smoothedCounts(smoothedGradients.size(), 0);
+
+    const int numEpochs = 7; // full, delta, delta, full, delta, delta, full
+    for (int epoch = 0; epoch < numEpochs; epoch++)
+    {
+        mainNode.SaveCheckPoint(net, mainNode.GetModelNameForEpoch(epoch), epoch, /*totalSamplesSeen=*/(epoch + 1) * 100, /*learnRatePerSample=*/0.01,
+                                smoothedGradients, smoothedCounts, /*prevCriterion=*/1.0, /*minibatchSize=*/2);
+        otherNode.NoteCheckpointWritten();
+        BOOST_CHECK(mainNode.m_checkpointPending);
+        BOOST_CHECK_EQUAL(mainNode.m_checkpointPending, otherNode.m_checkpointPending);
+
+        // like a rollback or a learning-rate search, after some of the epochs
+        if (epoch % 2 == 1)
+        {
+            mainNode.WaitForCheckpoint();
+            otherNode.WaitForCheckpoint();
+            BOOST_CHECK(!mainNode.m_checkpointPending);
+            BOOST_CHECK(!otherNode.m_checkpointPending);
+        }
+    }
+    mainNode.WaitForCheckpoint();
+    otherNode.WaitForCheckpoint();
+    BOOST_CHECK_EQUAL(mainNode.m_checkpointPending, otherNode.m_checkpointPending);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}}}
@@ -102,6 +102,30 @@ BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_Simple_dense)
 };
 
 
+// Same as CNTKTextFormatReader_Simple_dense, but the shim reads several minibatches ahead;
+// the minibatches must arrive in the same order with the same content.
+BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_Simple_dense_PrefetchDepth)
+{
+    HelperRunReaderTest<float>(
+        testDataPath() + "/Config/CNTKTextFormatReader/dense.cntk",
+        testDataPath() + "/Control/CNTKTextFormatReader/Simple_dense.txt",
+        testDataPath() + "/Control/CNTKTextFormatReader/Simple_dense_PrefetchDepth_Output.txt",
+        "Simple",
+        "reader",
+        1000, // epoch size
+        250,  // mb size
+        10,   // num epochs
+        1,
+        1,
+        0,
+        1,
+        false,
+        false,
+        true,
+        { L"Simple=[reader=[prefetchDepth=3]]" });
+};
+
+
 BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_MNIST_dense)
 {
     HelperRunReaderTest<double>(
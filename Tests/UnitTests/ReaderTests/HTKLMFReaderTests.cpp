@@ -399,6 +399,74 @@ BOOST_AUTO_TEST_CASE(HTKDeserializersSimpleDataLoop1)
         true);
 };
 
+// Same as HTKDeserializersSimpleDataLoop1, but chunks are paged in by several concurrent readers.
+// The output must be identical to the serial read.
+BOOST_AUTO_TEST_CASE(HTKDeserializersChunkReadThreads)
+{
+    HelperRunReaderTest<float>(
+        testDataPath() + "/Config/HTKDeserializersChunkReadThreads_Config.cntk",
+        testDataPath() + "/Control/HTKMLFReaderSimpleDataLoop1_5_11_Control.txt",
+        testDataPath() + "/Control/HTKDeserializersChunkReadThreads_Output.txt",
+        "Simple_Test",
+        "reader",
+        500,
+        250,
+        2,
+        1,
+        1,
+        0,
+        1,
+        false,
+        false,
+        true,
+        {},
+        true);
+};
+
+// Same as HTKDeserializersSimpleDataLoop1, with the labels taken from the MLF cache:
+// the first run parses the MLF and writes the cache, the second reads the labels from the cache,
+// the third finds a truncated cache and falls back to parsing. All runs must give the same labels.
+BOOST_AUTO_TEST_CASE(HTKDeserializersMlfCache)
+{
+    const string cacheFile = testDataPath() + "/Control/HTKDeserializersMlfCache.bin";
+    boost::filesystem::remove(cacheFile);
+
+    auto test = [&]()
+    {
+        HelperRunReaderTest<float>(
+            testDataPath() + "/Config/HTKDeserializersSimpleDataLoop1_Config.cntk",
+            testDataPath() + "/Control/HTKMLFReaderSimpleDataLoop1_5_11_Control.txt",
+            testDataPath() + "/Control/HTKDeserializersMlfCache_Output.txt",
+            "Simple_Test",
+            "reader",
+            500,
+            250,
+            2,
+            1,
+            1,
+            0,
+            1,
+            false,
+            false,
+            true,
+            { L"Simple_Test=[reader=[labels=[mlfCacheFile=" + wstring(cacheFile.begin(), cacheFile.end()) + L"]]]" },
+            true);
+    };
+
+    test();
+    BOOST_REQUIRE(boost::filesystem::exists(cacheFile));
+    auto cacheSize = boost::filesystem::file_size(cacheFile);
+
+    test();
+    BOOST_REQUIRE_EQUAL(boost::filesystem::file_size(cacheFile), cacheSize);
+
+    boost::filesystem::resize_file(cacheFile, cacheSize / 2);
+    test();
+    BOOST_REQUIRE_EQUAL(boost::filesystem::file_size(cacheFile), cacheSize);
+
+    boost::filesystem::remove(cacheFile);
+};
+
 BOOST_AUTO_TEST_CASE(HTKDeserializersSimpleDataLoop5)
 {
     HelperRunReaderTest<float>(
@@ -70,6 +70,38 @@ BOOST_AUTO_TEST_CASE(ImageAndImageReaderSimple)
         1);
 }
 
+// Transforms of both image streams run serially and on the OpenMP pool;
+// minibatch order and content must be the same.
+BOOST_AUTO_TEST_CASE(ImageAndImageReaderSerialAndParallelTransforms)
+{
+    auto test = [this](const string& outputFile, bool multithreadedTransforms)
+    {
+        HelperRunReaderTest<float>(
+            testDataPath() + "/Config/ImageAndImageReaderSimple_Config.cntk",
+            testDataPath() + "/Control/ImageAndImageReaderSimple_Control.txt",
+            outputFile,
+            "Simple_Test",
+            "reader",
+            4,
+            4,
+            1,
+            2,
+            2,
+            0,
+            1,
+            false,
+            false,
+            true,
+            { multithreadedTransforms ? L"Simple_Test=[reader=[multithreadedTransforms=true]]" : L"Simple_Test=[reader=[multithreadedTransforms=false]]" });
+    };
+
+    const string serialOutput = testDataPath() + "/Control/ImageAndImageReaderSerialTransforms_Output.txt";
+    const string parallelOutput = testDataPath() + "/Control/ImageAndImageReaderParallelTransforms_Output.txt";
+    test(serialOutput, false);
+    test(parallelOutput, true);
+    CheckFilesEquivalent(serialOutput, parallelOutput);
+}
+
 BOOST_AUTO_TEST_CASE(ImageReaderBadMap)
 {
     BOOST_REQUIRE_EXCEPTION(